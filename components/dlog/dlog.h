@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+// Deferred binary log with one lock-free ring per core
+//
+// DLOG(tag, format, ...) stores the addresses of tag and format and the raw arguments, nothing is formatted
+// on the device. The strings stay in the flash image, host/dlogdec looks them up in the firmware ELF and
+// formats the records with the host printf. A record is 64 bytes, arguments are widened to 64 bits:
+// doubles keep their bits, integers are sign extended and %s must point to a constant string.
+// A dump is the binary below, on the console as hex lines between "----- dlog -----" and "----- end -----":
+//
+//      dlog_header | per core: count (u32) | count * dlog_record, oldest first
+//
+// All integers are little endian.
+
+#define DLOG_MAGIC "CPDL"
+#define DLOG_VERSION 1
+#define DLOG_RING_RECORDS 128           //per core, power of two
+#define DLOG_MAX_CORES 2
+#define DLOG_MAX_ARGS 6
+#ifndef DLOG_ENABLED
+#define DLOG_ENABLED 1                  //0 removes all DLOG calls at compile time
+#endif
+
+typedef struct __attribute__((packed)) {
+    uint32_t time_us;                   // low 32 bits of esp_timer
+    uint32_t tag;                       // address of the tag string
+    uint32_t format;                    // address of the format string
+    uint8_t core;
+    uint8_t nargs;
+    uint16_t reserved;
+    uint64_t args[DLOG_MAX_ARGS];
+} dlog_record;
+
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint8_t version;
+    uint8_t cores;
+    uint16_t record_size;
+    uint32_t ring_records;
+} dlog_header;
+
+typedef void (*dlog_writer)(const void *data, size_t len, void *ctx);
+
+static inline uint64_t dlog_arg_double(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+static inline uint64_t dlog_arg_int(long long value) {
+    return (uint64_t)value;
+}
+static inline uint64_t dlog_arg_unsigned(unsigned long long value) {
+    return value;
+}
+static inline uint64_t dlog_arg_ptr(const void *value) {
+    return (uintptr_t)value;
+}
+
+#define DLOG_ARG(x) _Generic((x), \
+    float: dlog_arg_double, double: dlog_arg_double, \
+    unsigned long long: dlog_arg_unsigned, \
+    char *: dlog_arg_ptr, const char *: dlog_arg_ptr, void *: dlog_arg_ptr, const void *: dlog_arg_ptr, \
+    default: dlog_arg_int)(x)
+
+#define DLOG_A0()
+#define DLOG_A1(a) DLOG_ARG(a)
+#define DLOG_A2(a, ...) DLOG_ARG(a), DLOG_A1(__VA_ARGS__)
+#define DLOG_A3(a, ...) DLOG_ARG(a), DLOG_A2(__VA_ARGS__)
+#define DLOG_A4(a, ...) DLOG_ARG(a), DLOG_A3(__VA_ARGS__)
+#define DLOG_A5(a, ...) DLOG_ARG(a), DLOG_A4(__VA_ARGS__)
+#define DLOG_A6(a, ...) DLOG_ARG(a), DLOG_A5(__VA_ARGS__)
+#define DLOG_SELECT(_0, _1, _2, _3, _4, _5, _6, N, ...) N
+#define DLOG_ARGS(...) DLOG_SELECT(_0, ##__VA_ARGS__, DLOG_A6, DLOG_A5, DLOG_A4, DLOG_A3, DLOG_A2, DLOG_A1, DLOG_A0)(__VA_ARGS__)
+#define DLOG_NARGS(...) DLOG_SELECT(_0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+
+// Records a log line in a few dozen cycles, the format must be a string literal
+#define DLOG(tag, format, ...) do { \
+    if (DLOG_ENABLED) { \
+        dlog_write(tag, format, DLOG_NARGS(__VA_ARGS__), (const uint64_t[DLOG_MAX_ARGS + 1]){0, DLOG_ARGS(__VA_ARGS__)} + 1); \
+    } \
+} while (0)
+
+void dlog_init(void);
+void dlog_start(void);
+void dlog_stop(void);
+bool dlog_enabled(void);
+
+// Safe from any task and from ISRs, never blocks
+void dlog_write(const char *tag, const char *format, uint8_t nargs, const uint64_t *args);
+
+// Writes the dump, logging is paused meanwhile
+void dlog_serialize(dlog_writer write, void *ctx);
+// Prints the dump on the console
+void dlog_dump(void);
@@ -0,0 +1,78 @@
+#include "dlog.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "trace_ring.h"
+
+static DRAM_ATTR dlog_record records[DLOG_MAX_CORES][DLOG_RING_RECORDS];
+static DRAM_ATTR trace_ring rings[DLOG_MAX_CORES];
+static DRAM_ATTR volatile bool recording = false;
+
+void IRAM_ATTR dlog_write(const char *tag, const char *format, uint8_t nargs, const uint64_t *args) {
+    if (!recording) {
+        return;
+    }
+    uint32_t core = xPortGetCoreID();
+    dlog_record *r = trace_ring_claim(&rings[core]);
+    r->time_us = (uint32_t)esp_timer_get_time();
+    r->tag = (uint32_t)(uintptr_t)tag;
+    r->format = (uint32_t)(uintptr_t)format;
+    r->core = core;
+    r->nargs = nargs;
+    for (uint8_t i = 0; i < nargs; i++) {
+        r->args[i] = args[i];
+    }
+}
+
+void dlog_init(void) {
+    _Static_assert((DLOG_RING_RECORDS & (DLOG_RING_RECORDS - 1)) == 0, "DLOG_RING_RECORDS must be a power of two");
+    _Static_assert(sizeof(dlog_record) == 64, "the host tool expects 64 byte records");
+    for (int core = 0; core < DLOG_MAX_CORES; core++) {
+        trace_ring_init(&rings[core], records[core], DLOG_RING_RECORDS, sizeof(dlog_record));
+    }
+    dlog_start();
+}
+
+void dlog_start(void) {
+    //older records are dropped, the rings start empty
+    recording = false;
+    trace_ring_clear(rings, DLOG_MAX_CORES);
+    recording = true;
+}
+
+void dlog_stop(void) {
+    recording = false;
+}
+
+bool dlog_enabled(void) {
+    return recording;
+}
+
+void dlog_serialize(dlog_writer write, void *ctx) {
+    bool was_recording = recording;
+    dlog_header header = {
+        .magic = DLOG_MAGIC,
+        .version = DLOG_VERSION,
+        .cores = portNUM_PROCESSORS,
+        .record_size = sizeof(dlog_record),
+        .ring_records = DLOG_RING_RECORDS,
+    };
+
+    //a tick for records which were being written when the recording stopped
+    recording = false;
+    vTaskDelay(1);
+
+    write(&header, sizeof(header), ctx);
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        trace_ring_serialize(&rings[core], write, ctx);
+    }
+
+    recording = was_recording;
+}
+
+void dlog_dump(void) {
+    //host/dlogdec cuts it out of a terminal log like the trace
+    trace_ring_hexdump("dlog", dlog_serialize);
+}
@@ -2,6 +2,11 @@
 #define EDUBOARD_CPU_BOARD_ESP32_S3
 //#define EDUBOARD_CPU_BOARD_ATMEGA328PB
 
+/*Core Config*/
+#define CONFIG_BSP_TASK_CORE 0      //core for the polling tasks of buttons, touch and rotary encoder (tskNO_AFFINITY lets them float)
+#define CONFIG_BSP_IRQ_CORE 0       //core the drivers installing interrupts are started on, an interrupt is allocated on the calling core
+#define CONFIG_BSP_INIT_WORKERS 4   //init tasks starting independent drivers in parallel, spread over both cores
+
 /*LED Config*/
 #define CONFIG_ENABLE_LED0
 #define CONFIG_ENABLE_LED1
@@ -38,7 +43,7 @@
 
 
 /*DAC Output Config*/
-#define CONFIG_ENABLE_DAC
+// #define CONFIG_ENABLE_DAC         //shares its CS with the flash
 #ifdef CONFIG_ENABLE_DAC
     // #define CONFIG_DAC_STREAMING
     #ifdef CONFIG_DAC_STREAMING
@@ -57,7 +62,19 @@
 #define CONFIG_ENABLE_LCD
 #ifdef CONFIG_ENABLE_LCD
     // #define CONFIG_LCD_ST7789
-    #define CONFIG_LCD_ILI9488
+    // #define CONFIG_LCD_FRAMEBUFFER     //panel in RAM without SPI, the host builds define it on the command line
+    #if !defined(CONFIG_LCD_ST7789) && !defined(CONFIG_LCD_FRAMEBUFFER)
+    #define CONFIG_LCD_ILI9488          //panel of the board, used unless another one is selected above
+    #endif
+    #if defined(CONFIG_LCD_ST7789) + defined(CONFIG_LCD_ILI9488) + defined(CONFIG_LCD_FRAMEBUFFER) > 1
+    #error "Select one LCD panel driver: CONFIG_LCD_ST7789, CONFIG_LCD_ILI9488 or CONFIG_LCD_FRAMEBUFFER"
+    #endif
+    #ifdef CONFIG_LCD_FRAMEBUFFER
+        #define CONFIG_FRAMEBUFFER_BYTES_PER_PIXEL 3        //wire format of the modeled panel, 3 for the RGB666 of the ILI9488, 2 for the ST7789
+        #define CONFIG_FRAMEBUFFER_SPI_FREQUENCY 40000000   //SPI_Frequency of ili9488.c
+        #define CONFIG_FRAMEBUFFER_TRANSACTION_NS 4000      //fixed cost of a polling transaction and the DC switch, calibrate against the board
+        #define CONFIG_FRAMEBUFFER_BLOCK_ON_WIRE            //the drawing task waits out the modeled transfers like spi_device_polling_transmit
+    #endif
     
     // #define CONFIG_LCD_RESOLUTION_240x240
     // #define CONFIG_LCD_RESOLUTION_240x320
@@ -83,6 +100,6 @@
     // #define CONFIG_RTC_SHOW_TIME
 #endif
 
-//#define CONFIG_ENABLE_FLASH //Not yet implemented
+#define CONFIG_ENABLE_FLASH         //littlefs on the W25 flash, used by the digit cache
 
 //#define CONFIG_ENABLE_SDCARD //Not yet implemented
@@ -144,6 +144,22 @@
             #define SCREEN_MAX_Y 320
         #endif            
     #endif
+    #ifdef CONFIG_LCD_FRAMEBUFFER
+        //oriented like the panel of the same resolution
+        #ifdef CONFIG_LCD_RESOLUTION_320x480
+            #define SCREEN_ROTATION 90
+            #define SCREEN_MAX_X 480
+            #define SCREEN_MAX_Y 320
+        #endif
+        #ifdef CONFIG_LCD_RESOLUTION_240x240
+            #define SCREEN_MAX_X 240
+            #define SCREEN_MAX_Y 240
+        #endif
+        #ifdef CONFIG_LCD_RESOLUTION_240x320
+            #define SCREEN_MAX_X 240
+            #define SCREEN_MAX_Y 320
+        #endif
+    #endif
     #ifndef SCREEN_ROTATION
         #define SCREEN_ROTATION 0
     #endif
@@ -2,6 +2,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef CONFIG_ENABLE_SW0
     #define SW0 0
@@ -26,4 +27,6 @@ typedef enum {
 } button_state;
 
 button_state button_get_state(uint8_t button_num, bool reset);
+// esp_timer time in us when the last short or long press was recognized, 0 before the first one
+int64_t button_get_time(uint8_t button_num);
 void eduboard_init_buttons();
\ No newline at end of file
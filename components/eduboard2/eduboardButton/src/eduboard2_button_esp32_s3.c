@@ -5,6 +5,7 @@
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
 
 #define TAG "Button_Driver"
@@ -14,6 +15,7 @@ typedef struct {
     uint32_t count;
     button_state state;
     uint32_t timeout;
+    int64_t time_us;        // esp_timer time of the last short or long press
 } button_data;
 
 button_data buttons[4];
@@ -90,10 +92,12 @@ void buttonTask(void* arg) {
                     buttons[i].count = 0;
                 } else if(buttons[i].count < BUTTONPRESS_LONG_MS / BUTTON_UPDATE_TIME_MS / portTICK_PERIOD_MS) {
                     buttons[i].state = SHORT_PRESSED;
+                    buttons[i].time_us = esp_timer_get_time();
                     buttons[i].count = 0;
                     buttons[i].timeout = button_state_timeout_time / BUTTON_UPDATE_TIME_MS / portTICK_PERIOD_MS;
                 } else {
                     buttons[i].state = LONG_PRESSED;
+                    buttons[i].time_us = esp_timer_get_time();
                     buttons[i].count = 0;
                     buttons[i].timeout = button_state_timeout_time / BUTTON_UPDATE_TIME_MS / portTICK_PERIOD_MS;
                 }
@@ -123,8 +127,19 @@ button_state button_get_state(uint8_t button_num, bool reset) {
     return returnValue;
 }
 
+int64_t button_get_time(uint8_t button_num) {
+    int64_t returnValue = 0;
+    if(buttondataLock == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(buttondataLock, portMAX_DELAY);
+    returnValue = buttons[button_num].time_us;
+    xSemaphoreGive(buttondataLock);
+    return returnValue;
+}
+
 void eduboard_init_buttons() {    
     buttondataLock = xSemaphoreCreateMutex();
-    xTaskCreate(buttonTask, "buttonTask", 2*2048, NULL, 10, NULL);
+    xTaskCreatePinnedToCore(buttonTask, "buttonTask", 2*2048, NULL, 10, NULL, CONFIG_BSP_TASK_CORE);
 }
 
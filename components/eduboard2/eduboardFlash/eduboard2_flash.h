@@ -1,6 +1,45 @@
 #pragma once
 
 #include <stdio.h>
+#include <stdint.h>
+#include "lfs.h"
 
 void flash_checkConnection();
-void eduboard_init_flash();
\ No newline at end of file
+void eduboard_init_flash();
+
+#define FLASH_STATS_OPS         16      //file operations with their own statistics, more share the last one
+#define FLASH_STATS_BUCKETS     18      //bucket b counts accesses below 2^b us, the last one the rest
+
+typedef enum {
+    FLASH_STATS_READ,
+    FLASH_STATS_PROG,
+    FLASH_STATS_ERASE,
+    FLASH_STATS_BUSY,                   // waiting for the W25 after an access, part of the three above
+    FLASH_STATS_KINDS
+} flash_stats_kind;
+
+typedef struct {
+    uint32_t count;
+    uint64_t bytes;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint32_t buckets[FLASH_STATS_BUCKETS];
+} flash_histogram;
+
+typedef struct {
+    const char *op;                     // name given to flash_fs_lock_op
+    flash_histogram kinds[FLASH_STATS_KINDS];
+} flash_op_stats;
+
+// mounted littlefs on the W25 flash or NULL
+lfs_t *flash_fs(void);
+void flash_fs_lock(void);
+// Like flash_fs_lock, the block device accesses until flash_fs_unlock are counted under op
+void flash_fs_lock_op(const char *op);
+void flash_fs_unlock(void);
+
+// Copies the statistics of up to max file operations, returns how many there are
+size_t flash_stats_get(flash_op_stats *stats, size_t max);
+void flash_stats_reset(void);
+// Prints the statistics on the console
+void flash_stats_print(void);
@@ -8,12 +8,13 @@
 #include "freertos/semphr.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 
-#ifndef CONFIG_ENABLE_FLASH
-#include "../lfs/lfs.h"
-#endif
+#include "lfs.h"
 
 #include "w25.h"
+#include "flash_stats.h"
+#include "trace.h"
 
 #define FLASH_FREQ_MHZ      SPI_MASTER_FREQ_10M
 
@@ -27,6 +28,8 @@ int storage_lfs_sync(const struct lfs_config *cfg);
 // variables used by the filesystem
 lfs_t lfs;
 lfs_file_t file;
+static SemaphoreHandle_t lfs_mutex = NULL;
+static bool lfs_mounted = false;
 
 #define BLOCK_SIZE 4096
 
@@ -51,7 +54,10 @@ const struct lfs_config cfg = {
 int storage_lfs_read(const struct lfs_config *cfg, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size)
 {
     uint32_t addr = (block * BLOCK_SIZE) + off;
-    w25_read_flash(addr, buffer, size);
+    int64_t start = esp_timer_get_time();
+    uint32_t busy = w25_read_flash(addr, buffer, size);
+    flash_stats_record(FLASH_STATS_READ, size, esp_timer_get_time() - start);
+    flash_stats_record(FLASH_STATS_BUSY, 0, busy);
 
     return 0;
 }
@@ -59,7 +65,10 @@ int storage_lfs_read(const struct lfs_config *cfg, lfs_block_t block, lfs_off_t
 int storage_lfs_prog(const struct lfs_config *cfg, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size)
 {
     uint32_t addr = (block * BLOCK_SIZE) + off;
-    w25_write_page(addr, (uint8_t *)buffer, size);
+    int64_t start = esp_timer_get_time();
+    uint32_t busy = w25_write_page(addr, (uint8_t *)buffer, size);
+    flash_stats_record(FLASH_STATS_PROG, size, esp_timer_get_time() - start);
+    flash_stats_record(FLASH_STATS_BUSY, 0, busy);
 
     return 0;
 }
@@ -67,7 +76,10 @@ int storage_lfs_prog(const struct lfs_config *cfg, lfs_block_t block, lfs_off_t
 int storage_lfs_erase(const struct lfs_config *cfg, lfs_block_t block)
 {
     uint32_t addr = block * BLOCK_SIZE;
-    w25_erase_page(addr);
+    int64_t start = esp_timer_get_time();
+    uint32_t busy = w25_erase_page(addr);
+    flash_stats_record(FLASH_STATS_ERASE, BLOCK_SIZE, esp_timer_get_time() - start);
+    flash_stats_record(FLASH_STATS_BUSY, 0, busy);
 
     return 0;
 }
@@ -130,6 +142,7 @@ void eduboard_init_flash() {
     w25_init(&dev_flash_spi);
 
     // mount the filesystem
+    flash_stats_set_op("mount");
     int err = lfs_mount(&lfs, &cfg);
 
     // reformat if we can't mount the filesystem
@@ -137,8 +150,32 @@ void eduboard_init_flash() {
     if (err)
     {
         lfs_format(&lfs, &cfg);
-        lfs_mount(&lfs, &cfg);
+        err = lfs_mount(&lfs, &cfg);
     }
+    flash_stats_set_op("boot");
+    lfs_mutex = xSemaphoreCreateMutex();
+    lfs_mounted = (err == LFS_ERR_OK) && (lfs_mutex != NULL);
 
     ESP_LOGI(TAG, "init flash done");
-}
\ No newline at end of file
+}
+
+lfs_t *flash_fs(void) {
+    // littlefs is not thread safe, every access has to be wrapped in flash_fs_lock/flash_fs_unlock
+    return lfs_mounted ? &lfs : NULL;
+}
+
+void flash_fs_lock(void) {
+    flash_fs_lock_op(NULL);
+}
+
+void flash_fs_lock_op(const char *op) {
+    xSemaphoreTake(lfs_mutex, portMAX_DELAY);
+    trace_record(TRACE_FS_BEGIN, 0, 0);
+    flash_stats_set_op(op);
+}
+
+void flash_fs_unlock(void) {
+    flash_stats_set_op(NULL);
+    trace_record(TRACE_FS_END, 0, 0);
+    xSemaphoreGive(lfs_mutex);
+}
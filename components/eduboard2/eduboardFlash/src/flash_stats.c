@@ -0,0 +1,104 @@
+#include "../../eduboard2.h"
+#include "flash_stats.h"
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define FLASH_STATS_NO_OP   "other"
+#define FLASH_STATS_MORE_OPS "(more)"
+
+static const char *kind_names[FLASH_STATS_KINDS] = {"read", "prog", "erase", "busy"};
+
+static flash_op_stats ops[FLASH_STATS_OPS];
+static size_t opcount = 0;
+static size_t currentop = 0;
+static portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+
+void flash_stats_set_op(const char *op) {
+    if (op == NULL) {
+        op = FLASH_STATS_NO_OP;
+    }
+    taskENTER_CRITICAL(&statsLock);
+    size_t i = 0;
+    while (i < opcount && strcmp(ops[i].op, op) != 0) {
+        i++;
+    }
+    if (i == opcount) {
+        if (opcount < FLASH_STATS_OPS) {
+            memset(&ops[i], 0, sizeof(ops[i]));
+            ops[i].op = op;
+            opcount++;
+        } else {
+            //the names must stay valid, the last slot collects everything beyond
+            i = FLASH_STATS_OPS - 1;
+            ops[i].op = FLASH_STATS_MORE_OPS;
+        }
+    }
+    currentop = i;
+    taskEXIT_CRITICAL(&statsLock);
+}
+
+void flash_stats_record(flash_stats_kind kind, uint32_t bytes, uint32_t time_us) {
+    int bucket = 0;
+    while (bucket < FLASH_STATS_BUCKETS - 1 && time_us >= (1u << bucket)) {
+        bucket++;
+    }
+    taskENTER_CRITICAL(&statsLock);
+    if (opcount == 0) {
+        memset(&ops[0], 0, sizeof(ops[0]));
+        ops[0].op = FLASH_STATS_NO_OP;
+        opcount = 1;
+        currentop = 0;
+    }
+    flash_histogram *h = &ops[currentop].kinds[kind];
+    h->count++;
+    h->bytes += bytes;
+    h->total_us += time_us;
+    if (time_us > h->max_us) {
+        h->max_us = time_us;
+    }
+    h->buckets[bucket]++;
+    taskEXIT_CRITICAL(&statsLock);
+}
+
+size_t flash_stats_get(flash_op_stats *stats, size_t max) {
+    taskENTER_CRITICAL(&statsLock);
+    size_t count = opcount;
+    memcpy(stats, ops, ((count < max) ? count : max) * sizeof(flash_op_stats));
+    taskEXIT_CRITICAL(&statsLock);
+    return count;
+}
+
+void flash_stats_reset(void) {
+    taskENTER_CRITICAL(&statsLock);
+    for (size_t i = 0; i < opcount; i++) {
+        memset(ops[i].kinds, 0, sizeof(ops[i].kinds));
+    }
+    taskEXIT_CRITICAL(&statsLock);
+}
+
+void flash_stats_print(void) {
+    //a copy, the console output must not run in the critical section
+    static flash_op_stats copy[FLASH_STATS_OPS];
+    size_t count = flash_stats_get(copy, FLASH_STATS_OPS);
+
+    printf("----- flash stats -----\n");
+    printf("op               kind     count       bytes   total[ms]  avg[us]  max[us]  count below 1,2,4..%u us and above\n", 1u << (FLASH_STATS_BUCKETS - 2));
+    for (size_t i = 0; i < count; i++) {
+        for (int kind = 0; kind < FLASH_STATS_KINDS; kind++) {
+            flash_histogram *h = &copy[i].kinds[kind];
+            if (h->count == 0) {
+                continue;
+            }
+            printf("%-16s %-6s %8lu %11llu %11.1f %8llu %8lu ", copy[i].op, kind_names[kind], (unsigned long)h->count,
+                   (unsigned long long)h->bytes, h->total_us / 1000.0, (unsigned long long)(h->total_us / h->count), (unsigned long)h->max_us);
+            for (int b = 0; b < FLASH_STATS_BUCKETS; b++) {
+                printf(" %lu", (unsigned long)h->buckets[b]);
+            }
+            printf("\n");
+        }
+    }
+    printf("----- end -----\n");
+    fflush(stdout);
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include "../eduboard2_flash.h"
+
+// Used by the block device functions of the flash driver, the caller holds the filesystem
+void flash_stats_set_op(const char *op);
+void flash_stats_record(flash_stats_kind kind, uint32_t bytes, uint32_t time_us);
@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include <string.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "w25.h"
 #include "gpspi.h"
 
@@ -13,6 +14,7 @@
 #define W25_READ_DATA_COMMAND 0x03
 #define W25_PAGE_PROGRAM_COMMAND  0x02
 #define W25_SECTOR_ERASE_COMMAND  0x20
+#define W25_READ_CHUNK            256   //bytes per read transaction, the buffer is on the stack
 
 // #define W25_DEBUG 1
 
@@ -52,27 +54,44 @@ void w25_write_enable(void)
     gpspi_read_write_data(spidevice, mybuffer, mybuffer, 1);
 }
 
-void w25_read_flash(uint32_t address, uint8_t *data, uint32_t size)
+static uint32_t w25_wait_ready(void)
+{
+    // polls the busy bit, returns the time the flash needed to finish in us
+    int64_t start = esp_timer_get_time();
+    while (w25_read_status() & 0x01);
+    return esp_timer_get_time() - start;
+}
+
+uint32_t w25_read_flash(uint32_t address, uint8_t *data, uint32_t size)
 {
 #ifdef W25_DEBUG
     ESP_LOGW(TAG, "Reading Flash start %X\n", (unsigned int)(address));
 #endif
 
-    uint8_t mybuffer[256 + 4];
-    mybuffer[0] = W25_READ_DATA_COMMAND;
+    uint8_t mybuffer[W25_READ_CHUNK + 4];
+    uint32_t busy = 0;
 
-    mybuffer[1] = (address >> 16) & 0xFF;
-    mybuffer[2] = (address >> 8) & 0xFF;
-    mybuffer[3] = address & 0xFF;
+    // littlefs reads past its cache straight into the file buffer, larger reads take several transactions
+    while (size > 0) {
+        uint32_t chunk = (size > W25_READ_CHUNK) ? W25_READ_CHUNK : size;
+        mybuffer[0] = W25_READ_DATA_COMMAND;
 
-    gpspi_read_write_data(spidevice, mybuffer, mybuffer, 4 + size);
+        mybuffer[1] = (address >> 16) & 0xFF;
+        mybuffer[2] = (address >> 8) & 0xFF;
+        mybuffer[3] = address & 0xFF;
 
-    memcpy(data, &mybuffer[4], size);
+        gpspi_read_write_data(spidevice, mybuffer, mybuffer, 4 + chunk);
 
-    while (w25_read_status() & 0x01);
+        memcpy(data, &mybuffer[4], chunk);
+        busy += w25_wait_ready();
+        address += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+    return busy;
 }
 
-void w25_write_page(uint32_t address, uint8_t *data, uint32_t size)
+uint32_t w25_write_page(uint32_t address, uint8_t *data, uint32_t size)
 {
 #ifdef W25_DEBUG
     ESP_LOGW(TAG, "Write Page start %X\n", (unsigned int)(address));
@@ -91,10 +110,10 @@ void w25_write_page(uint32_t address, uint8_t *data, uint32_t size)
 
     gpspi_read_write_data(spidevice, mybuffer, mybuffer, 4 + size);
 
-    while (w25_read_status() & 0x01);
+    return w25_wait_ready();
 }
 
-void w25_erase_page(uint32_t address)
+uint32_t w25_erase_page(uint32_t address)
 {
 #ifdef W25_DEBUG
     ESP_LOGW(TAG, "Erase Page %X start \n", (unsigned int)(address));
@@ -111,7 +130,7 @@ void w25_erase_page(uint32_t address)
 
     gpspi_read_write_data(spidevice, mybuffer, mybuffer, 4);
 
-    while (w25_read_status() & 0x01);
+    return w25_wait_ready();
 }
 
 void w25_init(spi_device_handle_t* handle) {
@@ -1,5 +1,19 @@
 #pragma once
 #include "../eduboard2_config.h"
 #include <stdlib.h>
+#include <stdint.h>
 
-void eduboard2_init();
\ No newline at end of file
+// One driver started by eduboard2_init, the times are in us since the start of eduboard2_init
+typedef struct {
+    const char *name;
+    int core;
+    int64_t ready_us;       //all drivers it depends on were done
+    int64_t start_us;
+    int64_t end_us;
+} eduboard2_init_timing;
+
+void eduboard2_init();
+// Copies the timing of the started drivers in the order they were started, returns their number
+size_t eduboard2_init_get_timing(eduboard2_init_timing *timing, size_t max);
+// Prints the timing, the sequential and the parallel init time and the critical path
+void eduboard2_init_print_report();
@@ -6,7 +6,8 @@
 #include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_system.h"
@@ -67,66 +68,255 @@
     #include "gpspi.h"
 #endif
 
-SemaphoreHandle_t sem_initdone;
+// The drivers are the nodes of a dependency graph. A node starts as soon as the nodes in its deps are done,
+// independent drivers run at the same time on the init workers of both cores and overlap their delays.
+typedef enum {
+    INIT_SPI_BUS,
+    INIT_I2C_BUS,
+    INIT_LED,
+    INIT_BUZZER,
+    INIT_BUTTONS,
+    INIT_ROTARYENCODER,
+    INIT_ANALOG,
+    INIT_SPIFFS,
+    INIT_FLASH,
+    INIT_DAC,
+    INIT_LCD_PANEL,
+    INIT_LCD_SPLASH,
+    INIT_TMP112,
+    INIT_STK8321,
+    INIT_FT6236,
+    INIT_RTC,
+    INIT_NODES
+} init_node_id;
 
-void eduboard2_initTask(void* param) {
-    #ifdef CONFIG_ENABLE_LED
-    eduboard_init_leds();
-    #endif
+#define INIT_BIT(node)      ((EventBits_t)1 << (node))
+#define INIT_ALL            (INIT_BIT(INIT_NODES) - 1)
+#define INIT_ANY_CORE       tskNO_AFFINITY
+#define INIT_WORKER_STACK   (4*2048)
 
-    #ifdef CONFIG_ENABLE_BUZZER
+_Static_assert(INIT_NODES <= 24, "an event group has 24 bits");
+
+typedef struct {
+    const char *name;
+    void (*init)(void);
+    EventBits_t deps;
+    BaseType_t core;        //INIT_ANY_CORE or the core the init has to run on
+    int ran_on;
+    int64_t start_us;
+    int64_t end_us;
+} init_node;
+
+#ifdef CONFIG_ENABLE_SPI
+static void init_spi_bus(void) {
+    //before any device, the LCD adds itself without MISO and must not decide the pins of the bus
+    gpspi_init_bus(GPIO_MOSI, GPIO_MISO, GPIO_SCK);
+}
+#endif
+
+#ifdef CONFIG_ENABLE_I2C
+static void init_i2c_bus(void) {
+    gpi2c_init(GPIO_I2C_SDA, GPIO_I2C_SCL, 400000);
+}
+#endif
+
+#ifdef CONFIG_ENABLE_BUZZER
+static void init_buzzer(void) {
     eduboard_init_buzzer();
     buzzer_set_volume(3);
-    #endif
+}
+#endif
 
+// The bus inits allocate their interrupts on the calling core and run on CONFIG_BSP_IRQ_CORE, the devices
+// on the buses follow them. Flash and DAC share their CS, the DAC waits for the flash like before.
+// LEDs and buzzer both set up timers and channels of the LEDC, whose driver state is not locked, the buzzer goes second.
+static init_node nodes[INIT_NODES] = {
+    #ifdef CONFIG_ENABLE_SPI
+    [INIT_SPI_BUS] = {"SPI bus", init_spi_bus, 0, CONFIG_BSP_IRQ_CORE},
+    #endif
+    #ifdef CONFIG_ENABLE_I2C
+    [INIT_I2C_BUS] = {"I2C bus", init_i2c_bus, 0, CONFIG_BSP_IRQ_CORE},
+    #endif
+    #ifdef CONFIG_ENABLE_LED
+    [INIT_LED] = {"LED", eduboard_init_leds, 0, CONFIG_BSP_IRQ_CORE},
+    #endif
+    #ifdef CONFIG_ENABLE_BUZZER
+    [INIT_BUZZER] = {"Buzzer", init_buzzer, INIT_BIT(INIT_LED), INIT_ANY_CORE},
+    #endif
     #ifdef CONFIG_ENABLE_BUTTONS
-    eduboard_init_buttons();
+    [INIT_BUTTONS] = {"Buttons", eduboard_init_buttons, 0, INIT_ANY_CORE},
     #endif
-
     #ifdef CONFIG_ENABLE_ROTARYENCODER
-    eduboard_init_rotary_encoder();
+    [INIT_ROTARYENCODER] = {"Rotary encoder", eduboard_init_rotary_encoder, 0, CONFIG_BSP_IRQ_CORE},
     #endif
-
     #ifdef CONFIG_ENABLE_ANALOG
-    eduboard_init_adc();
+    [INIT_ANALOG] = {"ADC", eduboard_init_adc, 0, INIT_ANY_CORE},
     #endif
-
     #ifdef CONFIG_ENABLE_SPIFFS
-    eduboard_init_spiffs();
+    [INIT_SPIFFS] = {"SPIFFS", eduboard_init_spiffs, 0, INIT_ANY_CORE},
     #endif
-
     #ifdef CONFIG_ENABLE_FLASH
-    eduboard_init_flash();
+    [INIT_FLASH] = {"Flash", eduboard_init_flash, INIT_BIT(INIT_SPI_BUS), INIT_ANY_CORE},
     #endif
     #ifdef CONFIG_ENABLE_DAC
-    eduboard_init_dac();
+    [INIT_DAC] = {"DAC", eduboard_init_dac, INIT_BIT(INIT_SPI_BUS) | INIT_BIT(INIT_FLASH), INIT_ANY_CORE},
     #endif
-    
     #ifdef CONFIG_ENABLE_LCD
-    eduboard_init_lcd();
+    [INIT_LCD_PANEL] = {"LCD panel", eduboard_init_lcd_panel, INIT_BIT(INIT_SPI_BUS), INIT_ANY_CORE},
+    [INIT_LCD_SPLASH] = {"LCD splash", eduboard_lcd_show_splash, INIT_BIT(INIT_LCD_PANEL) | INIT_BIT(INIT_SPIFFS), INIT_ANY_CORE},
     #endif
-
     #ifdef CONFIG_ENABLE_SENSOR_TMP112
-    eduboard_init_tmp112();
+    [INIT_TMP112] = {"TMP112", eduboard_init_tmp112, INIT_BIT(INIT_I2C_BUS), INIT_ANY_CORE},
     #endif
     #ifdef CONFIG_ENABLE_SENSOR_STK8321
-    eduboard_init_stk8321();
+    [INIT_STK8321] = {"STK8321", eduboard_init_stk8321, INIT_BIT(INIT_I2C_BUS), INIT_ANY_CORE},
     #endif
     #ifdef CONFIG_ENABLE_TOUCH_FT6236
-    eduboard_init_ft6236();
+    [INIT_FT6236] = {"FT6236", eduboard_init_ft6236, INIT_BIT(INIT_I2C_BUS), INIT_ANY_CORE},
     #endif
     #ifdef CONFIG_ENABLE_RTC
-    eduboard_init_rtc();
+    [INIT_RTC] = {"RTC", eduboard_init_rtc, INIT_BIT(INIT_I2C_BUS), INIT_ANY_CORE},
     #endif
-    xSemaphoreGive(sem_initdone);
+};
+
+static bool taken[INIT_NODES];
+static portMUX_TYPE initLock = portMUX_INITIALIZER_UNLOCKED;
+static StaticEventGroup_t initDoneBuffer;
+static EventGroupHandle_t initDone;
+static int64_t initStart_us;
+static int64_t initEnd_us;
+
+static int takeReadyNode(EventBits_t done, BaseType_t core) {
+    int next = -1;
+    taskENTER_CRITICAL(&initLock);
+    for (int i = 0; i < INIT_NODES && next < 0; i++) {
+        if (!taken[i] && (nodes[i].deps & ~done) == 0 && (nodes[i].core == INIT_ANY_CORE || nodes[i].core == core)) {
+            taken[i] = true;
+            next = i;
+        }
+    }
+    taskEXIT_CRITICAL(&initLock);
+    return next;
+}
+
+void eduboard2_initTask(void* param) {
+    BaseType_t core = xPortGetCoreID();
+    EventBits_t done;
+    while (((done = xEventGroupGetBits(initDone)) & INIT_ALL) != INIT_ALL) {
+        int node = takeReadyNode(done, core);
+        if (node < 0) {
+            //nothing this worker may start yet, wait until one more driver is done
+            xEventGroupWaitBits(initDone, INIT_ALL & ~done, pdFALSE, pdFALSE, portMAX_DELAY);
+            continue;
+        }
+        nodes[node].ran_on = core;
+        nodes[node].start_us = esp_timer_get_time() - initStart_us;
+        nodes[node].init();
+        nodes[node].end_us = esp_timer_get_time() - initStart_us;
+        xEventGroupSetBits(initDone, INIT_BIT(node));
+    }
     vTaskDelete(NULL);
 }
 
 void eduboard2_init() {
-    sem_initdone = xSemaphoreCreateBinary();
     ESP_LOGI(TAG, "Init Eduboard2...");
-    xTaskCreate(eduboard2_initTask, "init_task", 4*2048, NULL, 10, NULL);
-    xSemaphoreTake(sem_initdone, portMAX_DELAY);
+    initDone = xEventGroupCreateStatic(&initDoneBuffer);
+    initStart_us = esp_timer_get_time();
+    //disabled drivers count as done
+    EventBits_t disabled = 0;
+    for (int i = 0; i < INIT_NODES; i++) {
+        if (nodes[i].init == NULL) {
+            taken[i] = true;
+            disabled |= INIT_BIT(i);
+        }
+    }
+    xEventGroupSetBits(initDone, disabled);
+    for (int w = 0; w < CONFIG_BSP_INIT_WORKERS; w++) {
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "init_task%d", w);
+        xTaskCreatePinnedToCore(eduboard2_initTask, name, INIT_WORKER_STACK, NULL, 10, NULL, w % portNUM_PROCESSORS);
+    }
+    xEventGroupWaitBits(initDone, INIT_ALL, pdFALSE, pdTRUE, portMAX_DELAY);
+    initEnd_us = esp_timer_get_time() - initStart_us;
     ESP_LOGI(TAG, "Init Eduboard2 done");
-    vSemaphoreDelete(sem_initdone);
-}
\ No newline at end of file
+    eduboard2_init_print_report();
+}
+
+static int64_t readyTime(int node) {
+    int64_t ready = 0;
+    for (int i = 0; i < INIT_NODES; i++) {
+        if ((nodes[node].deps & INIT_BIT(i)) && nodes[i].init != NULL && nodes[i].end_us > ready) {
+            ready = nodes[i].end_us;
+        }
+    }
+    return ready;
+}
+
+size_t eduboard2_init_get_timing(eduboard2_init_timing *timing, size_t max) {
+    bool copied[INIT_NODES] = {false};
+    size_t count = 0;
+    //in start order, a selection sort is enough for a handful of drivers
+    for (;;) {
+        int first = -1;
+        for (int i = 0; i < INIT_NODES; i++) {
+            if (nodes[i].init != NULL && !copied[i] && (first < 0 || nodes[i].start_us < nodes[first].start_us)) {
+                first = i;
+            }
+        }
+        if (first < 0) {
+            break;
+        }
+        copied[first] = true;
+        if (count < max) {
+            timing[count].name = nodes[first].name;
+            timing[count].core = nodes[first].ran_on;
+            timing[count].ready_us = readyTime(first);
+            timing[count].start_us = nodes[first].start_us;
+            timing[count].end_us = nodes[first].end_us;
+        }
+        count++;
+    }
+    return count;
+}
+
+void eduboard2_init_print_report() {
+    static eduboard2_init_timing timing[INIT_NODES];
+    size_t count = eduboard2_init_get_timing(timing, INIT_NODES);
+    int64_t sequential_us = 0;
+
+    printf("----- board init -----\n");
+    printf("driver           core  ready[ms]  start[ms]   time[ms]    end[ms]\n");
+    for (size_t i = 0; i < count; i++) {
+        int64_t time_us = timing[i].end_us - timing[i].start_us;
+        sequential_us += time_us;
+        printf("%-16s %4d %10.1f %10.1f %10.1f %10.1f\n", timing[i].name, timing[i].core, timing[i].ready_us / 1000.0,
+               timing[i].start_us / 1000.0, time_us / 1000.0, timing[i].end_us / 1000.0);
+    }
+    printf("one after another %.1f ms, in parallel %.1f ms on %d workers\n", sequential_us / 1000.0, initEnd_us / 1000.0, CONFIG_BSP_INIT_WORKERS);
+
+    //the critical path ends with the last driver and goes back over the dependency done last
+    int path[INIT_NODES];
+    int length = 0;
+    int node = -1;
+    for (int i = 0; i < INIT_NODES; i++) {
+        if (nodes[i].init != NULL && (node < 0 || nodes[i].end_us > nodes[node].end_us)) {
+            node = i;
+        }
+    }
+    while (node >= 0 && length < INIT_NODES) {
+        path[length++] = node;
+        int last = -1;
+        for (int i = 0; i < INIT_NODES; i++) {
+            if ((nodes[node].deps & INIT_BIT(i)) && nodes[i].init != NULL && (last < 0 || nodes[i].end_us > nodes[last].end_us)) {
+                last = i;
+            }
+        }
+        node = last;
+    }
+    printf("critical path:");
+    for (int i = length - 1; i >= 0; i--) {
+        printf(" %s%s", nodes[path[i]].name, (i > 0) ? " >" : "");
+    }
+    printf("\n----- end -----\n");
+    fflush(stdout);
+}
@@ -22,4 +22,7 @@
 #endif
 
 
-void eduboard_init_lcd();
\ No newline at end of file
+void eduboard_init_lcd();
+// The two halves of eduboard_init_lcd: the panel needs the SPI bus only, the splash screen the fonts and the logo in the SPIFFS
+void eduboard_init_lcd_panel();
+void eduboard_lcd_show_splash();
\ No newline at end of file
@@ -1180,7 +1180,7 @@ void showVersionString() {
 	
 }
 
-void eduboard_init_lcd() {
+void eduboard_init_lcd_panel() {
     ESP_LOGI(TAG, "Init LCD...");
 	lcd_init();
 	ESP_LOGI(TAG, "Init LCD Done.");
@@ -1204,6 +1204,9 @@ void eduboard_init_lcd() {
 	lcdUpdateVScreen();
     ESP_LOGI(TAG, "Init VScreen Done.");
 	#endif
+}
+
+void eduboard_lcd_show_splash() {
 	#ifdef CONFIG_LCD_TEST
 	xTaskCreate(lcdTest, "LCD_TEST", 2048*6, NULL, 2, NULL);
 	#else
@@ -1214,4 +1217,9 @@ void eduboard_init_lcd() {
 	#endif
 }
 
+void eduboard_init_lcd() {
+	eduboard_init_lcd_panel();
+	eduboard_lcd_show_splash();
+}
+
 #endif
\ No newline at end of file
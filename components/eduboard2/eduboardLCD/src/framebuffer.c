@@ -0,0 +1,434 @@
+#include "../../eduboard2.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "framebuffer.h"
+
+#define TAG "framebuffer"
+
+#ifdef CONFIG_LCD_FRAMEBUFFER
+
+#define FRAMEBUFFER_MAX_PIXELS 1024		//COLORS_MAXLENGTH of ili9488.c, the longest pixel transaction
+#define FRAMEBUFFER_LINES_PER_UPDATE 3	//LINES_PER_UPDATE of ili9488_DrawMultiLines
+#define FRAMEBUFFER_WAIT_NS 1000000		//the modeled wire time is waited out in slices of this length
+#define FRAMEBUFFER_PATH_MAX 128
+#define PNG_STORED_BLOCK 65535
+
+TFT_t * lcddevice = NULL;
+
+static uint16_t *panel = NULL;
+static uint16_t window_x1, window_x2, window_y1, window_y2;
+static uint16_t cursor_x, cursor_y;
+static bool display_on = false;
+static bool inverted = false;
+
+static framebuffer_stats stats;
+static uint64_t frame_start_ns = 0;
+static uint64_t owed_ns = 0;
+static char dump_path[FRAMEBUFFER_PATH_MAX];
+static rotation_t dump_rotation;
+static bool dump_requested = false;
+static portMUX_TYPE fbLock = portMUX_INITIALIZER_UNLOCKED;
+
+static void framebuffer_wait_wire(uint64_t limit_ns)
+{
+#ifdef CONFIG_FRAMEBUFFER_BLOCK_ON_WIRE
+	//busy like the polling transmit on the board, the CPU time of the drawing task includes the wire
+	taskENTER_CRITICAL(&fbLock);
+	uint64_t ns = 0;
+	if (owed_ns >= limit_ns) {
+		ns = owed_ns - owed_ns % 1000;
+		owed_ns -= ns;
+	}
+	taskEXIT_CRITICAL(&fbLock);
+	int64_t until = esp_timer_get_time() + ns / 1000;
+	while (esp_timer_get_time() < until) {
+	}
+#endif
+}
+
+static void framebuffer_transfer(uint32_t bytes, bool command)
+{
+	uint64_t ns = CONFIG_FRAMEBUFFER_TRANSACTION_NS + (uint64_t)bytes * 8 * 1000000000ull / CONFIG_FRAMEBUFFER_SPI_FREQUENCY;
+	taskENTER_CRITICAL(&fbLock);
+	stats.transactions++;
+	stats.bytes += bytes;
+	if (command) {
+		stats.cmd_transactions++;
+	} else if (bytes > 1) {
+		stats.pixel_bytes += bytes;
+	}
+	stats.wire_ns += ns;
+	owed_ns += ns;
+	taskEXIT_CRITICAL(&fbLock);
+	framebuffer_wait_wire(FRAMEBUFFER_WAIT_NS);
+}
+
+static void framebuffer_command(uint8_t databytes)
+{
+	//the command byte and every argument byte in a transaction of its own, like ili9488_spi_write_cmd_data
+	framebuffer_transfer(1, true);
+	for (uint8_t i = 0; i < databytes; i++) {
+		framebuffer_transfer(1, false);
+	}
+}
+
+static void framebuffer_setpos(uint16_t x1, uint16_t x2, uint16_t y1, uint16_t y2)
+{
+	//column and page address set and memory write
+	framebuffer_command(4);
+	framebuffer_command(4);
+	framebuffer_command(0);
+	window_x1 = x1;
+	window_x2 = x2;
+	window_y1 = y1;
+	window_y2 = y2;
+	cursor_x = x1;
+	cursor_y = y1;
+}
+
+static void framebuffer_write_pixels(uint16_t *colors, uint32_t length, bool fill)
+{
+	//one transaction, the pixels run through the window like the memory write of the panel
+	for (uint32_t i = 0; i < length; i++) {
+		if (panel != NULL && cursor_x < lcddevice->_width && cursor_y < lcddevice->_height) {
+			panel[(cursor_y * lcddevice->_width) + cursor_x] = fill ? colors[0] : colors[i];
+		}
+		if (++cursor_x > window_x2) {
+			cursor_x = window_x1;
+			if (++cursor_y > window_y2) {
+				cursor_y = window_y1;
+			}
+		}
+	}
+	framebuffer_transfer(length * CONFIG_FRAMEBUFFER_BYTES_PER_PIXEL, false);
+}
+
+static void framebuffer_write_colors(uint16_t *colors, uint32_t length, bool fill)
+{
+	while (length > FRAMEBUFFER_MAX_PIXELS) {
+		framebuffer_write_pixels(colors, FRAMEBUFFER_MAX_PIXELS, fill);
+		if (!fill) {
+			colors += FRAMEBUFFER_MAX_PIXELS;
+		}
+		length -= FRAMEBUFFER_MAX_PIXELS;
+	}
+	framebuffer_write_pixels(colors, length, fill);
+}
+
+void framebuffer_init(TFT_t * dev, int width, int height, int offsetx, int offsety)
+{
+	lcddevice = dev;
+	lcddevice->_width = width;
+	lcddevice->_height = height;
+	lcddevice->_offsetx = offsetx;
+	lcddevice->_offsety = offsety;
+	lcddevice->_font_direction = DIRECTION0;
+	lcddevice->_font_fill = false;
+	lcddevice->_font_underline = false;
+	lcddevice->_dc = -1;
+	lcddevice->_bl = -1;
+	lcddevice->_SPIHandle = NULL;
+
+	ESP_LOGI(TAG, "Framebuffer %ix%i, %i bytes per pixel at %.0f MHz, %i ns per transaction", width, height,
+	         CONFIG_FRAMEBUFFER_BYTES_PER_PIXEL, CONFIG_FRAMEBUFFER_SPI_FREQUENCY / 1e6, CONFIG_FRAMEBUFFER_TRANSACTION_NS);
+	//300 KB for 320x480, more than the internal RAM has free
+	panel = (uint16_t *)heap_caps_malloc(width * height * sizeof(uint16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+	if (panel == NULL) {
+		ESP_LOGE(TAG, "No memory for the %ix%i panel", width, height);
+		return;
+	}
+	memset(panel, 0x00, width * height * sizeof(uint16_t));
+
+	//the init sequence of ili9488_init in transactions: reset, gammas, power, VCOM, MADCTL, COLMOD, interface,
+	//frame rate, inversion, function control, image function, adjust control, sleep out and display on
+	framebuffer_command(0);
+	framebuffer_command(15);
+	framebuffer_command(15);
+	framebuffer_command(2);
+	framebuffer_command(1);
+	framebuffer_command(3);
+	framebuffer_command(1);
+	framebuffer_command(1);
+	framebuffer_command(1);
+	framebuffer_command(1);
+	framebuffer_command(1);
+	framebuffer_command(2);
+	framebuffer_command(1);
+	framebuffer_command(4);
+	framebuffer_command(0);
+	framebuffer_command(0);
+	display_on = true;
+}
+
+void framebuffer_DrawPixel(uint16_t x, uint16_t y, uint16_t color) {
+	if (x >= lcddevice->_width) return;
+	if (y >= lcddevice->_height) return;
+
+	uint16_t _x = x + lcddevice->_offsetx;
+	uint16_t _y = y + lcddevice->_offsety;
+
+	framebuffer_setpos(_x, _x, _y, _y);
+	framebuffer_write_colors(&color, 1, false);
+}
+
+void framebuffer_DrawMultiPixels(uint16_t x, uint16_t y, uint16_t size, uint16_t * colors) {
+	if (x+size > lcddevice->_width) return;
+	if (y >= lcddevice->_height) return;
+
+	uint16_t _x1 = x + lcddevice->_offsetx;
+	uint16_t _y1 = y + lcddevice->_offsety;
+	framebuffer_setpos(_x1, _x1 + size - 1, _y1, _y1);
+	framebuffer_write_colors(colors, size, false);
+}
+
+void framebuffer_DrawArea(uint16_t x, uint16_t y, uint16_t size_x, uint16_t size_y, uint16_t * colors)
+{
+	if (x+size_x-1 > lcddevice->_width) {ESP_LOGE(TAG, "ERROR"); return;}
+	if (y+size_y-1 >= lcddevice->_height) {ESP_LOGE(TAG, "ERROR"); return;}
+	uint16_t _x1 = x + lcddevice->_offsetx;
+	uint16_t _y1 = y + lcddevice->_offsety;
+	framebuffer_setpos(_x1, _x1 + size_x - 1, _y1, _y1 + size_y - 1);
+	framebuffer_write_colors(colors, size_x * size_y, false);
+}
+
+void framebuffer_DrawMultiLines(uint16_t start_y, uint16_t lines, uint16_t * colors) {
+	framebuffer_setpos(0, lcddevice->_width - 1, start_y, start_y + lines - 1);
+	for (int y = 0; y < lines; y += FRAMEBUFFER_LINES_PER_UPDATE) {
+		int count = (lines - y < FRAMEBUFFER_LINES_PER_UPDATE) ? lines - y : FRAMEBUFFER_LINES_PER_UPDATE;
+		framebuffer_write_colors(&colors[y * lcddevice->_width], lcddevice->_width * count, false);
+	}
+}
+
+void framebuffer_DrawFillRect(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color) {
+	if (x1 >= lcddevice->_width) {ESP_LOGE(TAG, "ERROR"); return;}
+	if (x2 >= lcddevice->_width) x2=lcddevice->_width-1;
+	if (y1 >= lcddevice->_height) {ESP_LOGE(TAG, "ERROR"); return;}
+	if (y2 >= lcddevice->_height) y2=lcddevice->_height-1;
+
+	framebuffer_setpos(x1 + lcddevice->_offsetx, x2 + lcddevice->_offsetx, y1 + lcddevice->_offsety, y2 + lcddevice->_offsety);
+	framebuffer_write_colors(&color, (x2-x1+1) * (y2-y1+1), true);
+}
+
+void framebuffer_DisplayOff() {
+	framebuffer_command(0);
+	display_on = false;
+}
+
+void framebuffer_DisplayOn() {
+	framebuffer_command(0);
+	display_on = true;
+}
+
+void framebuffer_InversionOff() {
+	framebuffer_command(0);
+	inverted = false;
+}
+
+void framebuffer_InversionOn() {
+	framebuffer_command(0);
+	inverted = true;
+}
+
+void framebuffer_frame_done()
+{
+	char path[FRAMEBUFFER_PATH_MAX];
+	rotation_t rotation;
+	bool dump = false;
+
+	taskENTER_CRITICAL(&fbLock);
+	stats.frames++;
+	stats.frame_wire_ns_last = stats.wire_ns - frame_start_ns;
+	if (stats.frame_wire_ns_last > stats.frame_wire_ns_max) {
+		stats.frame_wire_ns_max = stats.frame_wire_ns_last;
+	}
+	frame_start_ns = stats.wire_ns;
+	uint64_t frame = stats.frames;
+	if (dump_requested) {
+		memcpy(path, dump_path, sizeof(path));
+		rotation = dump_rotation;
+		dump_requested = false;
+		dump = true;
+	}
+	taskEXIT_CRITICAL(&fbLock);
+
+	framebuffer_wait_wire(0);
+	if (dump) {
+		if (framebuffer_dump(path, rotation)) {
+			ESP_LOGI(TAG, "Frame %llu written to %s", (unsigned long long)frame, path);
+		} else {
+			ESP_LOGE(TAG, "Frame %llu could not be written to %s", (unsigned long long)frame, path);
+		}
+	}
+}
+
+void framebuffer_get_stats(framebuffer_stats *copy)
+{
+	taskENTER_CRITICAL(&fbLock);
+	*copy = stats;
+	taskEXIT_CRITICAL(&fbLock);
+}
+
+void framebuffer_reset_stats()
+{
+	taskENTER_CRITICAL(&fbLock);
+	memset(&stats, 0, sizeof(stats));
+	frame_start_ns = 0;
+	taskEXIT_CRITICAL(&fbLock);
+}
+
+void framebuffer_request_dump(const char *path, rotation_t rotation)
+{
+	taskENTER_CRITICAL(&fbLock);
+	strncpy(dump_path, path, sizeof(dump_path) - 1);
+	dump_path[sizeof(dump_path) - 1] = '\0';
+	dump_rotation = rotation;
+	dump_requested = true;
+	taskEXIT_CRITICAL(&fbLock);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   PPM and PNG output                                                                                                */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static void framebuffer_row_rgb(uint16_t y, uint16_t width, rotation_t rotation, uint8_t *rgb)
+{
+	//screen coordinates to the panel like lcdDrawPixel, RGB565 widened to 8 bits per channel
+	uint16_t w = lcddevice->_width, h = lcddevice->_height;
+	for (uint16_t x = 0; x < width; x++) {
+		uint16_t _x = x, _y = y;
+		switch (rotation) {
+		case rot_0: break;
+		case rot_90: _x = w - y - 1; _y = x; break;
+		case rot_180: _x = w - x - 1; _y = h - y - 1; break;
+		case rot_270: _x = y; _y = h - x - 1; break;
+		}
+		uint16_t color = display_on ? panel[(_y * w) + _x] : BLACK;
+		if (inverted) {
+			color = ~color;
+		}
+		uint8_t r = (color >> 11) & 0x1F, g = (color >> 5) & 0x3F, b = color & 0x1F;
+		rgb[(x*3)+0] = (r << 3) | (r >> 2);
+		rgb[(x*3)+1] = (g << 2) | (g >> 4);
+		rgb[(x*3)+2] = (b << 3) | (b >> 2);
+	}
+}
+
+static uint32_t png_crc(uint32_t crc, const uint8_t *data, size_t len)
+{
+	static uint32_t table[256];
+	if (table[1] == 0) {
+		for (uint32_t n = 0; n < 256; n++) {
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++) {
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			table[n] = c;
+		}
+	}
+	for (size_t i = 0; i < len; i++) {
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+static void png_put32(uint8_t *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static void png_chunk(FILE *f, const char *type, const uint8_t *data, uint32_t len)
+{
+	uint8_t word[4];
+	png_put32(word, len);
+	fwrite(word, 1, 4, f);
+	fwrite(type, 1, 4, f);
+	fwrite(data, 1, len, f);
+	png_put32(word, ~png_crc(png_crc(0xFFFFFFFFu, (const uint8_t *)type, 4), data, len));
+	fwrite(word, 1, 4, f);
+}
+
+static bool framebuffer_write_png(FILE *f, uint16_t width, uint16_t height, rotation_t rotation)
+{
+	//filter type 0 on every row, zlib with stored blocks only: larger files, no deflate implementation needed
+	uint32_t rowlen = 1 + width * 3;
+	uint32_t rawlen = rowlen * height;
+	uint32_t blocks = (rawlen + PNG_STORED_BLOCK - 1) / PNG_STORED_BLOCK;
+	uint32_t zlen = 2 + blocks * 5 + rawlen + 4;
+	uint8_t *raw = malloc(rawlen);
+	uint8_t *z = malloc(zlen);
+	if (raw == NULL || z == NULL) {
+		free(raw);
+		free(z);
+		return false;
+	}
+	for (uint16_t y = 0; y < height; y++) {
+		raw[y * rowlen] = 0;
+		framebuffer_row_rgb(y, width, rotation, &raw[(y * rowlen) + 1]);
+	}
+
+	uint32_t a = 1, b = 0;
+	for (uint32_t i = 0; i < rawlen; i++) {
+		a = (a + raw[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	uint8_t *p = z;
+	*p++ = 0x78;
+	*p++ = 0x01;
+	for (uint32_t pos = 0; pos < rawlen; pos += PNG_STORED_BLOCK) {
+		uint16_t len = (rawlen - pos < PNG_STORED_BLOCK) ? rawlen - pos : PNG_STORED_BLOCK;
+		*p++ = (pos + len == rawlen) ? 1 : 0;
+		*p++ = len & 0xFF;
+		*p++ = len >> 8;
+		*p++ = ~len & 0xFF;
+		*p++ = (uint16_t)~len >> 8;
+		memcpy(p, &raw[pos], len);
+		p += len;
+	}
+	png_put32(p, (b << 16) | a);
+
+	static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	uint8_t ihdr[13] = {0};
+	png_put32(&ihdr[0], width);
+	png_put32(&ihdr[4], height);
+	ihdr[8] = 8;	//bits per channel
+	ihdr[9] = 2;	//RGB
+	fwrite(signature, 1, sizeof(signature), f);
+	png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+	png_chunk(f, "IDAT", z, zlen);
+	png_chunk(f, "IEND", NULL, 0);
+	free(raw);
+	free(z);
+	return true;
+}
+
+bool framebuffer_dump(const char *path, rotation_t rotation)
+{
+	if (panel == NULL) {
+		return false;
+	}
+	bool rotated = (rotation == rot_90 || rotation == rot_270);
+	uint16_t width = rotated ? lcddevice->_height : lcddevice->_width;
+	uint16_t height = rotated ? lcddevice->_width : lcddevice->_height;
+	FILE *f = fopen(path, "wb");
+	if (f == NULL) {
+		return false;
+	}
+	bool ok = true;
+	size_t len = strlen(path);
+	if (len >= 4 && strcmp(&path[len - 4], ".png") == 0) {
+		ok = framebuffer_write_png(f, width, height, rotation);
+	} else {
+		uint8_t rgb[width * 3];
+		fprintf(f, "P6\n%u %u\n255\n", width, height);
+		for (uint16_t y = 0; y < height; y++) {
+			framebuffer_row_rgb(y, width, rotation, rgb);
+			fwrite(rgb, 1, sizeof(rgb), f);
+		}
+	}
+	return (fclose(f) == 0) && ok;
+}
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "lcdDriver.h"
+
+// Panel in RAM in place of the ST7789/ILI9488 (CONFIG_LCD_FRAMEBUFFER), for host builds without a display.
+// The pixels are kept in RGB565, the SPI transfers the ILI9488 driver would send are counted and priced
+// with CONFIG_FRAMEBUFFER_TRANSACTION_NS per transaction plus the bytes at CONFIG_FRAMEBUFFER_SPI_FREQUENCY.
+
+typedef struct {
+	uint64_t frames;				//lcdUpdateVScreen calls
+	uint64_t transactions;
+	uint64_t cmd_transactions;		//sent with DC low
+	uint64_t bytes;
+	uint64_t pixel_bytes;
+	uint64_t wire_ns;				//modeled time on the bus
+	uint64_t frame_wire_ns_last;	//of the last frame, from the end of the frame before
+	uint64_t frame_wire_ns_max;
+} framebuffer_stats;
+
+extern TFT_t * lcddevice;
+
+void framebuffer_init(TFT_t * dev, int width, int height, int offsetx, int offsety);
+
+void framebuffer_DrawPixel(uint16_t x, uint16_t y, uint16_t color);
+void framebuffer_DrawMultiPixels(uint16_t x, uint16_t y, uint16_t size, uint16_t * colors);
+void framebuffer_DrawArea(uint16_t x, uint16_t y, uint16_t size_x, uint16_t size_y, uint16_t * colors);
+void framebuffer_DrawMultiLines(uint16_t start_y, uint16_t lines, uint16_t * colors);
+void framebuffer_DrawFillRect(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color);
+void framebuffer_DisplayOff();
+void framebuffer_DisplayOn();
+void framebuffer_InversionOff();
+void framebuffer_InversionOn();
+
+// End of a frame, called by lcdUpdateVScreen. Writes a requested dump.
+void framebuffer_frame_done();
+
+void framebuffer_get_stats(framebuffer_stats *stats);
+void framebuffer_reset_stats();
+
+// Writes the panel as seen with the given vScreen rotation, a path ending in .png gives a PNG, else a binary PPM.
+// Only from the drawing task or while nothing draws, framebuffer_request_dump is safe from any task.
+bool framebuffer_dump(const char *path, rotation_t rotation);
+// The next finished frame is written by framebuffer_frame_done.
+void framebuffer_request_dump(const char *path, rotation_t rotation);
@@ -9,6 +9,9 @@
 #ifdef CONFIG_LCD_ILI9488
 #include "ili9488.h"
 #endif
+#ifdef CONFIG_LCD_FRAMEBUFFER
+#include "framebuffer.h"
+#endif
 
 #define TAG "lcdDriver"
 
@@ -89,6 +92,9 @@ void lcd_init()
 	ili9488_spi_master_init(&dev, GPIO_MOSI, GPIO_SCK, GPIO_LCD_CS, GPIO_LCD_DC, GPIO_GENERAL_RESET, -1);
 	ili9488_init(&dev, CONFIG_WIDTH, CONFIG_HEIGHT, CONFIG_OFFSET_WIDTH, CONFIG_OFFSET_HEIGHT);
 #endif
+#ifdef CONFIG_LCD_FRAMEBUFFER
+	framebuffer_init(&dev, CONFIG_WIDTH, CONFIG_HEIGHT, CONFIG_OFFSET_WIDTH, CONFIG_OFFSET_HEIGHT);
+#endif
 }
 
 /*---------------------------------------------------------------------------------------------------------------------*/
@@ -205,6 +211,9 @@ void diffupdate_updateDiffLCD() {
 					#ifdef CONFIG_LCD_ILI9488
 					ili9488_DrawArea(x1, y1, sizex, sizey, &colors[0]);
 					#endif
+					#ifdef CONFIG_LCD_FRAMEBUFFER
+					framebuffer_DrawArea(x1, y1, sizex, sizey, &colors[0]);
+					#endif
 				}
 			}
 		}
@@ -281,6 +290,9 @@ void lcdUpdateVScreen()
 #ifdef CONFIG_LCD_ILI9488
 	ili9488_DrawMultiLines(0, 480, &vScreen.data1[0]);
 #endif
+#ifdef CONFIG_LCD_FRAMEBUFFER
+	framebuffer_DrawMultiLines(0, lcddevice->_height, &vScreen.data1[0]);
+#endif
 #else
 	// Create Diffmap and update Selected Areas.	
 	xSemaphoreTake(vScreen.diffupdate_lock, portMAX_DELAY);
@@ -288,6 +300,9 @@ void lcdUpdateVScreen()
 	xSemaphoreGive(vScreen.diffupdate_lock);
 	diffupdate_updateDiffLCD();
 #endif
+#ifdef CONFIG_LCD_FRAMEBUFFER
+	framebuffer_frame_done();
+#endif
 }
 
 // Draw pixel
@@ -308,6 +323,9 @@ void lcdDrawPixel(uint16_t x, uint16_t y, uint16_t color)
 #endif
 #ifdef CONFIG_LCD_ILI9488
 		ili9488_DrawPixel(x, y, color);
+#endif
+#ifdef CONFIG_LCD_FRAMEBUFFER
+		framebuffer_DrawPixel(x, y, color);
 #endif
 	}
 	else
@@ -360,6 +378,9 @@ void lcdDrawMultiPixels(uint16_t x, uint16_t y, uint16_t size, uint16_t *colors)
 #endif
 #ifdef CONFIG_LCD_ILI9488
 		ili9488_DrawMultiPixels(x, y, size, colors);
+#endif
+#ifdef CONFIG_LCD_FRAMEBUFFER
+		framebuffer_DrawMultiPixels(x, y, size, colors);
 #endif
 	}
 	else
@@ -433,6 +454,9 @@ void lcdDrawFillRect(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_
 #endif
 #ifdef CONFIG_LCD_ILI9488
 		ili9488_DrawFillRect(x1, y1, x2, y2, color);
+#endif
+#ifdef CONFIG_LCD_FRAMEBUFFER
+		framebuffer_DrawFillRect(x1, y1, x2, y2, color);
 #endif
 	}
 	else
@@ -460,6 +484,9 @@ void lcdDisplayOff()
 #ifdef CONFIG_LCD_ILI9488
 	ili9488_DisplayOff();
 #endif
+#ifdef CONFIG_LCD_FRAMEBUFFER
+	framebuffer_DisplayOff();
+#endif
 }
 
 // Display ON
@@ -471,6 +498,9 @@ void lcdDisplayOn()
 #ifdef CONFIG_LCD_ILI9488
 	ili9488_DisplayOn();
 #endif
+#ifdef CONFIG_LCD_FRAMEBUFFER
+	framebuffer_DisplayOn();
+#endif
 }
 
 // Fill screen
@@ -1107,6 +1137,9 @@ void lcdInversionOff()
 #ifdef CONFIG_LCD_ILI9488
 	ili9488_InversionOff();
 #endif
+#ifdef CONFIG_LCD_FRAMEBUFFER
+	framebuffer_InversionOff();
+#endif
 }
 
 // Display Inversion On
@@ -1118,6 +1151,9 @@ void lcdInversionOn()
 #ifdef CONFIG_LCD_ILI9488
 	ili9488_InversionOn();
 #endif
+#ifdef CONFIG_LCD_FRAMEBUFFER
+	framebuffer_InversionOn();
+#endif
 }
 
 void lcdDrawDataUInt8(uint16_t x, uint16_t y, uint16_t width, uint8_t height, uint8_t min, uint8_t max, bool leftToRight, uint8_t *data, uint16_t color)
@@ -273,5 +273,5 @@ int32_t rotary_encoder_get_rotation(bool reset) {
 }
 void eduboard_init_rotary_encoder() {
     rotencdataLock = xSemaphoreCreateMutex();
-    xTaskCreate(rotaryEncoderTask, "rotenc_task", 2*2048, NULL, 10, NULL);
+    xTaskCreatePinnedToCore(rotaryEncoderTask, "rotenc_task", 2*2048, NULL, 10, NULL, CONFIG_BSP_TASK_CORE);
 }
\ No newline at end of file
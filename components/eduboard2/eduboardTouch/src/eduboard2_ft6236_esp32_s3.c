@@ -88,7 +88,7 @@ void eduboard_init_ft6236(void) {
     writeFT6236TouchRegister(FT6236_REG_G_MODE, 0x01); // Interrupt trigger mode
     writeFT6236TouchRegister(FT6236_REG_POINTRATE, FT6236_REFRESH_RATE_HZ); // Set Refresh Rate to 50Hz
     writeFT6236TouchRegister(FT6236_REG_CTRL, 0); // Active Mode.
-    xTaskCreate(touchupdate_task, "touch_task", 2*2048, NULL, 3, NULL);
+    xTaskCreatePinnedToCore(touchupdate_task, "touch_task", 2*2048, NULL, 3, NULL, CONFIG_BSP_TASK_CORE);
     ESP_LOGI(TAG, "Init FT6236 done.");
 }
 
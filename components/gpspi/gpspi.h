@@ -9,6 +9,9 @@ bool gpspi_write_data(spi_device_handle_t* handle, uint8_t* data, uint32_t len);
 bool gpspi_write_cmd_data(spi_device_handle_t* handle, uint8_t cmd, uint8_t* data, uint32_t len);
 bool gpspi_read_data(spi_device_handle_t* handle, uint8_t cmd, uint8_t* data, uint32_t len);
 
+// Initializes the bus once, the interrupt is allocated on the calling core. Not thread safe, the bus has to be
+// up before devices are added from several tasks
+void gpspi_init_bus(int pinMOSI, int pinMISO, int pinSCK);
 void gpspi_init(spi_device_handle_t* handle, int pinMOSI, int pinMISO, int pinSCK, int pinCS, uint32_t frequency, bool halfduplex);
 
 bool gpspi_write_data_nonblocking(spi_device_handle_t* handle, uint8_t* data, uint32_t len);
@@ -64,8 +64,28 @@ bool gpspi_read_cmd_data(spi_device_handle_t* handle, uint8_t cmd, uint8_t* data
 	return true;
 }
 
+static bool spi_initialized = false;
+
+void gpspi_init_bus(int pinMOSI, int pinMISO, int pinSCK) {
+	//the first call decides the pins, devices without MISO must not be the first ones on a shared bus
+	if(spi_initialized == false) {
+		spi_bus_config_t buscfg = {
+			.mosi_io_num = pinMOSI,
+			.miso_io_num = pinMISO,
+			.sclk_io_num = pinSCK,
+			.quadwp_io_num = -1,
+			.quadhd_io_num = -1,
+			.max_transfer_sz = 0,
+			.flags = 0
+		};
+		ESP_LOGI(TAG, "init spi bus config");
+		esp_err_t ret = spi_bus_initialize( HOST_ID, &buscfg, SPI_DMA_CH_AUTO );
+		spi_initialized = true;
+		assert(ret==ESP_OK);
+	}
+}
+
 void gpspi_init(spi_device_handle_t* handle, int pinMOSI, int pinMISO, int pinSCK, int pinCS, uint32_t frequency, bool halfduplex) {
-	static bool spi_initialized = false;
     ESP_LOGI(TAG, "Init SPI Device...");
     esp_err_t ret;
     ESP_LOGI(TAG, "init cs pin");
@@ -74,22 +94,7 @@ void gpspi_init(spi_device_handle_t* handle, int pinMOSI, int pinMISO, int pinSC
 		gpio_set_direction(pinCS, GPIO_MODE_OUTPUT);
 		gpio_set_level(pinCS, 1);
     }
-    
-    spi_bus_config_t buscfg = {
-		.mosi_io_num = pinMOSI,
-		.miso_io_num = pinMISO,
-		.sclk_io_num = pinSCK,
-		.quadwp_io_num = -1,
-		.quadhd_io_num = -1,
-		.max_transfer_sz = 0,
-		.flags = 0
-	};
-	if(spi_initialized == false) {
-		ESP_LOGI(TAG, "init spi bus config");
-		ret = spi_bus_initialize( HOST_ID, &buscfg, SPI_DMA_CH_AUTO );
-		spi_initialized = true;
-		assert(ret==ESP_OK);
-	}
+    gpspi_init_bus(pinMOSI, pinMISO, pinSCK);
 
     ESP_LOGI(TAG, "init spi device config");
 	spi_device_interface_config_t devcfg;
@@ -126,7 +131,6 @@ bool gpspi_write_data_nonblocking(spi_device_handle_t* handle, uint8_t* data, ui
 	return true;
 }
 void gpspi_init_nonblocking(spi_device_handle_t* handle, int pinMOSI, int pinMISO, int pinSCK, int pinCS, uint32_t frequency, bool halfduplex) {
-	static bool spi_initialized = false;
     ESP_LOGI(TAG, "Init SPI Device nonblocking...");
     esp_err_t ret;
     ESP_LOGI(TAG, "init cs pin");
@@ -135,22 +139,7 @@ void gpspi_init_nonblocking(spi_device_handle_t* handle, int pinMOSI, int pinMIS
 		gpio_set_direction(pinCS, GPIO_MODE_OUTPUT);
 		gpio_set_level(pinCS, 1);
     }
-    
-    spi_bus_config_t buscfg = {
-		.mosi_io_num = pinMOSI,
-		.miso_io_num = pinMISO,
-		.sclk_io_num = pinSCK,
-		.quadwp_io_num = -1,
-		.quadhd_io_num = -1,
-		.max_transfer_sz = 0,
-		.flags = 0
-	};
-	if(spi_initialized == false) {
-		ESP_LOGI(TAG, "init spi bus config");
-		ret = spi_bus_initialize( HOST_ID, &buscfg, SPI_DMA_CH_AUTO );
-		spi_initialized = true;
-		assert(ret==ESP_OK);
-	}
+    gpspi_init_bus(pinMOSI, pinMISO, pinSCK);
 
     ESP_LOGI(TAG, "init spi device config");
 	spi_device_interface_config_t devcfg;
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Framing of the job server protocol
+//
+//      0xA5 0x5A | type | seq | len (u16) | payload (len bytes) | CRC-16/CCITT over type..payload (u16)
+//
+// All integers are little endian. The sync bytes are outside of ASCII, so frames can share the console UART with
+// log output: the parser skips everything up to the next sync and drops frames with a wrong CRC.
+// Replies carry the seq of the request they answer, DATA and END frames the seq of the STREAM request.
+
+#define JOBPROTO_SYNC0 0xA5
+#define JOBPROTO_SYNC1 0x5A
+#define JOBPROTO_VERSION 1
+#define JOBPROTO_MAX_PAYLOAD 256
+#define JOBPROTO_OVERHEAD 8
+#define JOBPROTO_MAX_FRAME (JOBPROTO_MAX_PAYLOAD + JOBPROTO_OVERHEAD)
+
+typedef enum {
+    // host -> board
+    JOBPROTO_PING = 0x01,       // -
+    JOBPROTO_SUBMIT = 0x02,     // method u8, cores u8, digits u32
+    JOBPROTO_CANCEL = 0x03,     // job u16
+    JOBPROTO_STATUS = 0x04,     // job u16
+    JOBPROTO_STREAM = 0x05,     // job u16, first u32, count u32, window u16 (DATA frames in flight)
+    JOBPROTO_CREDIT = 0x06,     // job u16, frames u16
+    // board -> host
+    JOBPROTO_PONG = 0x81,       // version u8, max jobs u8, max digits u32
+    JOBPROTO_ACCEPTED = 0x82,   // job u16, queue position u8
+    JOBPROTO_STATE = 0x84,      // job u16, state u8, queue position u8, digits u32, elapsed ms u32
+    JOBPROTO_DATA = 0x85,       // job u16, first u32, count u16, two digits per byte (high nibble first)
+    JOBPROTO_END = 0x86,        // job u16, digits sent u32
+    JOBPROTO_TELEMETRY = 0x87,  // unsolicited, memon sample (components/memon/include/memon.h)
+    JOBPROTO_ERROR = 0xFF,      // request type u8, error u8
+} jobproto_type;
+
+typedef enum {
+    JOBPROTO_ERR_LENGTH = 1,
+    JOBPROTO_ERR_TYPE,
+    JOBPROTO_ERR_QUEUE_FULL,
+    JOBPROTO_ERR_UNKNOWN_JOB,
+    JOBPROTO_ERR_NOT_READY,
+    JOBPROTO_ERR_METHOD,
+    JOBPROTO_ERR_RANGE,
+} jobproto_error;
+
+typedef struct {
+    uint8_t type;
+    uint8_t seq;
+    uint16_t len;
+    uint8_t payload[JOBPROTO_MAX_PAYLOAD];
+} jobproto_frame;
+
+typedef struct {
+    jobproto_frame frame;
+    uint8_t header[4];          // type, seq and len, later the CRC
+    uint8_t state;
+    uint16_t pos;
+    uint16_t crc;
+    uint32_t crc_errors;
+    uint32_t skipped;           // bytes outside of frames, e.g. log output
+} jobproto_parser;
+
+void jobproto_parser_init(jobproto_parser *p);
+// Feeds one byte, returns true when p->frame holds a complete frame with a valid CRC
+bool jobproto_parse(jobproto_parser *p, uint8_t byte);
+
+// Writes a frame to out (JOBPROTO_MAX_FRAME bytes) and returns its length
+size_t jobproto_encode(uint8_t type, uint8_t seq, const void *payload, uint16_t len, uint8_t *out);
+
+uint16_t jobproto_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+void jobproto_put_u16(uint8_t *p, uint16_t value);
+void jobproto_put_u32(uint8_t *p, uint32_t value);
+uint16_t jobproto_get_u16(const uint8_t *p);
+uint32_t jobproto_get_u32(const uint8_t *p);
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "jobproto.h"
+
+// Job server on top of jobproto, independent of the transport and of the code computing the jobs.
+//
+// The transport task calls jobserver_poll in a loop. It answers requests and sends DATA frames of the active stream
+// while the host has granted credits (one credit per DATA frame), so a host that cannot keep up with the baud rate
+// never loses digits. A worker fetches queued jobs with jobserver_next_job and hands the digits back with
+// jobserver_job_done. Both sides share the job table under the lock of the backend.
+
+#define JOBSERVER_MAX_JOBS 8
+#define JOBSERVER_MAX_DIGITS 100000
+#define JOBSERVER_DATA_DIGITS 480           // digits per DATA frame, two per byte
+
+typedef enum {
+    JOBSERVER_FREE,
+    JOBSERVER_QUEUED,
+    JOBSERVER_RUNNING,
+    JOBSERVER_DONE,
+    JOBSERVER_CANCELLED,
+    JOBSERVER_FAILED,
+} jobserver_state;
+
+typedef struct {
+    uint16_t id;
+    uint8_t method;
+    uint8_t cores;
+    uint32_t digits;
+    jobserver_state state;
+    uint32_t queued_ms;
+    uint32_t elapsed_ms;                    // queue to done
+    char *result;                           // fractional digits as ASCII, owned by the job
+    uint32_t result_digits;
+} jobserver_job;
+
+typedef struct {
+    // read waits at most a few ms and returns the number of bytes read, write returns the number of bytes written
+    int (*read)(void *ctx, uint8_t *buf, size_t len);
+    int (*write)(void *ctx, const uint8_t *buf, size_t len);
+    uint32_t (*millis)(void *ctx);
+    void (*lock)(void *ctx);
+    void (*unlock)(void *ctx);
+    // method is checked when a job is submitted
+    bool (*method_valid)(void *ctx, uint8_t method, uint8_t cores, uint32_t digits);
+    // a job was queued
+    void (*wake)(void *ctx);
+} jobserver_ops;
+
+typedef struct {
+    uint16_t job;
+    uint8_t seq;
+    uint32_t next;                          // next digit to send
+    uint32_t end;
+    uint32_t credits;
+    bool active;
+} jobserver_stream;
+
+typedef struct {
+    const jobserver_ops *ops;
+    void *ctx;
+    jobproto_parser parser;
+    jobserver_job jobs[JOBSERVER_MAX_JOBS];
+    jobserver_stream stream;
+    uint16_t next_id;
+    uint32_t frames_in;
+    uint32_t frames_out;
+} jobserver;
+
+void jobserver_init(jobserver *srv, const jobserver_ops *ops, void *ctx);
+
+// Reads what the transport has, answers complete frames and sends DATA frames the host has credits for
+void jobserver_poll(jobserver *srv);
+
+// Worker side: the oldest queued job is marked running and copied to job, false if the queue is empty
+bool jobserver_next_job(jobserver *srv, jobserver_job *job);
+// Result of a job, result is taken over (malloc'd, may be NULL if failed). Cancelled jobs drop the result.
+void jobserver_job_done(jobserver *srv, uint16_t id, char *result, uint32_t result_digits);
+// true if the job has been cancelled in the meantime, workers can poll this between steps
+bool jobserver_job_cancelled(jobserver *srv, uint16_t id);
+
+const char *jobserver_state_name(jobserver_state state);
@@ -0,0 +1,129 @@
+#include "../jobproto.h"
+
+#include <string.h>
+
+enum {
+    WAIT_SYNC0,
+    WAIT_SYNC1,
+    READ_HEADER,
+    READ_PAYLOAD,
+    READ_CRC,
+};
+
+uint16_t jobproto_crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+    //CRC-16/CCITT-FALSE, start with 0xFFFF
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+void jobproto_put_u16(uint8_t *p, uint16_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+void jobproto_put_u32(uint8_t *p, uint32_t value)
+{
+    jobproto_put_u16(p, (uint16_t)value);
+    jobproto_put_u16(p + 2, (uint16_t)(value >> 16));
+}
+
+uint16_t jobproto_get_u16(const uint8_t *p)
+{
+    return p[0] | ((uint16_t)p[1] << 8);
+}
+
+uint32_t jobproto_get_u32(const uint8_t *p)
+{
+    return jobproto_get_u16(p) | ((uint32_t)jobproto_get_u16(p + 2) << 16);
+}
+
+void jobproto_parser_init(jobproto_parser *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->state = WAIT_SYNC0;
+}
+
+bool jobproto_parse(jobproto_parser *p, uint8_t byte)
+{
+    uint8_t *header = p->header;
+
+    switch (p->state) {
+    case WAIT_SYNC0:
+        if (byte == JOBPROTO_SYNC0) {
+            p->state = WAIT_SYNC1;
+        } else {
+            p->skipped++;
+        }
+        return false;
+    case WAIT_SYNC1:
+        if (byte == JOBPROTO_SYNC1) {
+            p->state = READ_HEADER;
+            p->pos = 0;
+        } else {
+            p->skipped += 2;
+            p->state = (byte == JOBPROTO_SYNC0) ? WAIT_SYNC1 : WAIT_SYNC0;
+        }
+        return false;
+    case READ_HEADER:
+        header[p->pos++] = byte;
+        if (p->pos == sizeof(p->header)) {
+            p->frame.type = header[0];
+            p->frame.seq = header[1];
+            p->frame.len = jobproto_get_u16(&header[2]);
+            p->crc = jobproto_crc16(0xFFFF, header, sizeof(p->header));
+            p->pos = 0;
+            if (p->frame.len > JOBPROTO_MAX_PAYLOAD) {
+                p->crc_errors++;
+                p->state = WAIT_SYNC0;
+            } else {
+                p->state = (p->frame.len > 0) ? READ_PAYLOAD : READ_CRC;
+            }
+        }
+        return false;
+    case READ_PAYLOAD:
+        p->frame.payload[p->pos++] = byte;
+        if (p->pos == p->frame.len) {
+            p->crc = jobproto_crc16(p->crc, p->frame.payload, p->frame.len);
+            p->pos = 0;
+            p->state = READ_CRC;
+        }
+        return false;
+    case READ_CRC:
+        header[p->pos++] = byte;
+        if (p->pos < 2) {
+            return false;
+        }
+        p->state = WAIT_SYNC0;
+        if (jobproto_get_u16(header) != p->crc) {
+            p->crc_errors++;
+            return false;
+        }
+        return true;
+    }
+    p->state = WAIT_SYNC0;
+    return false;
+}
+
+size_t jobproto_encode(uint8_t type, uint8_t seq, const void *payload, uint16_t len, uint8_t *out)
+{
+    if (len > JOBPROTO_MAX_PAYLOAD) {
+        return 0;
+    }
+    out[0] = JOBPROTO_SYNC0;
+    out[1] = JOBPROTO_SYNC1;
+    out[2] = type;
+    out[3] = seq;
+    jobproto_put_u16(&out[4], len);
+    if (len > 0) {
+        memcpy(&out[6], payload, len);
+    }
+    jobproto_put_u16(&out[6 + len], jobproto_crc16(0xFFFF, &out[2], 4 + len));
+    return JOBPROTO_OVERHEAD + len;
+}
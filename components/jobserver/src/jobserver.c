@@ -0,0 +1,307 @@
+#include "../jobserver.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define JOBSERVER_DATA_FRAMES_PER_POLL 4    // keeps the request path responsive while streaming
+
+static const char *state_names[] = {"free", "queued", "running", "done", "cancelled", "failed"};
+
+const char *jobserver_state_name(jobserver_state state)
+{
+    return (state <= JOBSERVER_FAILED) ? state_names[state] : "?";
+}
+
+void jobserver_init(jobserver *srv, const jobserver_ops *ops, void *ctx)
+{
+    memset(srv, 0, sizeof(*srv));
+    srv->ops = ops;
+    srv->ctx = ctx;
+    srv->next_id = 1;
+    jobproto_parser_init(&srv->parser);
+}
+
+static bool older(const jobserver_job *a, const jobserver_job *b)
+{
+    //ids wrap around, compare the distance
+    return (int16_t)(a->id - b->id) < 0;
+}
+
+static jobserver_job *find_job(jobserver *srv, uint16_t id)
+{
+    for (int i = 0; i < JOBSERVER_MAX_JOBS; i++) {
+        if (srv->jobs[i].state != JOBSERVER_FREE && srv->jobs[i].id == id) {
+            return &srv->jobs[i];
+        }
+    }
+    return NULL;
+}
+
+static jobserver_job *alloc_job(jobserver *srv)
+{
+    //a free slot, otherwise the oldest finished job that is not being streamed
+    jobserver_job *victim = NULL;
+    for (int i = 0; i < JOBSERVER_MAX_JOBS; i++) {
+        jobserver_job *job = &srv->jobs[i];
+        if (job->state == JOBSERVER_FREE) {
+            return job;
+        }
+        bool finished = job->state == JOBSERVER_DONE || job->state == JOBSERVER_CANCELLED || job->state == JOBSERVER_FAILED;
+        bool streaming = srv->stream.active && srv->stream.job == job->id;
+        if (finished && !streaming && (victim == NULL || older(job, victim))) {
+            victim = job;
+        }
+    }
+    if (victim != NULL) {
+        free(victim->result);
+        memset(victim, 0, sizeof(*victim));
+    }
+    return victim;
+}
+
+static uint8_t queue_position(jobserver *srv, const jobserver_job *job)
+{
+    uint8_t pos = 0;
+    for (int i = 0; i < JOBSERVER_MAX_JOBS; i++) {
+        if (srv->jobs[i].state == JOBSERVER_QUEUED && older(&srv->jobs[i], job)) {
+            pos++;
+        }
+    }
+    return pos;
+}
+
+static void send_frame(jobserver *srv, uint8_t type, uint8_t seq, const uint8_t *payload, uint16_t len)
+{
+    uint8_t buf[JOBPROTO_MAX_FRAME];
+    size_t size = jobproto_encode(type, seq, payload, len, buf);
+    size_t done = 0;
+    while (done < size) {
+        int n = srv->ops->write(srv->ctx, &buf[done], size - done);
+        if (n <= 0) {
+            return;
+        }
+        done += n;
+    }
+    srv->frames_out++;
+}
+
+static uint16_t encode_state(jobserver *srv, const jobserver_job *job, uint8_t *out)
+{
+    jobproto_put_u16(&out[0], job->id);
+    out[2] = job->state;
+    out[3] = (job->state == JOBSERVER_QUEUED) ? queue_position(srv, job) : 0;
+    jobproto_put_u32(&out[4], (job->state == JOBSERVER_DONE) ? job->result_digits : job->digits);
+    jobproto_put_u32(&out[8], (job->state == JOBSERVER_QUEUED || job->state == JOBSERVER_RUNNING)
+                                  ? srv->ops->millis(srv->ctx) - job->queued_ms : job->elapsed_ms);
+    return 12;
+}
+
+static void handle_frame(jobserver *srv, const jobproto_frame *f)
+{
+    static const uint8_t request_len[] = {
+        [JOBPROTO_PING] = 0, [JOBPROTO_SUBMIT] = 6, [JOBPROTO_CANCEL] = 2,
+        [JOBPROTO_STATUS] = 2, [JOBPROTO_STREAM] = 12, [JOBPROTO_CREDIT] = 4,
+    };
+    uint8_t reply[16];
+    uint8_t reply_type = JOBPROTO_ERROR;
+    uint16_t reply_len = 0;
+    uint8_t error = 0;
+    bool wake = false;
+
+    if (f->type < JOBPROTO_PING || f->type > JOBPROTO_CREDIT) {
+        error = JOBPROTO_ERR_TYPE;
+    } else if (f->len != request_len[f->type]) {
+        error = JOBPROTO_ERR_LENGTH;
+    }
+
+    srv->ops->lock(srv->ctx);
+    jobserver_job *job = (!error && f->type != JOBPROTO_PING && f->type != JOBPROTO_SUBMIT)
+                             ? find_job(srv, jobproto_get_u16(f->payload)) : NULL;
+    if (!error && f->type != JOBPROTO_PING && f->type != JOBPROTO_SUBMIT && job == NULL) {
+        error = JOBPROTO_ERR_UNKNOWN_JOB;
+    }
+
+    if (!error) {
+        switch (f->type) {
+        case JOBPROTO_PING:
+            reply_type = JOBPROTO_PONG;
+            reply[0] = JOBPROTO_VERSION;
+            reply[1] = JOBSERVER_MAX_JOBS;
+            jobproto_put_u32(&reply[2], JOBSERVER_MAX_DIGITS);
+            reply_len = 6;
+            break;
+        case JOBPROTO_SUBMIT: {
+            uint8_t method = f->payload[0];
+            uint8_t cores = f->payload[1] ? f->payload[1] : 1;
+            uint32_t digits = jobproto_get_u32(&f->payload[2]);
+            if (digits == 0 || digits > JOBSERVER_MAX_DIGITS) {
+                error = JOBPROTO_ERR_RANGE;
+            } else if (!srv->ops->method_valid(srv->ctx, method, cores, digits)) {
+                error = JOBPROTO_ERR_METHOD;
+            } else if ((job = alloc_job(srv)) == NULL) {
+                error = JOBPROTO_ERR_QUEUE_FULL;
+            } else {
+                job->id = srv->next_id++;
+                if (srv->next_id == 0 || srv->next_id == 0xFFFF) {
+                    srv->next_id = 1;
+                }
+                job->method = method;
+                job->cores = cores;
+                job->digits = digits;
+                job->state = JOBSERVER_QUEUED;
+                job->queued_ms = srv->ops->millis(srv->ctx);
+                reply_type = JOBPROTO_ACCEPTED;
+                jobproto_put_u16(&reply[0], job->id);
+                reply[2] = queue_position(srv, job);
+                reply_len = 3;
+                wake = true;
+            }
+            break;
+        }
+        case JOBPROTO_CANCEL:
+            //a running job keeps its worker busy until the next check, its result is dropped
+            if (job->state == JOBSERVER_QUEUED || job->state == JOBSERVER_RUNNING) {
+                job->state = JOBSERVER_CANCELLED;
+                job->elapsed_ms = srv->ops->millis(srv->ctx) - job->queued_ms;
+            }
+            reply_type = JOBPROTO_STATE;
+            reply_len = encode_state(srv, job, reply);
+            break;
+        case JOBPROTO_STATUS:
+            reply_type = JOBPROTO_STATE;
+            reply_len = encode_state(srv, job, reply);
+            break;
+        case JOBPROTO_STREAM: {
+            uint32_t first = jobproto_get_u32(&f->payload[2]);
+            uint32_t count = jobproto_get_u32(&f->payload[6]);
+            if (job->state != JOBSERVER_DONE) {
+                error = JOBPROTO_ERR_NOT_READY;
+            } else if (first > job->result_digits) {
+                error = JOBPROTO_ERR_RANGE;
+            } else {
+                //a new stream replaces the old one
+                if (count > job->result_digits - first) {
+                    count = job->result_digits - first;
+                }
+                srv->stream.job = job->id;
+                srv->stream.seq = f->seq;
+                srv->stream.next = first;
+                srv->stream.end = first + count;
+                srv->stream.credits = jobproto_get_u16(&f->payload[10]);
+                srv->stream.active = true;
+                reply_type = 0;
+            }
+            break;
+        }
+        case JOBPROTO_CREDIT:
+            if (srv->stream.active && srv->stream.job == job->id) {
+                srv->stream.credits += jobproto_get_u16(&f->payload[2]);
+            }
+            reply_type = 0;
+            break;
+        }
+    }
+    srv->ops->unlock(srv->ctx);
+
+    if (error) {
+        reply_type = JOBPROTO_ERROR;
+        reply[0] = f->type;
+        reply[1] = error;
+        reply_len = 2;
+    }
+    if (reply_type != 0) {
+        send_frame(srv, reply_type, f->seq, reply, reply_len);
+    }
+    if (wake) {
+        srv->ops->wake(srv->ctx);
+    }
+}
+
+static void pump_stream(jobserver *srv)
+{
+    //the result of a finished job never changes and its slot is not reused while it is streamed
+    jobserver_stream *s = &srv->stream;
+    uint8_t payload[8 + JOBSERVER_DATA_DIGITS / 2];
+
+    for (int frames = 0; s->active && s->credits > 0 && frames < JOBSERVER_DATA_FRAMES_PER_POLL; frames++) {
+        srv->ops->lock(srv->ctx);
+        jobserver_job *job = find_job(srv, s->job);
+        const char *digits = (job != NULL && job->state == JOBSERVER_DONE) ? job->result : NULL;
+        srv->ops->unlock(srv->ctx);
+
+        if (digits == NULL || s->next == s->end) {
+            jobproto_put_u16(&payload[0], s->job);
+            jobproto_put_u32(&payload[2], s->next);
+            send_frame(srv, JOBPROTO_END, s->seq, payload, 6);
+            s->active = false;
+            break;
+        }
+
+        uint16_t count = (s->end - s->next < JOBSERVER_DATA_DIGITS) ? s->end - s->next : JOBSERVER_DATA_DIGITS;
+        jobproto_put_u16(&payload[0], s->job);
+        jobproto_put_u32(&payload[2], s->next);
+        jobproto_put_u16(&payload[6], count);
+        memset(&payload[8], 0, (count + 1) / 2);
+        for (uint16_t i = 0; i < count; i++) {
+            uint8_t digit = digits[s->next + i] - '0';
+            payload[8 + i / 2] |= (i & 1) ? digit : digit << 4;
+        }
+        send_frame(srv, JOBPROTO_DATA, s->seq, payload, 8 + (count + 1) / 2);
+        s->next += count;
+        s->credits--;
+    }
+}
+
+void jobserver_poll(jobserver *srv)
+{
+    uint8_t buf[64];
+    int n = srv->ops->read(srv->ctx, buf, sizeof(buf));
+    for (int i = 0; i < n; i++) {
+        if (jobproto_parse(&srv->parser, buf[i])) {
+            srv->frames_in++;
+            handle_frame(srv, &srv->parser.frame);
+        }
+    }
+    pump_stream(srv);
+}
+
+bool jobserver_next_job(jobserver *srv, jobserver_job *out)
+{
+    jobserver_job *next = NULL;
+    srv->ops->lock(srv->ctx);
+    for (int i = 0; i < JOBSERVER_MAX_JOBS; i++) {
+        if (srv->jobs[i].state == JOBSERVER_QUEUED && (next == NULL || older(&srv->jobs[i], next))) {
+            next = &srv->jobs[i];
+        }
+    }
+    if (next != NULL) {
+        next->state = JOBSERVER_RUNNING;
+        *out = *next;
+    }
+    srv->ops->unlock(srv->ctx);
+    return next != NULL;
+}
+
+void jobserver_job_done(jobserver *srv, uint16_t id, char *result, uint32_t result_digits)
+{
+    srv->ops->lock(srv->ctx);
+    jobserver_job *job = find_job(srv, id);
+    if (job != NULL && job->state == JOBSERVER_RUNNING) {
+        job->state = (result != NULL) ? JOBSERVER_DONE : JOBSERVER_FAILED;
+        job->result = result;
+        job->result_digits = (result != NULL) ? result_digits : 0;
+        job->elapsed_ms = srv->ops->millis(srv->ctx) - job->queued_ms;
+        result = NULL;
+    }
+    srv->ops->unlock(srv->ctx);
+    free(result);
+}
+
+bool jobserver_job_cancelled(jobserver *srv, uint16_t id)
+{
+    srv->ops->lock(srv->ctx);
+    jobserver_job *job = find_job(srv, id);
+    bool cancelled = (job == NULL) || (job->state == JOBSERVER_CANCELLED);
+    srv->ops->unlock(srv->ctx);
+    return cancelled;
+}
@@ -0,0 +1,41 @@
+#ifndef MEMLAT_H
+#define MEMLAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Points an input passes on its way to the screen, in this order. Every point is stamped once,
+// a stamp is ignored until the point before it has been stamped. MEMLAT_PRESSED starts a new input.
+typedef enum {
+    MEMLAT_PRESSED,             // the button driver has classified the press
+    MEMLAT_POLLED,              // the application has taken the button state
+    MEMLAT_HANDLING,            // the input handler woke up
+    MEMLAT_HANDLED,             // the input has changed the application state
+    MEMLAT_SNAPSHOT,            // the display has read the changed state
+    MEMLAT_FLUSHED,             // the frame showing it is on the LCD
+    MEMLAT_POINTS
+} memlat_point;
+
+// Stages between two points, the last one is the whole way
+#define MEMLAT_STAGES            MEMLAT_POINTS
+#define MEMLAT_TOTAL             (MEMLAT_POINTS - 1)
+#define MEMLAT_BUCKETS           12      //bucket b counts latencies below 2^b ms, the last one the rest
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[MEMLAT_BUCKETS];
+} memlat_histogram;
+
+// Stamps the point with the esp_timer time time_us, safe from any task
+void memlat_stamp(memlat_point point, int64_t time_us);
+void memlat_stamp_now(memlat_point point);
+// Copy of the histogram of stage, stage MEMLAT_TOTAL is the whole way from MEMLAT_PRESSED to MEMLAT_FLUSHED
+void memlat_get(int stage, memlat_histogram *histogram);
+const char *memlat_stage_name(int stage);
+void memlat_reset(void);
+// Appends the histograms to buf as text, returns the number of characters written
+size_t memlat_report(char *buf, size_t size);
+
+#endif
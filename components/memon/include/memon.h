@@ -3,12 +3,41 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/uart.h"
 
 #define MEMON_BASE_UPDATERATE_S      3
+#define MEMON_MAX_UPDATERATE_S       48      //the period doubles up to here while memon exceeds its CPU budget
+#define MEMON_MAX_OVERHEAD_PERMILLE  10      //CPU budget of memon itself, per mille of one core
+#define MEMON_MAX_TASKS              32      //tasks beyond are not sampled, all buffers are sized at compile time
+#define MEMON_FRAME_TASKS            29      //tasks in one telemetry frame, fills JOBPROTO_MAX_PAYLOAD
+#ifndef MEMON_TASK_CORE
+#define MEMON_TASK_CORE              0       //keeps the monitor away from cores running benchmarks
+#endif
+
+#define MEMON_OUTPUT_TEXT            (1 << 0)   //report on the console log
+#define MEMON_OUTPUT_FRAME           (1 << 1)   //JOBPROTO_TELEMETRY frame on the console UART
+#define MEMON_FRAME_UART             UART_NUM_0 //written through the UART driver, which has to be installed
+
+// Telemetry frame, a JOBPROTO_TELEMETRY frame of components/jobserver with the sample number as seq:
+//
+//      version u8 | cores u8 | tasks u8 | interval ms u16 | uptime ms u32 | free heap u32 | min free heap u32 |
+//      load u16 per core | memon us u16 | tasks * (number u16 | core u8 | prio u8 | load u16 | stack free u16)
+//
+// Loads are per mille of one core over the last interval, core 0xFF is a task without affinity.
+// memon us is the CPU time memon spent on the last sample and report.
+#define MEMON_FRAME_VERSION          1
+#define MEMON_FRAME_HEADER(cores)    (19 + 2 * (cores))
+#define MEMON_FRAME_TASK_SIZE        8
 
 void memon_enable();
 void memon_disable();
 void memon_setUpdateTime(uint8_t updateTime_s);
+void memon_setOutput(uint8_t outputs);
+// Frames go to uart under writeLock, the lock of the other task sending frames there (NULL if there is none)
+void memon_setFrameOutput(uart_port_t uart, SemaphoreHandle_t writeLock);
+// Copies the telemetry frame of the last sample, returns its length or 0 if there is none yet
+size_t memon_getFrame(uint8_t *buf, size_t len);
 void initMemon(void);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,28 @@
+#ifndef MEMPROF_H
+#define MEMPROF_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define MEMPROF_SAMPLE_MS            250     //peaks of the heap are sampled, stack high-water marks are exact
+#define MEMPROF_MAX_TASKS            48      //tasks seen over a run including deleted ones, all buffers are sized at compile time
+#define MEMPROF_MAX_BUDGETS          16
+#define MEMPROF_STACK_RESERVE        512     //bytes kept above the peak when the report suggests a smaller stack
+#define MEMPROF_TASK_PRIO            3
+#ifndef MEMON_TASK_CORE
+#define MEMON_TASK_CORE              0
+#endif
+
+// Configured stack size of all tasks whose name starts with prefix, the report compares it with the peak.
+// Tasks without a budget are listed without a size.
+void memprof_set_stack_budget(const char *prefix, uint32_t stack_size);
+// Forgets all peaks and starts a new run
+void memprof_start(void);
+void memprof_stop(void);
+// Takes one sample, the profiler task calls it every MEMPROF_SAMPLE_MS while running
+void memprof_sample(void);
+// Prints the budget report of the run on the console
+void memprof_report(void);
+void initMemprof(void);
+
+#endif
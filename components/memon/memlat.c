@@ -0,0 +1,93 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "memlat.h"
+
+static const char *stage_names[MEMLAT_STAGES] = {"Button poll", "Event group", "Handler", "Display wait", "Draw+flush", "Total"};
+
+// one input is followed at a time, a new press drops an input which has not reached the screen
+static int64_t stamps[MEMLAT_POINTS];
+static memlat_histogram histograms[MEMLAT_STAGES];
+static portMUX_TYPE memlatLock = portMUX_INITIALIZER_UNLOCKED;
+
+static void addSample(memlat_histogram *histogram, int64_t latency_us) {
+    uint32_t us = (latency_us < 0) ? 0 : (latency_us > UINT32_MAX) ? UINT32_MAX : latency_us;
+    uint32_t ms = us / 1000;
+    int bucket = 0;
+    while (bucket < MEMLAT_BUCKETS - 1 && ms >= (1u << bucket)) {
+        bucket++;
+    }
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->sum_us += us;
+    if (us > histogram->max_us) {
+        histogram->max_us = us;
+    }
+}
+
+void memlat_stamp(memlat_point point, int64_t time_us) {
+    taskENTER_CRITICAL(&memlatLock);
+    if (point == MEMLAT_PRESSED) {
+        memset(stamps, 0, sizeof(stamps));
+        stamps[MEMLAT_PRESSED] = time_us;
+    } else if (stamps[point - 1] != 0 && stamps[point] == 0) {
+        stamps[point] = time_us;
+    }
+    if (point == MEMLAT_FLUSHED && stamps[MEMLAT_FLUSHED] != 0) {
+        for (int stage = 0; stage < MEMLAT_TOTAL; stage++) {
+            addSample(&histograms[stage], stamps[stage + 1] - stamps[stage]);
+        }
+        addSample(&histograms[MEMLAT_TOTAL], stamps[MEMLAT_FLUSHED] - stamps[MEMLAT_PRESSED]);
+        memset(stamps, 0, sizeof(stamps));
+    }
+    taskEXIT_CRITICAL(&memlatLock);
+}
+
+void memlat_stamp_now(memlat_point point) {
+    memlat_stamp(point, esp_timer_get_time());
+}
+
+void memlat_get(int stage, memlat_histogram *histogram) {
+    taskENTER_CRITICAL(&memlatLock);
+    *histogram = histograms[stage];
+    taskEXIT_CRITICAL(&memlatLock);
+}
+
+const char *memlat_stage_name(int stage) {
+    return stage_names[stage];
+}
+
+void memlat_reset(void) {
+    taskENTER_CRITICAL(&memlatLock);
+    memset(stamps, 0, sizeof(stamps));
+    memset(histograms, 0, sizeof(histograms));
+    taskEXIT_CRITICAL(&memlatLock);
+}
+
+size_t memlat_report(char *buf, size_t size) {
+    size_t len = 0;
+    memlat_histogram histogram;
+
+    memlat_get(MEMLAT_TOTAL, &histogram);
+    if (histogram.count == 0) {
+        return 0;
+    }
+    len += snprintf(&buf[len], size - len, "\n\nInput latency (%" PRIu32 " inputs)   avg[ms]   max[ms]   count below 1,2,4..%i ms and above",
+                    histogram.count, 1 << (MEMLAT_BUCKETS - 2));
+    for (int stage = 0; stage < MEMLAT_STAGES && len < size; stage++) {
+        memlat_get(stage, &histogram);
+        len += snprintf(&buf[len], size - len, "\n    %-24s %8.1lf  %8.1lf  ", stage_names[stage],
+                        histogram.sum_us / 1000.0 / histogram.count, histogram.max_us / 1000.0);
+        for (int b = 0; b < MEMLAT_BUCKETS && len < size; b++) {
+            len += snprintf(&buf[len], size - len, " %" PRIu32, histogram.buckets[b]);
+        }
+    }
+    return (len < size) ? len : size - 1;
+}
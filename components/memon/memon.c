@@ -13,58 +13,196 @@
 #include "freertos/event_groups.h"
 #include "esp_freertos_hooks.h"
 
-#include "lwip/err.h"
 #include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
 
 #include "esp_log.h"
 #include "esp_err.h"
+#include "driver/uart.h"
 
+#include "jobproto.h"
 #include "memon.h"
+#include "memlat.h"
 
 #define TAG "MEMON"
-#define MEMON_VERSION   "1.0.0"
-#define MEMON_BUFFERSIZE    2048
+#define MEMON_VERSION   "2.0.0"
+#define MEMON_BUFFERSIZE    3072
 
 EventGroupHandle_t evMemon;
 #define EV_MEMON_ENABLED    1<<0
 
 uint8_t memonUpdateTime_s = MEMON_BASE_UPDATERATE_S;
+uint8_t memonOutputs = MEMON_OUTPUT_TEXT;
+
+typedef struct {
+    TaskHandle_t handle;
+    configRUN_TIME_COUNTER_TYPE runtime;
+} memon_sample;
+
+// everything memon needs per cycle, nothing is allocated after initMemon
+static TaskStatus_t systemtasklist[MEMON_MAX_TASKS];
+static memon_sample previous[MEMON_MAX_TASKS];
+static uint32_t previouscount = 0;
+static configRUN_TIME_COUNTER_TYPE previousTotal = 0;
+static uint16_t taskload[MEMON_MAX_TASKS];
+static uint16_t coreload[portNUM_PROCESSORS];
+static char memonoutput[MEMON_BUFFERSIZE];
+static uint8_t frame[JOBPROTO_MAX_FRAME];
+static size_t framelen = 0;
+static SemaphoreHandle_t frameLock;
+static uart_port_t frameUart = MEMON_FRAME_UART;
+static SemaphoreHandle_t frameWriteLock = NULL;
+static uint8_t sampleNr = 0;
+
+static configRUN_TIME_COUNTER_TYPE previousRuntime(TaskHandle_t handle) {
+    //a new task ran only since it was created, all of its run time belongs into this interval
+    for (uint32_t i = 0; i < previouscount; i++) {
+        if (previous[i].handle == handle) {
+            return previous[i].runtime;
+        }
+    }
+    return 0;
+}
+
+static uint32_t sampleTasks(configRUN_TIME_COUNTER_TYPE *interval) {
+    //CPU share of every task and core over the time since the last sample
+    configRUN_TIME_COUNTER_TYPE total;
+    uint32_t count = uxTaskGetSystemState(systemtasklist, MEMON_MAX_TASKS, &total);
+    if (count == 0) {
+        ESP_LOGW(TAG, "More than %i tasks, raise MEMON_MAX_TASKS", MEMON_MAX_TASKS);
+        return 0;
+    }
+    //the run time counter is esp_timer based, every core gets one counter tick per tick of the total
+    *interval = total - previousTotal;
+
+    for (uint32_t i = 0; i < count; i++) {
+        configRUN_TIME_COUNTER_TYPE delta = systemtasklist[i].ulRunTimeCounter - previousRuntime(systemtasklist[i].xHandle);
+        uint32_t load = (*interval > 0) ? (uint32_t)(((uint64_t)delta * 1000) / *interval) : 0;
+        taskload[i] = (load > 1000) ? 1000 : load;
+    }
+    //core load is everything but the idle task of the core, tasks without affinity cannot be assigned otherwise
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        TaskHandle_t idle = xTaskGetIdleTaskHandleForCore(core);
+        coreload[core] = 1000;
+        for (uint32_t i = 0; i < count; i++) {
+            if (systemtasklist[i].xHandle == idle) {
+                coreload[core] = 1000 - taskload[i];
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        previous[i].handle = systemtasklist[i].xHandle;
+        previous[i].runtime = systemtasklist[i].ulRunTimeCounter;
+    }
+    previouscount = count;
+    previousTotal = total;
+    return count;
+}
+
+static void buildReport(uint32_t count, configRUN_TIME_COUNTER_TYPE interval, uint32_t overhead_us, uint32_t memonload) {
+    //bounded by the buffer, tasks beyond it are cut off
+    size_t len = 0, size = MEMON_BUFFERSIZE;
+    len += snprintf(&memonoutput[len], size - len, "\n-----------------------------------------\nMEMON-Report (%.1lf s):", interval / 1e6);
+    len += snprintf(&memonoutput[len], size - len, "\n\nActive Tasks: %i", (int)count);
+    for (int core = 0; core < portNUM_PROCESSORS && len < size; core++) {
+        len += snprintf(&memonoutput[len], size - len, "   Core %i: %5.1lf %%", core, coreload[core] / 10.0);
+    }
+    if (len < size) {
+        len += snprintf(&memonoutput[len], size - len, "\n----Name---------------- TaskNr -- Prio -- CoreID -- Stack[bytes]---CPU[%%]");
+    }
+    for (uint32_t i = 0; i < count && len < size; i++) {
+        TaskStatus_t *systemtaskstate = &systemtasklist[i];
+        uint32_t taskcoreid = (uint32_t)systemtaskstate->xCoreID;
+        //If Error here: Enable Components->FreeRTOS->"Enable FreeRTOS trace facility"->"Enable FreeRTOS stats formatting functions"->"Enable display of xCoreID in vTaskList"
+        taskcoreid = (taskcoreid > 1 ? -1 :taskcoreid);
+        len += snprintf(&memonoutput[len], size - len, "\n    %-20s %-6i    %-6i  %-6d    %-6i         %5.1lf",
+                        systemtaskstate->pcTaskName, (int)systemtaskstate->xTaskNumber, (int)systemtaskstate->uxBasePriority,
+                        (int)taskcoreid, (int)systemtaskstate->usStackHighWaterMark, taskload[i] / 10.0);
+    }
+    if (len < size) {
+        len += memlat_report(&memonoutput[len], size - len);
+    }
+    if (len < size) {
+        snprintf(&memonoutput[len], size - len, "\n\nGlobal Heap: %i bytes (minimum %i)\nMemon: %lu us per report, %.1lf %% CPU\n-----------------------------------------\n",
+                 (int)xPortGetFreeHeapSize(), (int)heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT), overhead_us, memonload / 10.0);
+    }
+}
+
+static void buildFrame(uint32_t count, configRUN_TIME_COUNTER_TYPE interval, uint32_t overhead_us) {
+    uint8_t payload[JOBPROTO_MAX_PAYLOAD];
+    uint32_t tasks = (count > MEMON_FRAME_TASKS) ? MEMON_FRAME_TASKS : count;
+    uint8_t *p = payload;
+
+    *p++ = MEMON_FRAME_VERSION;
+    *p++ = portNUM_PROCESSORS;
+    *p++ = tasks;
+    jobproto_put_u16(p, interval / 1000); p += 2;
+    jobproto_put_u32(p, esp_timer_get_time() / 1000); p += 4;
+    jobproto_put_u32(p, xPortGetFreeHeapSize()); p += 4;
+    jobproto_put_u32(p, heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT)); p += 4;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        jobproto_put_u16(p, coreload[core]); p += 2;
+    }
+    jobproto_put_u16(p, (overhead_us > UINT16_MAX) ? UINT16_MAX : overhead_us); p += 2;
+    for (uint32_t i = 0; i < tasks; i++) {
+        uint32_t taskcoreid = (uint32_t)systemtasklist[i].xCoreID;
+        jobproto_put_u16(p, systemtasklist[i].xTaskNumber); p += 2;
+        *p++ = (taskcoreid > 1) ? 0xFF : taskcoreid;
+        *p++ = systemtasklist[i].uxBasePriority;
+        jobproto_put_u16(p, taskload[i]); p += 2;
+        jobproto_put_u16(p, (systemtasklist[i].usStackHighWaterMark > UINT16_MAX) ? UINT16_MAX : systemtasklist[i].usStackHighWaterMark); p += 2;
+    }
+
+    xSemaphoreTake(frameLock, portMAX_DELAY);
+    framelen = jobproto_encode(JOBPROTO_TELEMETRY, sampleNr++, payload, p - payload, frame);
+    xSemaphoreGive(frameLock);
+}
 
 void memonTask(void* param) {
     ESP_LOGI(TAG, "MEMON startup...");
     ESP_LOGI(TAG, "MEMON Version: %s", MEMON_VERSION);
-    char* memonoutput = malloc(MEMON_BUFFERSIZE);
-    
-    TaskStatus_t* systemtasklist;
-    uint32_t systemtasklistsize = 0;
-    uint32_t totalRuntime, StatsAsPercentage;
 
-    for(;;) {        
+    configRUN_TIME_COUNTER_TYPE interval, ownRuntime = ulTaskGetRunTimeCounter(NULL), ownDelta;
+    uint32_t memonload = 0, overhead_us = 0;
+
+    for(;;) {
         xEventGroupWaitBits(evMemon, EV_MEMON_ENABLED, false, true, portMAX_DELAY);
-        uint32_t systemtasklistsize = uxTaskGetNumberOfTasks();
-        systemtasklist = malloc(systemtasklistsize * sizeof(TaskStatus_t));
-        systemtasklistsize = uxTaskGetSystemState(systemtasklist, systemtasklistsize, &totalRuntime);
-        memset(memonoutput, 0, MEMON_BUFFERSIZE);
-        sprintf(&memonoutput[0], "\n-----------------------------------------\nMEMON-Report:");
-        sprintf(&memonoutput[strlen(memonoutput)], "\n\nActive Tasks: %i", (int)systemtasklistsize);
-        sprintf(&memonoutput[strlen(memonoutput)], "\n----Name---------------- TaskNr -- Prio -- CoreID -- Stack[bytes]---Runtime[cyc/s]");
-        TaskStatus_t* systemtaskstate;
-        for(int i = 0; i < systemtasklistsize;i++) {
-            systemtaskstate = &systemtasklist[i];
-            char taskname[20];
-            uint32_t tasknumber = systemtaskstate->xTaskNumber;
-            int32_t taskprio = systemtaskstate->uxBasePriority;            
-            uint32_t runtime = systemtaskstate->ulRunTimeCounter/memonUpdateTime_s;
-            uint32_t taskstack = systemtaskstate->usStackHighWaterMark;
-            uint32_t taskcoreid = (uint32_t)systemtaskstate->xCoreID;
-            //If Error here: Enable Components->FreeRTOS->"Enable FreeRTOS trace facility"->"Enable FreeRTOS stats formatting functions"->"Enable display of xCoreID in vTaskList"
-            taskcoreid = (taskcoreid > 1 ? -1 :taskcoreid);
-            strcpy(&taskname[0], systemtaskstate->pcTaskName);
-            sprintf(&memonoutput[strlen(memonoutput)], "\n    %-20s %-6i    %-6i  %-6d    %-6i         %-9i", &taskname[0], (int)tasknumber, (int)taskprio, (int)taskcoreid, (int)taskstack, (int)runtime);
-        }sprintf(&memonoutput[strlen(memonoutput)], "\n\nGlobal Heap: %i bytes\n-----------------------------------------\n",(int)xPortGetFreeHeapSize());
-
-        ESP_LOGW(TAG, "%s", memonoutput);
-        free(systemtasklist);
+        int64_t start = esp_timer_get_time();
+
+        uint32_t systemtasklistsize = sampleTasks(&interval);
+        //memon's own CPU time since the last sample, including the console output of the last report
+        ownDelta = ulTaskGetRunTimeCounter(NULL) - ownRuntime;
+        ownRuntime += ownDelta;
+        memonload = (interval > 0) ? (uint32_t)(((uint64_t)ownDelta * 1000) / interval) : 0;
+
+        //the reports carry the sampling and formatting time of the cycle before
+        if (systemtasklistsize > 0) {
+            buildFrame(systemtasklistsize, interval, overhead_us);
+            if (memonOutputs & MEMON_OUTPUT_TEXT) {
+                buildReport(systemtasklistsize, interval, overhead_us, memonload);
+            }
+        }
+        overhead_us = esp_timer_get_time() - start;
+
+        if (systemtasklistsize > 0 && (memonOutputs & MEMON_OUTPUT_TEXT)) {
+            ESP_LOGW(TAG, "%s", memonoutput);
+        }
+        if (systemtasklistsize > 0 && (memonOutputs & MEMON_OUTPUT_FRAME)) {
+            //stdout would turn 0x0A into CRLF and could split the frame, the driver writes it in one piece
+            xSemaphoreTake(frameLock, portMAX_DELAY);
+            if (frameWriteLock != NULL) {xSemaphoreTake(frameWriteLock, portMAX_DELAY);}
+            uart_write_bytes(frameUart, frame, framelen);
+            if (frameWriteLock != NULL) {xSemaphoreGive(frameWriteLock);}
+            xSemaphoreGive(frameLock);
+        }
+
+        //the report is cut back by sampling less often, the console output is most of the cost
+        if (memonload > MEMON_MAX_OVERHEAD_PERMILLE && memonUpdateTime_s < MEMON_MAX_UPDATERATE_S) {
+            memonUpdateTime_s = (memonUpdateTime_s * 2 > MEMON_MAX_UPDATERATE_S) ? MEMON_MAX_UPDATERATE_S : memonUpdateTime_s * 2;
+            ESP_LOGW(TAG, "Memon used %.1lf %% CPU, update time raised to %i s", memonload / 10.0, memonUpdateTime_s);
+        }
         vTaskDelay(memonUpdateTime_s*1000/portTICK_PERIOD_MS);
     }
 }
@@ -80,9 +218,29 @@ void memon_setUpdateTime(uint8_t updateTime_s) {
     memonUpdateTime_s = updateTime_s;
 }
 
+void memon_setOutput(uint8_t outputs) {
+    memonOutputs = outputs;
+}
+
+void memon_setFrameOutput(uart_port_t uart, SemaphoreHandle_t writeLock) {
+    frameUart = uart;
+    frameWriteLock = writeLock;
+}
+
+size_t memon_getFrame(uint8_t *buf, size_t len) {
+    size_t copied = 0;
+    xSemaphoreTake(frameLock, portMAX_DELAY);
+    if (framelen > 0 && framelen <= len) {
+        memcpy(buf, frame, framelen);
+        copied = framelen;
+    }
+    xSemaphoreGive(frameLock);
+    return copied;
+}
+
 TaskHandle_t hMemonTask;
 void initMemon(void) {
     evMemon = xEventGroupCreate();
-    xTaskCreate(&memonTask, "memonTask", 3000, NULL, 20, &hMemonTask);
+    frameLock = xSemaphoreCreateMutex();
+    xTaskCreatePinnedToCore(&memonTask, "memonTask", 4096, NULL, 20, &hMemonTask, MEMON_TASK_CORE);
 }
-
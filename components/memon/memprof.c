@@ -0,0 +1,291 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+#include "esp_heap_caps.h"
+#ifdef CONFIG_HEAP_TASK_TRACKING
+#include "esp_heap_task_info.h"
+#endif
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "memprof.h"
+
+#define TAG "MEMPROF"
+
+#define EV_MEMPROF_RUNNING  1<<0
+
+#define MEMPROF_NAME_LEN    configMAX_TASK_NAME_LEN
+#define MEMPROF_REGIONS     2
+
+typedef struct {
+    char prefix[MEMPROF_NAME_LEN];
+    uint32_t size;
+} memprof_budget;
+
+typedef struct {
+    TaskHandle_t handle;
+    char name[MEMPROF_NAME_LEN];
+    uint32_t stack_free_min;                // bytes, the high-water mark of FreeRTOS
+    bool alive;
+    size_t heap[MEMPROF_REGIONS];           // bytes allocated by the task in the last sample
+    size_t heap_peak[MEMPROF_REGIONS];
+    size_t blocks_peak;
+} memprof_task;
+
+typedef struct {
+    const char *name;
+    uint32_t caps;
+    size_t total;
+    size_t free_now;
+    size_t free_min;                        // sampled over the run, the allocator keeps the one since boot
+    size_t largest_now;
+    size_t largest_min;
+    uint16_t frag_now;                      // per mille of the free memory outside the largest block
+    uint16_t frag_max;
+} memprof_region;
+
+EventGroupHandle_t evMemprof;
+static SemaphoreHandle_t profLock;
+
+static memprof_budget budgets[MEMPROF_MAX_BUDGETS];
+static uint32_t budgetcount = 0;
+static memprof_task tasks[MEMPROF_MAX_TASKS];
+static uint32_t taskcount = 0;
+static memprof_region regions[MEMPROF_REGIONS] = {
+    {.name = "Internal", .caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT},
+    {.name = "PSRAM", .caps = MALLOC_CAP_SPIRAM},
+};
+static TaskStatus_t systemtasklist[MEMPROF_MAX_TASKS];
+#ifdef CONFIG_HEAP_TASK_TRACKING
+static heap_task_totals_t heaptotals[MEMPROF_MAX_TASKS];
+#endif
+static uint32_t samples = 0;
+static uint32_t sample_us_max = 0;
+static int64_t runstart_us = 0;
+
+static uint32_t stackBudget(const char *name) {
+    for (uint32_t i = 0; i < budgetcount; i++) {
+        if (strncmp(name, budgets[i].prefix, strlen(budgets[i].prefix)) == 0) {
+            return budgets[i].size;
+        }
+    }
+    return 0;
+}
+
+static memprof_task *findTask(TaskHandle_t handle, const char *name) {
+    //a new task can get the handle of a deleted one, it only counts as the same task under the same name
+    for (uint32_t i = 0; i < taskcount; i++) {
+        if (tasks[i].handle == handle && (name == NULL || strncmp(tasks[i].name, name, MEMPROF_NAME_LEN) == 0)) {
+            return &tasks[i];
+        }
+    }
+    if (taskcount == MEMPROF_MAX_TASKS) {
+        return NULL;
+    }
+    memprof_task *task = &tasks[taskcount++];
+    memset(task, 0, sizeof(*task));
+    task->handle = handle;
+    //allocations of tasks deleted before their first sample and of the startup code before the scheduler
+    strncpy(task->name, (name != NULL) ? name : ((handle != NULL) ? "(deleted)" : "(startup)"), MEMPROF_NAME_LEN - 1);
+    task->stack_free_min = UINT32_MAX;
+    return task;
+}
+
+static void sampleStacks(void) {
+    uint32_t count = uxTaskGetSystemState(systemtasklist, MEMPROF_MAX_TASKS, NULL);
+    if (count == 0) {
+        ESP_LOGW(TAG, "More than %i tasks, raise MEMPROF_MAX_TASKS", MEMPROF_MAX_TASKS);
+        return;
+    }
+    for (uint32_t i = 0; i < taskcount; i++) {
+        tasks[i].alive = false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        memprof_task *task = findTask(systemtasklist[i].xHandle, systemtasklist[i].pcTaskName);
+        if (task == NULL) {
+            continue;
+        }
+        task->alive = true;
+        if (systemtasklist[i].usStackHighWaterMark < task->stack_free_min) {
+            task->stack_free_min = systemtasklist[i].usStackHighWaterMark;
+        }
+    }
+}
+
+static void sampleTaskHeap(void) {
+#ifdef CONFIG_HEAP_TASK_TRACKING
+    //every block carries its owner, the allocator sums them up per task and region
+    size_t count = 0;
+    heap_task_info_params_t params = {
+        .caps = {MALLOC_CAP_INTERNAL, MALLOC_CAP_SPIRAM},
+        .mask = {MALLOC_CAP_INTERNAL, MALLOC_CAP_SPIRAM},
+        .tasks = NULL,
+        .num_tasks = 0,
+        .totals = heaptotals,
+        .num_totals = &count,
+        .max_totals = MEMPROF_MAX_TASKS,
+        .blocks = NULL,
+        .max_blocks = 0,
+    };
+    heap_caps_get_per_task_info(&params);
+
+    for (uint32_t i = 0; i < taskcount; i++) {
+        memset(tasks[i].heap, 0, sizeof(tasks[i].heap));
+    }
+    for (size_t i = 0; i < count; i++) {
+        memprof_task *task = findTask(heaptotals[i].task, NULL);
+        if (task == NULL) {
+            continue;
+        }
+        size_t blocks = 0;
+        for (int r = 0; r < MEMPROF_REGIONS; r++) {
+            task->heap[r] = heaptotals[i].size[r];
+            blocks += heaptotals[i].count[r];
+            if (task->heap[r] > task->heap_peak[r]) {
+                task->heap_peak[r] = task->heap[r];
+            }
+        }
+        if (blocks > task->blocks_peak) {
+            task->blocks_peak = blocks;
+        }
+    }
+#endif
+}
+
+static void sampleRegions(void) {
+    for (int r = 0; r < MEMPROF_REGIONS; r++) {
+        memprof_region *region = &regions[r];
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, region->caps);
+        region->total = heap_caps_get_total_size(region->caps);
+        region->free_now = info.total_free_bytes;
+        region->largest_now = info.largest_free_block;
+        region->frag_now = (info.total_free_bytes > 0) ? 1000 - (uint16_t)(((uint64_t)info.largest_free_block * 1000) / info.total_free_bytes) : 0;
+        if (info.total_free_bytes < region->free_min) {
+            region->free_min = info.total_free_bytes;
+        }
+        if (info.largest_free_block < region->largest_min) {
+            region->largest_min = info.largest_free_block;
+        }
+        if (region->frag_now > region->frag_max) {
+            region->frag_max = region->frag_now;
+        }
+    }
+}
+
+void memprof_sample(void) {
+    int64_t start = esp_timer_get_time();
+    xSemaphoreTake(profLock, portMAX_DELAY);
+    //stacks first, so the heap of a task seen for the first time is listed under its name
+    sampleStacks();
+    sampleTaskHeap();
+    sampleRegions();
+    samples++;
+    uint32_t sample_us = esp_timer_get_time() - start;
+    if (sample_us > sample_us_max) {
+        sample_us_max = sample_us;
+    }
+    xSemaphoreGive(profLock);
+}
+
+void memprofTask(void* param) {
+    for(;;) {
+        xEventGroupWaitBits(evMemprof, EV_MEMPROF_RUNNING, false, true, portMAX_DELAY);
+        memprof_sample();
+        vTaskDelay(MEMPROF_SAMPLE_MS/portTICK_PERIOD_MS);
+    }
+}
+
+void memprof_set_stack_budget(const char *prefix, uint32_t stack_size) {
+    if (budgetcount == MEMPROF_MAX_BUDGETS) {
+        ESP_LOGW(TAG, "More than %i stack budgets, raise MEMPROF_MAX_BUDGETS", MEMPROF_MAX_BUDGETS);
+        return;
+    }
+    strncpy(budgets[budgetcount].prefix, prefix, MEMPROF_NAME_LEN - 1);
+    budgets[budgetcount].size = stack_size;
+    budgetcount++;
+}
+
+void memprof_start(void) {
+    xSemaphoreTake(profLock, portMAX_DELAY);
+    taskcount = 0;
+    samples = 0;
+    sample_us_max = 0;
+    for (int r = 0; r < MEMPROF_REGIONS; r++) {
+        regions[r].free_min = SIZE_MAX;
+        regions[r].largest_min = SIZE_MAX;
+        regions[r].frag_max = 0;
+    }
+    runstart_us = esp_timer_get_time();
+    xSemaphoreGive(profLock);
+    xEventGroupSetBits(evMemprof, EV_MEMPROF_RUNNING);
+}
+
+void memprof_stop(void) {
+    xEventGroupClearBits(evMemprof, EV_MEMPROF_RUNNING);
+}
+
+void memprof_report(void) {
+    uint32_t reclaim = 0;
+
+    //one last sample, so the report covers everything up to now
+    memprof_sample();
+    xSemaphoreTake(profLock, portMAX_DELAY);
+    printf("\n-----------------------------------------\nMEMPROF-Report (%.1lf s, %lu samples, max %lu us per sample):\n",
+           (esp_timer_get_time() - runstart_us) / 1e6, samples, sample_us_max);
+    printf("\n----Name---------------- Stack -- Peak --- Free min - Reclaim -- Heap int/peak --- Heap ext/peak --- Blocks\n");
+    for (uint32_t i = 0; i < taskcount; i++) {
+        memprof_task *task = &tasks[i];
+        //budgets are looked up here, they may be set after the task was first sampled
+        uint32_t stack_size = stackBudget(task->name);
+        uint32_t free_min = (task->stack_free_min == UINT32_MAX) ? 0 : task->stack_free_min;
+        uint32_t task_reclaim = 0;
+        if (stack_size > 0 && free_min > MEMPROF_STACK_RESERVE) {
+            task_reclaim = free_min - MEMPROF_STACK_RESERVE;
+            reclaim += task_reclaim;
+        }
+        if (stack_size > 0) {
+            printf("  %c %-20s %6lu  %6lu   %6lu     %6lu", task->alive ? ' ' : '-', task->name,
+                   stack_size, stack_size - free_min, free_min, task_reclaim);
+        } else if (task->stack_free_min != UINT32_MAX) {
+            printf("  %c %-20s      -       -   %6lu          -", task->alive ? ' ' : '-', task->name, free_min);
+        } else {
+            printf("  %c %-20s      -       -        -          -", task->alive ? ' ' : '-', task->name);
+        }
+        printf("    %6u/%-6u    %8u/%-8u  %4u\n", task->heap[0], task->heap_peak[0], task->heap[1], task->heap_peak[1], task->blocks_peak);
+    }
+#ifndef CONFIG_HEAP_TASK_TRACKING
+    printf("  Heap per task needs Component config -> Heap memory debugging -> Enable heap task tracking\n");
+#endif
+
+    printf("\n----Heap------- Total ---- Free --- Free min -- Boot min -- Largest/min ------- Frag/max [%%]\n");
+    for (int r = 0; r < MEMPROF_REGIONS; r++) {
+        memprof_region *region = &regions[r];
+        if (region->total == 0) {
+            continue;
+        }
+        printf("    %-10s %8u  %8u   %8u    %8u    %8u/%-8u  %5.1lf/%.1lf\n", region->name, region->total, region->free_now,
+               region->free_min, heap_caps_get_minimum_free_size(region->caps), region->largest_now, region->largest_min,
+               region->frag_now / 10.0, region->frag_max / 10.0);
+    }
+    printf("\nStacks with a budget could give back %lu bytes, keeping %i bytes above each peak.\n"
+           "Heap peaks are sampled every %i ms, '-' marks tasks that ended during the run.\n-----------------------------------------\n",
+           reclaim, MEMPROF_STACK_RESERVE, MEMPROF_SAMPLE_MS);
+    fflush(stdout);
+    xSemaphoreGive(profLock);
+}
+
+TaskHandle_t hMemprofTask;
+void initMemprof(void) {
+    evMemprof = xEventGroupCreate();
+    profLock = xSemaphoreCreateMutex();
+    xTaskCreatePinnedToCore(&memprofTask, "memprofTask", 3072, NULL, MEMPROF_TASK_PRIO, &hMemprofTask, MEMON_TASK_CORE);
+    memprof_start();
+}
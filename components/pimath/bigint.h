@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Arbitrary precision signed integer, little endian 32bit limbs.
+// All functions returning bool return false if an allocation failed.
+typedef struct {
+    uint32_t *limbs;
+    uint32_t len;       // used limbs, 0 means value is zero
+    uint32_t cap;       // allocated limbs
+    bool neg;
+} bigint_t;
+
+void bigint_init(bigint_t *b);
+void bigint_free(bigint_t *b);
+bool bigint_reserve(bigint_t *b, uint32_t limbs);
+
+bool bigint_set_u32(bigint_t *b, uint32_t value);
+bool bigint_set_i64(bigint_t *b, int64_t value);
+bool bigint_copy(bigint_t *dst, const bigint_t *src);
+void bigint_swap(bigint_t *a, bigint_t *b);
+
+bool bigint_is_zero(const bigint_t *b);
+int bigint_cmp(const bigint_t *a, const bigint_t *b);
+uint32_t bigint_bits(const bigint_t *b);
+
+bool bigint_add(bigint_t *r, const bigint_t *a, const bigint_t *b);
+bool bigint_sub(bigint_t *r, const bigint_t *a, const bigint_t *b);
+bool bigint_mul(bigint_t *r, const bigint_t *a, const bigint_t *b);
+bool bigint_mul_u32(bigint_t *r, const bigint_t *a, uint32_t m);
+bool bigint_mul_i32(bigint_t *r, const bigint_t *a, int32_t m);
+bool bigint_mul_pow10(bigint_t *r, const bigint_t *a, uint32_t exp);
+bool bigint_shl(bigint_t *r, const bigint_t *a, uint32_t bits);
+bool bigint_shr(bigint_t *r, const bigint_t *a, uint32_t bits);
+
+// Truncating division: q = a / b, rem = a - q*b (rem takes the sign of a). q or rem may be NULL.
+bool bigint_divmod(bigint_t *q, bigint_t *rem, const bigint_t *a, const bigint_t *b);
+// Divides in place by a small divisor and returns the remainder of the magnitude.
+uint32_t bigint_div_u32(bigint_t *a, uint32_t d);
+
+// r = floor(sqrt(a)), a must not be negative
+bool bigint_isqrt(bigint_t *r, const bigint_t *a);
+
+// Writes the decimal representation into buf. Returns number of characters written (without '\0') or 0 if buf is too small.
+size_t bigint_to_decimal(const bigint_t *b, char *buf, size_t buflen);
+// Number of bytes bigint_to_decimal needs at most (including sign and '\0').
+size_t bigint_decimal_size(const bigint_t *b);
+
+// Byte serialisation (u32 limb count, u8 sign, limbs, little endian), e.g. to send values to other processes.
+size_t bigint_serial_size(const bigint_t *b);
+// Writes bigint_serial_size(b) bytes to out and returns that size
+size_t bigint_serialize(const bigint_t *b, uint8_t *out);
+// Returns the number of bytes consumed, 0 if in is truncated or an allocation failed
+size_t bigint_deserialize(bigint_t *b, const uint8_t *in, size_t len);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "bigint.h"
+
+#define BSPLIT_GUARD_DIGITS 10
+
+// Binary splitting of hypergeometric type series
+//
+//      S = sum_{n=0}^{N-1} a(n)/b(n) * prod_{k=0}^{n} p(k)/q(k)
+//
+// For a range [n1,n2) the engine builds P = prod p, Q = prod q, B = prod b and T, so that
+// S(n1,n2) = T / (B*Q). Two neighbouring ranges are merged with
+//      P = Pl*Pr,  Q = Ql*Qr,  B = Bl*Br,  T = Br*Qr*Tl + Bl*Pl*Tr
+// which is the binary_split() of documentation/chudnovsky.py generalised to any term generator.
+
+typedef bool (*bsplit_term_fn)(bigint_t *out, uint32_t n);
+
+typedef struct {
+    bigint_t P;
+    bigint_t Q;
+    bigint_t B;
+    bigint_t T;
+} bsplit_pqt;
+
+typedef struct bsplit_series {
+    const char *name;
+    const char *symbol;
+    bsplit_term_fn p;
+    bsplit_term_fn q;
+    bsplit_term_fn a;           // NULL means a(n) = 1
+    bsplit_term_fn b;           // NULL means b(n) = 1
+    uint32_t (*terms)(uint32_t digits);
+    // out = floor(constant * 10^digits) from the series sum over [0,N)
+    bool (*finish)(const struct bsplit_series *series, bigint_t *out, const bsplit_pqt *sum, uint32_t digits);
+} bsplit_series;
+
+void bsplit_pqt_init(bsplit_pqt *s);
+void bsplit_pqt_free(bsplit_pqt *s);
+
+// Serialisation of P, Q, B and T for workers in other processes, see bigint_serialize
+size_t bsplit_pqt_serial_size(const bsplit_pqt *s);
+size_t bsplit_pqt_serialize(const bsplit_pqt *s, uint8_t *out);
+size_t bsplit_pqt_deserialize(bsplit_pqt *s, const uint8_t *in, size_t len);
+
+// Sums the range [n1,n2). P is only valid if need_p is set, it is not needed for the rightmost range.
+bool bsplit_range(const bsplit_series *series, uint32_t n1, uint32_t n2, bsplit_pqt *out, bool need_p);
+// left = merge(left, right), right is left untouched
+bool bsplit_merge(const bsplit_series *series, bsplit_pqt *left, const bsplit_pqt *right, bool need_p);
+
+// Part part of parts of [0,terms). Merging the parts in order with bsplit_merge gives the sum over [0,terms),
+// so the parts can be computed by different workers.
+bool bsplit_part(const bsplit_series *series, uint32_t terms, uint32_t part, uint32_t parts, bsplit_pqt *out);
+
+uint32_t bsplit_terms(const bsplit_series *series, uint32_t digits);
+
+// out = floor(constant * 10^digits) from the sum over [0,bsplit_terms), for sums that were split over several workers
+bool bsplit_result(const bsplit_series *series, const bsplit_pqt *sum, uint32_t digits, bigint_t *out);
+
+// out = floor(constant * 10^digits)
+bool bsplit_compute(const bsplit_series *series, uint32_t digits, bigint_t *out);
+
+// out = floor(num * T * 10^digits / (den * B * Q)), helper for finish functions
+bool bsplit_finish_ratio(const bsplit_series *series, bigint_t *out, const bsplit_pqt *sum, uint32_t digits, uint32_t num, uint32_t den);
+
+// Formats floor(constant * 10^digits) as "3.1415...". Returns length or 0 if buf is too small.
+size_t bsplit_format(const bigint_t *fixed, uint32_t digits, char *buf, size_t buflen);
+
+extern const bsplit_series bsplit_pi_chudnovsky;
+extern const bsplit_series bsplit_e;
+extern const bsplit_series bsplit_ln2;
+extern const bsplit_series bsplit_sqrt2;
+extern const bsplit_series bsplit_zeta3;
+extern const bsplit_series bsplit_catalan;
+
+extern const bsplit_series *const bsplit_series_list[];
+extern const uint32_t bsplit_series_count;
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Binary container for the decimal digits of a constant
+//
+// The fractional digits are packed 19 per 64bit little endian word (the word is the decimal number the digits form,
+// first digit most significant), which needs 3.37 bits per digit instead of 8 for text. Words are grouped into blocks
+// of fixed size, so digit k lives at
+//      DIGITSTORE_HEADER_SIZE + (k / block digits) * block bytes + (k % block digits) / 19 * 8
+// and is read with one seek. Every block has a CRC-32 in the block index behind the last block.
+//
+//      header (64 bytes, CRC-32 in the last 4) | block 0 | block 1 | ... | block n-1 | index: n * CRC-32 of the block
+//
+// The layout only uses fixed offsets and explicit little endian fields, so a file can be mapped into memory on the
+// host (or from a flash partition) and read with digitstore_open_memory without copying.
+
+#define DIGITSTORE_MAGIC "CPDG"
+#define DIGITSTORE_VERSION 1
+#define DIGITSTORE_HEADER_SIZE 64
+#define DIGITSTORE_DIGITS_PER_WORD 19
+#define DIGITSTORE_WORDS_PER_BLOCK 64                                                       // 512 byte blocks
+#define DIGITSTORE_BLOCK_DIGITS (DIGITSTORE_DIGITS_PER_WORD * DIGITSTORE_WORDS_PER_BLOCK)   // 1216
+#define DIGITSTORE_BLOCK_BYTES (DIGITSTORE_WORDS_PER_BLOCK * 8)
+#define DIGITSTORE_SYMBOL_LEN 16
+#define DIGITSTORE_INTEGER_LEN 12
+
+typedef struct {
+    uint32_t words_per_block;
+    uint32_t block_count;
+    uint64_t digits;                                // fractional digits stored
+    uint64_t index_offset;
+    char symbol[DIGITSTORE_SYMBOL_LEN];             // e.g. "pi", zero terminated
+    char integer[DIGITSTORE_INTEGER_LEN];           // digits before the decimal point, zero terminated
+} digitstore_header;
+
+typedef struct {
+    FILE *file;                                     // NULL if the container is built in memory
+    uint8_t *mem;
+    size_t mem_size;
+    size_t mem_pos;
+    digitstore_header header;
+    uint64_t words[DIGITSTORE_WORDS_PER_BLOCK];    // block being filled
+    uint32_t fill;                                  // digits in the current block
+    uint32_t *crcs;
+    uint32_t crc_capacity;
+} digitstore_writer;
+
+typedef struct {
+    FILE *file;                                     // NULL if the container is in memory
+    const uint8_t *data;
+    size_t size;
+    digitstore_header header;
+    uint32_t *crcs;
+} digitstore_reader;
+
+// Bytes of a container with the given number of digits, e.g. to check it fits into a partition
+uint64_t digitstore_size(uint64_t digits);
+
+// integer is the part before the decimal point, e.g. "3" for pi
+bool digitstore_create(digitstore_writer *w, const char *path, const char *symbol, const char *integer);
+// Builds the container in buf, which needs digitstore_size(digits) bytes, e.g. for file systems without stdio
+bool digitstore_create_memory(digitstore_writer *w, uint8_t *buf, size_t size, const char *symbol, const char *integer);
+// Appends ASCII digits '0'..'9'
+bool digitstore_append(digitstore_writer *w, const char *digits, size_t count);
+// Writes the last block, the index and the final header, w is closed even if this fails
+bool digitstore_finish(digitstore_writer *w);
+
+bool digitstore_open(digitstore_reader *r, const char *path);
+bool digitstore_open_memory(digitstore_reader *r, const void *data, size_t size);
+void digitstore_close(digitstore_reader *r);
+
+// Fractional digit k (0 is the first digit after the decimal point), -1 if out of range or on a read error
+int digitstore_digit(digitstore_reader *r, uint64_t k);
+// Reads count digits starting at first as ASCII, returns the number of digits read
+size_t digitstore_read(digitstore_reader *r, uint64_t first, char *out, size_t count);
+
+// Compares the block with its index entry
+bool digitstore_verify_block(digitstore_reader *r, uint32_t block);
+// Index of the first corrupt block or -1
+int64_t digitstore_verify(digitstore_reader *r);
+
+// Packed bytes of a block for in memory containers (e.g. to compare two runs block by block), NULL for files
+const uint8_t *digitstore_block_data(const digitstore_reader *r, uint32_t block);
+
+uint32_t digitstore_crc32(uint32_t crc, const void *data, size_t len);
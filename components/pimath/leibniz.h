@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Parallel Madhava-Leibniz summation, pi = sum_{k>=0} 4 (-1)^k / (2k+1)
+//
+// The terms are independent, so [0,terms) is split over workers, either in contiguous blocks or interleaved
+// (every workers-th term). Each worker walks its terms in LEIBNIZ_LANES lanes with one compensated accumulator
+// per lane. Lanes and workers are reduced in a fixed order, so the result only depends on
+// (terms, workers, split) and not on which worker finished first or how the compiler vectorised the lanes.
+
+#define LEIBNIZ_LANES 8             // even, so every lane keeps the sign of its first term
+
+typedef enum {
+    LEIBNIZ_BLOCKED,                // worker w sums one contiguous range
+    LEIBNIZ_INTERLEAVED,            // worker w sums the terms k with k % workers == w
+} leibniz_split;
+
+// Compensated sum (Neumaier), value = sum + comp
+typedef struct {
+    double sum;
+    double comp;
+} leibniz_acc;
+
+void leibniz_acc_init(leibniz_acc *acc);
+void leibniz_acc_add(leibniz_acc *acc, double value);
+double leibniz_acc_value(const leibniz_acc *acc);
+
+// Sum of the terms of one worker
+leibniz_acc leibniz_partial(uint64_t terms, uint32_t worker, uint32_t workers, leibniz_split split);
+
+// Combines the partials in index order
+double leibniz_reduce(const leibniz_acc *partials, uint32_t workers);
+
+const char *leibniz_split_name(leibniz_split split);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Monte Carlo estimation of pi with the counter based Philox4x32-10 generator.
+//
+// Every sampler owns its key and counter, so samplers on different cores never share state.
+// A generator call maps (counter, key) to four 32bit words, which are two points in the unit square.
+// MC_LANES counters are processed side by side so that host compilers can vectorise the rounds.
+
+#define MC_LANES 4
+#define MC_POINTS_PER_BLOCK (2 * MC_LANES)
+
+typedef struct {
+    uint32_t key[2];
+    uint64_t counter;           // next block index, advanced by MC_LANES per block
+    uint64_t hits;              // points inside the quarter circle
+    uint64_t samples;
+} __attribute__((aligned(64))) mc_sampler;
+
+// stream separates independent samplers (e.g. core id) for the same seed
+void mc_sampler_init(mc_sampler *s, uint64_t seed, uint32_t stream);
+void mc_sampler_reset(mc_sampler *s);
+
+// One Philox4x32-10 block, exposed for reference checks
+void mc_philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+
+// Draws blocks * MC_POINTS_PER_BLOCK points and returns the number of hits of this batch
+uint64_t mc_sample(mc_sampler *s, uint32_t blocks);
+
+// 4 * hits / samples, 0 if nothing has been sampled yet
+double mc_estimate(uint64_t hits, uint64_t samples);
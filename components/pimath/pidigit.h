@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Decimal digits of pi at an arbitrary position without the preceding digits (Plouffe, improved by Bellard).
+//
+// Gosper's series pi = sum_{k>=0} (50k - 6) / (2^k C(3k,k)) converges with log10(13.5) digits per term.
+// For every prime a <= 3N the a-part of 10^e * pi mod 1 is summed modulo a^vmax, the sum over all primes
+// is the fractional part of 10^e * pi. The primes are independent, so a job can be split over workers.
+// Positions where the powers of two are not cancelled by 10^e are computed directly with Chudnovsky.
+
+#define PIDIGIT_DIGITS 8            // digits delivered per position, the double sum is good for ~10
+#define PIDIGIT_GUARD_DIGITS 12
+#define PIDIGIT_LANES 8             // primes walked side by side
+
+typedef struct {
+    uint32_t position;              // 1 is the first digit after the decimal point
+    uint32_t exponent;              // e = position - 1
+    uint32_t terms;                 // N
+    uint32_t limit;                 // 3N, largest prime factor of the denominators
+    uint32_t prime_count;
+    uint32_t *primes;               // odd primes <= limit
+    bool direct;                    // small position, use binary splitting instead
+} pidigit_job;
+
+bool pidigit_job_init(pidigit_job *job, uint32_t position);
+void pidigit_job_free(pidigit_job *job);
+
+// Fractional contribution of every prime with index % workers == worker.
+double pidigit_partial(const pidigit_job *job, uint32_t worker, uint32_t workers);
+
+// Turns the sum of all partials into PIDIGIT_DIGITS digits (out needs PIDIGIT_DIGITS + 1 chars)
+bool pidigit_digits(const pidigit_job *job, double partial_sum, char *out);
+
+// Single threaded convenience wrapper
+bool pidigit_compute(uint32_t position, char *out);
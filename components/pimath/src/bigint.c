@@ -0,0 +1,734 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../bigint.h"
+
+#define KARATSUBA_THRESHOLD 32      //limbs, below this schoolbook multiplication is faster
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Magnitude helpers working on raw limb arrays                                                                       */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static uint32_t trim(const uint32_t *a, uint32_t n)
+{
+    while (n > 0 && a[n - 1] == 0) {
+        n--;
+    }
+    return n;
+}
+
+static int mag_cmp(const uint32_t *a, uint32_t an, const uint32_t *b, uint32_t bn)
+{
+    if (an != bn) {
+        return (an > bn) ? 1 : -1;
+    }
+    for (uint32_t i = an; i-- > 0;) {
+        if (a[i] != b[i]) {
+            return (a[i] > b[i]) ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+// r = a + b, an >= bn, r needs an + 1 limbs. Returns the carry which is also stored in r[an].
+static uint32_t mag_add(uint32_t *r, const uint32_t *a, uint32_t an, const uint32_t *b, uint32_t bn)
+{
+    uint64_t carry = 0;
+    uint32_t i = 0;
+    for (; i < bn; i++) {
+        carry += (uint64_t)a[i] + b[i];
+        r[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    for (; i < an; i++) {
+        carry += a[i];
+        r[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    r[an] = (uint32_t)carry;
+    return (uint32_t)carry;
+}
+
+// r = a - b, requires a >= b, an >= bn, r needs an limbs
+static void mag_sub(uint32_t *r, const uint32_t *a, uint32_t an, const uint32_t *b, uint32_t bn)
+{
+    int64_t borrow = 0;
+    uint32_t i = 0;
+    for (; i < bn; i++) {
+        borrow += (int64_t)a[i] - b[i];
+        r[i] = (uint32_t)borrow;
+        borrow >>= 32;
+    }
+    for (; i < an; i++) {
+        borrow += a[i];
+        r[i] = (uint32_t)borrow;
+        borrow >>= 32;
+    }
+}
+
+// r += a at limb granularity, r has rn limbs, carry is propagated up to rn
+static void mag_add_into(uint32_t *r, uint32_t rn, const uint32_t *a, uint32_t an)
+{
+    uint64_t carry = 0;
+    uint32_t i = 0;
+    for (; i < an && i < rn; i++) {
+        carry += (uint64_t)r[i] + a[i];
+        r[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    for (; carry && i < rn; i++) {
+        carry += r[i];
+        r[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+}
+
+// r -= a, r >= a is required
+static void mag_sub_from(uint32_t *r, uint32_t rn, const uint32_t *a, uint32_t an)
+{
+    int64_t borrow = 0;
+    uint32_t i = 0;
+    for (; i < an; i++) {
+        borrow += (int64_t)r[i] - a[i];
+        r[i] = (uint32_t)borrow;
+        borrow >>= 32;
+    }
+    for (; borrow && i < rn; i++) {
+        borrow += r[i];
+        r[i] = (uint32_t)borrow;
+        borrow >>= 32;
+    }
+}
+
+// r = a * b, r needs an + bn limbs and must not overlap a or b
+static void mag_mul_basic(uint32_t *r, const uint32_t *a, uint32_t an, const uint32_t *b, uint32_t bn)
+{
+    memset(r, 0, (an + bn) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < an; i++) {
+        uint64_t carry = 0;
+        uint64_t ai = a[i];
+        if (ai == 0) {
+            continue;
+        }
+        for (uint32_t j = 0; j < bn; j++) {
+            carry += ai * b[j] + r[i + j];
+            r[i + j] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        r[i + bn] = (uint32_t)carry;
+    }
+}
+
+// Karatsuba for two operands of n limbs each. r needs 2n limbs, scratch at least 4n + 256 limbs.
+static void mag_mul_karatsuba(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t n, uint32_t *scratch)
+{
+    if (n < KARATSUBA_THRESHOLD) {
+        mag_mul_basic(r, a, n, b, n);
+        return;
+    }
+
+    uint32_t h = n / 2;         //low half
+    uint32_t hn = n - h;        //high half, hn >= h
+    uint32_t m = hn + 1;
+
+    uint32_t *sa = scratch;
+    uint32_t *sb = sa + m;
+    uint32_t *z1 = sb + m;
+    uint32_t *next = z1 + 2 * m;
+
+    //z0 = a0*b0 into lower part of r, z2 = a1*b1 into upper part
+    mag_mul_karatsuba(r, a, b, h, next);
+    mag_mul_karatsuba(r + 2 * h, a + h, b + h, hn, next);
+
+    //z1 = (a0+a1)*(b0+b1) - z0 - z2
+    mag_add(sa, a + h, hn, a, h);
+    mag_add(sb, b + h, hn, b, h);
+    mag_mul_karatsuba(z1, sa, sb, m, next);
+    mag_sub_from(z1, 2 * m, r, 2 * h);
+    mag_sub_from(z1, 2 * m, r + 2 * h, 2 * hn);
+
+    mag_add_into(r + h, 2 * n - h, z1, trim(z1, 2 * m));
+}
+
+// r = a * b for arbitrary lengths. r needs an + bn limbs and must not overlap a or b.
+static bool mag_mul(uint32_t *r, const uint32_t *a, uint32_t an, const uint32_t *b, uint32_t bn)
+{
+    if (an < bn) {
+        const uint32_t *t = a; a = b; b = t;
+        uint32_t tn = an; an = bn; bn = tn;
+    }
+    if (bn < KARATSUBA_THRESHOLD) {
+        mag_mul_basic(r, a, an, b, bn);
+        return true;
+    }
+
+    uint32_t *scratch = malloc((4 * bn + 256 + 2 * bn) * sizeof(uint32_t));
+    if (scratch == NULL) {
+        return false;
+    }
+    uint32_t *chunk = scratch + 4 * bn + 256;
+
+    //multiply the longer operand in slices of bn limbs
+    memset(r, 0, (an + bn) * sizeof(uint32_t));
+    bool ok = true;
+    for (uint32_t off = 0; off < an && ok; off += bn) {
+        uint32_t len = (an - off < bn) ? an - off : bn;
+        if (len == bn) {
+            mag_mul_karatsuba(chunk, a + off, b, bn, scratch);
+        } else {
+            ok = mag_mul(chunk, b, bn, a + off, len);
+        }
+        mag_add_into(r + off, an + bn - off, chunk, len + bn);
+    }
+    free(scratch);
+    return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Public API                                                                                                        */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+void bigint_init(bigint_t *b)
+{
+    b->limbs = NULL;
+    b->len = 0;
+    b->cap = 0;
+    b->neg = false;
+}
+
+void bigint_free(bigint_t *b)
+{
+    free(b->limbs);
+    bigint_init(b);
+}
+
+bool bigint_reserve(bigint_t *b, uint32_t limbs)
+{
+    if (limbs <= b->cap) {
+        return true;
+    }
+    uint32_t *p = realloc(b->limbs, limbs * sizeof(uint32_t));
+    if (p == NULL) {
+        return false;
+    }
+    b->limbs = p;
+    b->cap = limbs;
+    return true;
+}
+
+static void normalize(bigint_t *b)
+{
+    b->len = trim(b->limbs, b->len);
+    if (b->len == 0) {
+        b->neg = false;
+    }
+}
+
+bool bigint_set_u32(bigint_t *b, uint32_t value)
+{
+    if (!bigint_reserve(b, 1)) {
+        return false;
+    }
+    b->limbs[0] = value;
+    b->len = 1;
+    b->neg = false;
+    normalize(b);
+    return true;
+}
+
+bool bigint_set_i64(bigint_t *b, int64_t value)
+{
+    if (!bigint_reserve(b, 2)) {
+        return false;
+    }
+    uint64_t mag = (value < 0) ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    b->limbs[0] = (uint32_t)mag;
+    b->limbs[1] = (uint32_t)(mag >> 32);
+    b->len = 2;
+    b->neg = value < 0;
+    normalize(b);
+    return true;
+}
+
+bool bigint_copy(bigint_t *dst, const bigint_t *src)
+{
+    if (dst == src) {
+        return true;
+    }
+    if (!bigint_reserve(dst, src->len)) {
+        return false;
+    }
+    if (src->len > 0) {
+        memcpy(dst->limbs, src->limbs, src->len * sizeof(uint32_t));
+    }
+    dst->len = src->len;
+    dst->neg = src->neg;
+    return true;
+}
+
+void bigint_swap(bigint_t *a, bigint_t *b)
+{
+    bigint_t t = *a;
+    *a = *b;
+    *b = t;
+}
+
+bool bigint_is_zero(const bigint_t *b)
+{
+    return b->len == 0;
+}
+
+int bigint_cmp(const bigint_t *a, const bigint_t *b)
+{
+    if (a->neg != b->neg) {
+        return a->neg ? -1 : 1;
+    }
+    int c = mag_cmp(a->limbs, a->len, b->limbs, b->len);
+    return a->neg ? -c : c;
+}
+
+uint32_t bigint_bits(const bigint_t *b)
+{
+    if (b->len == 0) {
+        return 0;
+    }
+    uint32_t top = b->limbs[b->len - 1];
+    uint32_t bits = 0;
+    while (top) {
+        bits++;
+        top >>= 1;
+    }
+    return (b->len - 1) * 32 + bits;
+}
+
+// r = a + (negate_b ? -b : b)
+static bool add_signed(bigint_t *r, const bigint_t *a, const bigint_t *b, bool negate_b)
+{
+    bool bneg = b->neg ^ negate_b;
+    uint32_t n = (a->len > b->len ? a->len : b->len) + 1;
+    bigint_t t;
+    bigint_init(&t);
+    if (!bigint_reserve(&t, n)) {
+        return false;
+    }
+
+    if (a->neg == bneg) {
+        if (a->len >= b->len) {
+            mag_add(t.limbs, a->limbs, a->len, b->limbs, b->len);
+        } else {
+            mag_add(t.limbs, b->limbs, b->len, a->limbs, a->len);
+        }
+        t.len = n;
+        t.neg = a->neg;
+    } else if (mag_cmp(a->limbs, a->len, b->limbs, b->len) >= 0) {
+        mag_sub(t.limbs, a->limbs, a->len, b->limbs, b->len);
+        t.len = a->len;
+        t.neg = a->neg;
+    } else {
+        mag_sub(t.limbs, b->limbs, b->len, a->limbs, a->len);
+        t.len = b->len;
+        t.neg = bneg;
+    }
+    normalize(&t);
+    bigint_swap(r, &t);
+    bigint_free(&t);
+    return true;
+}
+
+bool bigint_add(bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+    return add_signed(r, a, b, false);
+}
+
+bool bigint_sub(bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+    return add_signed(r, a, b, true);
+}
+
+bool bigint_mul(bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+    if (a->len == 0 || b->len == 0) {
+        return bigint_set_u32(r, 0);
+    }
+    bigint_t t;
+    bigint_init(&t);
+    if (!bigint_reserve(&t, a->len + b->len)) {
+        return false;
+    }
+    if (!mag_mul(t.limbs, a->limbs, a->len, b->limbs, b->len)) {
+        bigint_free(&t);
+        return false;
+    }
+    t.len = a->len + b->len;
+    t.neg = a->neg != b->neg;
+    normalize(&t);
+    bigint_swap(r, &t);
+    bigint_free(&t);
+    return true;
+}
+
+bool bigint_mul_u32(bigint_t *r, const bigint_t *a, uint32_t m)
+{
+    if (!bigint_reserve(r, a->len + 1)) {
+        return false;
+    }
+    uint64_t carry = 0;
+    for (uint32_t i = 0; i < a->len; i++) {
+        carry += (uint64_t)a->limbs[i] * m;
+        r->limbs[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    r->limbs[a->len] = (uint32_t)carry;
+    r->len = a->len + 1;
+    r->neg = a->neg;
+    normalize(r);
+    return true;
+}
+
+bool bigint_mul_i32(bigint_t *r, const bigint_t *a, int32_t m)
+{
+    bool neg = a->neg ^ (m < 0);
+    uint32_t mag = (m < 0) ? (uint32_t)0 - (uint32_t)m : (uint32_t)m;
+    if (!bigint_mul_u32(r, a, mag)) {
+        return false;
+    }
+    r->neg = (r->len > 0) && neg;
+    return true;
+}
+
+bool bigint_mul_pow10(bigint_t *r, const bigint_t *a, uint32_t exp)
+{
+    if (!bigint_copy(r, a)) {
+        return false;
+    }
+    //multiply in steps of 10^9, bigger powers would be faster with bigint_mul but this is only used once per result
+    while (exp >= 9) {
+        if (!bigint_mul_u32(r, r, 1000000000u)) {
+            return false;
+        }
+        exp -= 9;
+    }
+    uint32_t m = 1;
+    while (exp--) {
+        m *= 10;
+    }
+    return bigint_mul_u32(r, r, m);
+}
+
+bool bigint_shl(bigint_t *r, const bigint_t *a, uint32_t bits)
+{
+    uint32_t limbs = bits / 32, shift = bits % 32;
+    bigint_t t;
+    bigint_init(&t);
+    if (!bigint_reserve(&t, a->len + limbs + 1)) {
+        return false;
+    }
+    memset(t.limbs, 0, (a->len + limbs + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < a->len; i++) {
+        uint64_t v = (uint64_t)a->limbs[i] << shift;
+        t.limbs[i + limbs] |= (uint32_t)v;
+        t.limbs[i + limbs + 1] |= (uint32_t)(v >> 32);
+    }
+    t.len = a->len + limbs + 1;
+    t.neg = a->neg;
+    normalize(&t);
+    bigint_swap(r, &t);
+    bigint_free(&t);
+    return true;
+}
+
+bool bigint_shr(bigint_t *r, const bigint_t *a, uint32_t bits)
+{
+    uint32_t limbs = bits / 32, shift = bits % 32;
+    if (limbs >= a->len) {
+        return bigint_set_u32(r, 0);
+    }
+    uint32_t n = a->len - limbs;
+    bigint_t t;
+    bigint_init(&t);
+    if (!bigint_reserve(&t, n)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t v = a->limbs[i + limbs];
+        if (i + limbs + 1 < a->len) {
+            v |= (uint64_t)a->limbs[i + limbs + 1] << 32;
+        }
+        t.limbs[i] = (uint32_t)(v >> shift);
+    }
+    t.len = n;
+    t.neg = a->neg;
+    normalize(&t);
+    bigint_swap(r, &t);
+    bigint_free(&t);
+    return true;
+}
+
+uint32_t bigint_div_u32(bigint_t *a, uint32_t d)
+{
+    uint64_t rem = 0;
+    for (uint32_t i = a->len; i-- > 0;) {
+        rem = (rem << 32) | a->limbs[i];
+        a->limbs[i] = (uint32_t)(rem / d);
+        rem %= d;
+    }
+    normalize(a);
+    return (uint32_t)rem;
+}
+
+// Knuth algorithm D. u has un limbs, v has vn >= 2 limbs, un >= vn. q needs un - vn + 1 limbs, r needs vn limbs.
+static bool mag_divmod(uint32_t *q, uint32_t *r, const uint32_t *u, uint32_t un, const uint32_t *v, uint32_t vn)
+{
+    uint32_t *un_ = malloc((un + 1 + vn) * sizeof(uint32_t));
+    if (un_ == NULL) {
+        return false;
+    }
+    uint32_t *vn_ = un_ + un + 1;
+
+    //normalize so that the top bit of the divisor is set
+    uint32_t s = 0;
+    uint32_t top = v[vn - 1];
+    while ((top & 0x80000000u) == 0) {
+        top <<= 1;
+        s++;
+    }
+    for (uint32_t i = vn - 1; i > 0; i--) {
+        vn_[i] = (v[i] << s) | (s ? (uint32_t)((uint64_t)v[i - 1] >> (32 - s)) : 0);
+    }
+    vn_[0] = v[0] << s;
+    un_[un] = s ? (uint32_t)((uint64_t)u[un - 1] >> (32 - s)) : 0;
+    for (uint32_t i = un - 1; i > 0; i--) {
+        un_[i] = (u[i] << s) | (s ? (uint32_t)((uint64_t)u[i - 1] >> (32 - s)) : 0);
+    }
+    un_[0] = u[0] << s;
+
+    for (uint32_t j = un - vn + 1; j-- > 0;) {
+        //estimate quotient digit
+        uint64_t num = ((uint64_t)un_[j + vn] << 32) | un_[j + vn - 1];
+        uint64_t qhat = num / vn_[vn - 1];
+        uint64_t rhat = num % vn_[vn - 1];
+        while (qhat > 0xFFFFFFFFu || qhat * vn_[vn - 2] > ((rhat << 32) | un_[j + vn - 2])) {
+            qhat--;
+            rhat += vn_[vn - 1];
+            if (rhat > 0xFFFFFFFFu) {
+                break;
+            }
+        }
+
+        //multiply and subtract
+        int64_t borrow = 0;
+        uint64_t carry = 0;
+        for (uint32_t i = 0; i < vn; i++) {
+            uint64_t p = qhat * vn_[i] + carry;
+            carry = p >> 32;
+            int64_t t = (int64_t)un_[i + j] - (int64_t)(uint32_t)p + borrow;
+            un_[i + j] = (uint32_t)t;
+            borrow = t >> 32;
+        }
+        int64_t t = (int64_t)un_[j + vn] - (int64_t)carry + borrow;
+        un_[j + vn] = (uint32_t)t;
+
+        //add back if we subtracted too much
+        if (t < 0) {
+            qhat--;
+            uint64_t c = 0;
+            for (uint32_t i = 0; i < vn; i++) {
+                c += (uint64_t)un_[i + j] + vn_[i];
+                un_[i + j] = (uint32_t)c;
+                c >>= 32;
+            }
+            un_[j + vn] += (uint32_t)c;
+        }
+        if (q != NULL) {
+            q[j] = (uint32_t)qhat;
+        }
+    }
+
+    //unnormalize remainder
+    if (r != NULL) {
+        for (uint32_t i = 0; i < vn; i++) {
+            r[i] = (un_[i] >> s) | (s ? (uint32_t)((uint64_t)un_[i + 1] << (32 - s)) : 0);
+        }
+    }
+    free(un_);
+    return true;
+}
+
+bool bigint_divmod(bigint_t *q, bigint_t *rem, const bigint_t *a, const bigint_t *b)
+{
+    if (b->len == 0) {
+        return false;
+    }
+    bigint_t tq, tr;
+    bigint_init(&tq);
+    bigint_init(&tr);
+
+    if (mag_cmp(a->limbs, a->len, b->limbs, b->len) < 0) {
+        if (!bigint_copy(&tr, a)) {
+            return false;
+        }
+    } else if (b->len == 1) {
+        if (!bigint_copy(&tq, a)) {
+            return false;
+        }
+        uint32_t r = bigint_div_u32(&tq, b->limbs[0]);
+        tq.neg = (tq.len > 0) && (a->neg != b->neg);
+        if (!bigint_set_u32(&tr, r)) {
+            bigint_free(&tq);
+            return false;
+        }
+        tr.neg = (tr.len > 0) && a->neg;
+    } else {
+        if (!bigint_reserve(&tq, a->len - b->len + 1) || !bigint_reserve(&tr, b->len) ||
+            !mag_divmod(tq.limbs, tr.limbs, a->limbs, a->len, b->limbs, b->len)) {
+            bigint_free(&tq);
+            bigint_free(&tr);
+            return false;
+        }
+        tq.len = a->len - b->len + 1;
+        tq.neg = a->neg != b->neg;
+        normalize(&tq);
+        tr.len = b->len;
+        tr.neg = a->neg;
+        normalize(&tr);
+    }
+
+    if (q != NULL) {
+        bigint_swap(q, &tq);
+    }
+    if (rem != NULL) {
+        bigint_swap(rem, &tr);
+    }
+    bigint_free(&tq);
+    bigint_free(&tr);
+    return true;
+}
+
+bool bigint_isqrt(bigint_t *r, const bigint_t *a)
+{
+    if (a->neg) {
+        return false;
+    }
+    if (a->len == 0) {
+        return bigint_set_u32(r, 0);
+    }
+
+    //start with an estimate from the top 52 bits, which is always slightly above the root
+    uint32_t bits = bigint_bits(a);
+    uint32_t drop = (bits > 52) ? ((bits - 52) & ~1u) : 0;
+    bigint_t x, y, t;
+    bigint_init(&x);
+    bigint_init(&y);
+    bigint_init(&t);
+    bool ok = bigint_shr(&t, a, drop);
+    double top = 0;
+    for (uint32_t i = t.len; i-- > 0;) {
+        top = top * 4294967296.0 + t.limbs[i];
+    }
+    ok = ok && bigint_set_i64(&x, (int64_t)sqrt(top) + 2);
+    ok = ok && bigint_shl(&x, &x, drop / 2);
+
+    //Newton iteration x = (x + a/x) / 2 decreases monotonically towards floor(sqrt(a))
+    while (ok) {
+        ok = bigint_divmod(&y, NULL, a, &x);
+        ok = ok && bigint_add(&y, &y, &x);
+        ok = ok && bigint_shr(&y, &y, 1);
+        if (!ok || bigint_cmp(&y, &x) >= 0) {
+            break;
+        }
+        bigint_swap(&x, &y);
+    }
+    if (ok) {
+        bigint_swap(r, &x);
+    }
+    bigint_free(&x);
+    bigint_free(&y);
+    bigint_free(&t);
+    return ok;
+}
+
+size_t bigint_decimal_size(const bigint_t *b)
+{
+    //log10(2^32) = 9.63, so 10 digits per limb is always enough
+    return (size_t)b->len * 10 + 2;
+}
+
+size_t bigint_to_decimal(const bigint_t *b, char *buf, size_t buflen)
+{
+    if (buflen < bigint_decimal_size(b)) {
+        return 0;
+    }
+    if (b->len == 0) {
+        buf[0] = '0';
+        buf[1] = '\0';
+        return 1;
+    }
+
+    bigint_t t;
+    bigint_init(&t);
+    if (!bigint_copy(&t, b)) {
+        return 0;
+    }
+
+    //peel off 9 digits at a time from the end
+    size_t pos = buflen - 1;
+    buf[pos] = '\0';
+    while (t.len > 0) {
+        uint32_t chunk = bigint_div_u32(&t, 1000000000u);
+        for (int i = 0; i < 9; i++) {
+            buf[--pos] = '0' + (chunk % 10);
+            chunk /= 10;
+            if (t.len == 0 && chunk == 0) {
+                break;
+            }
+        }
+    }
+    if (b->neg) {
+        buf[--pos] = '-';
+    }
+    bigint_free(&t);
+
+    size_t n = buflen - 1 - pos;
+    memmove(buf, &buf[pos], n + 1);
+    return n;
+}
+
+size_t bigint_serial_size(const bigint_t *b)
+{
+    return 5 + 4 * (size_t)b->len;
+}
+
+size_t bigint_serialize(const bigint_t *b, uint8_t *out)
+{
+    //u32 limb count, u8 sign, limbs, everything little endian
+    for (int i = 0; i < 4; i++) {
+        out[i] = (uint8_t)(b->len >> (8 * i));
+    }
+    out[4] = b->neg;
+    for (uint32_t l = 0; l < b->len; l++) {
+        for (int i = 0; i < 4; i++) {
+            out[5 + 4 * l + i] = (uint8_t)(b->limbs[l] >> (8 * i));
+        }
+    }
+    return bigint_serial_size(b);
+}
+
+size_t bigint_deserialize(bigint_t *b, const uint8_t *in, size_t len)
+{
+    if (len < 5) {
+        return 0;
+    }
+    uint32_t limbs = in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+    if ((len - 5) / 4 < limbs || !bigint_reserve(b, limbs)) {
+        return 0;
+    }
+    for (uint32_t l = 0; l < limbs; l++) {
+        const uint8_t *p = &in[5 + 4 * l];
+        b->limbs[l] = p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+    b->len = limbs;
+    b->neg = in[4] != 0;
+    normalize(b);
+    return 5 + 4 * (size_t)limbs;
+}
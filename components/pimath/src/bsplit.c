@@ -0,0 +1,191 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../bsplit.h"
+
+void bsplit_pqt_init(bsplit_pqt *s)
+{
+    bigint_init(&s->P);
+    bigint_init(&s->Q);
+    bigint_init(&s->B);
+    bigint_init(&s->T);
+}
+
+void bsplit_pqt_free(bsplit_pqt *s)
+{
+    bigint_free(&s->P);
+    bigint_free(&s->Q);
+    bigint_free(&s->B);
+    bigint_free(&s->T);
+}
+
+size_t bsplit_pqt_serial_size(const bsplit_pqt *s)
+{
+    return bigint_serial_size(&s->P) + bigint_serial_size(&s->Q) + bigint_serial_size(&s->B) + bigint_serial_size(&s->T);
+}
+
+size_t bsplit_pqt_serialize(const bsplit_pqt *s, uint8_t *out)
+{
+    size_t n = bigint_serialize(&s->P, out);
+    n += bigint_serialize(&s->Q, &out[n]);
+    n += bigint_serialize(&s->B, &out[n]);
+    n += bigint_serialize(&s->T, &out[n]);
+    return n;
+}
+
+size_t bsplit_pqt_deserialize(bsplit_pqt *s, const uint8_t *in, size_t len)
+{
+    bigint_t *parts[] = {&s->P, &s->Q, &s->B, &s->T};
+    size_t used = 0;
+    for (int i = 0; i < 4; i++) {
+        size_t n = bigint_deserialize(parts[i], &in[used], len - used);
+        if (n == 0) {
+            return 0;
+        }
+        used += n;
+    }
+    return used;
+}
+
+static bool bsplit_leaf(const bsplit_series *series, uint32_t n, bsplit_pqt *out)
+{
+    bool ok = series->p(&out->P, n) && series->q(&out->Q, n);
+    if (series->b != NULL) {
+        ok = ok && series->b(&out->B, n);
+    }
+    if (series->a != NULL) {
+        ok = ok && series->a(&out->T, n) && bigint_mul(&out->T, &out->T, &out->P);
+    } else {
+        ok = ok && bigint_copy(&out->T, &out->P);
+    }
+    return ok;
+}
+
+bool bsplit_merge(const bsplit_series *series, bsplit_pqt *left, const bsplit_pqt *right, bool need_p)
+{
+    bool ok = true;
+    bigint_t tmp;
+    bigint_init(&tmp);
+
+    //T = Br*Qr*Tl + Bl*Pl*Tr
+    ok = ok && bigint_mul(&left->T, &left->T, &right->Q);
+    ok = ok && bigint_mul(&tmp, &left->P, &right->T);
+    if (series->b != NULL) {
+        ok = ok && bigint_mul(&left->T, &left->T, &right->B);
+        ok = ok && bigint_mul(&tmp, &tmp, &left->B);
+        ok = ok && bigint_mul(&left->B, &left->B, &right->B);
+    }
+    ok = ok && bigint_add(&left->T, &left->T, &tmp);
+    ok = ok && bigint_mul(&left->Q, &left->Q, &right->Q);
+    if (need_p) {
+        ok = ok && bigint_mul(&left->P, &left->P, &right->P);
+    }
+    bigint_free(&tmp);
+    return ok;
+}
+
+bool bsplit_range(const bsplit_series *series, uint32_t n1, uint32_t n2, bsplit_pqt *out, bool need_p)
+{
+    // Recursion depth is only log2(n2-n1) and the frame holds a few pointers,
+    // the limbs themselves live on the heap. (The old double based bin_split in main.c kept everything on the stack.)
+    if (n2 - n1 == 1) {
+        return bsplit_leaf(series, n1, out);
+    }
+
+    uint32_t m = n1 + (n2 - n1) / 2;
+    bsplit_pqt right;
+    bsplit_pqt_init(&right);
+
+    bool ok = bsplit_range(series, n1, m, out, true);
+    ok = ok && bsplit_range(series, m, n2, &right, need_p);
+    ok = ok && bsplit_merge(series, out, &right, need_p);
+
+    bsplit_pqt_free(&right);
+    return ok;
+}
+
+bool bsplit_part(const bsplit_series *series, uint32_t terms, uint32_t part, uint32_t parts, bsplit_pqt *out)
+{
+    uint32_t n1 = (uint64_t)terms * part / parts;
+    uint32_t n2 = (uint64_t)terms * (part + 1) / parts;
+    if (n1 == n2) {
+        //more parts than terms, the empty range is the neutral element of the merge
+        bool ok = bigint_set_u32(&out->P, 1) && bigint_set_u32(&out->Q, 1) && bigint_set_u32(&out->T, 0);
+        return ok && ((series->b == NULL) || bigint_set_u32(&out->B, 1));
+    }
+    return bsplit_range(series, n1, n2, out, part + 1 < parts);
+}
+
+uint32_t bsplit_terms(const bsplit_series *series, uint32_t digits)
+{
+    return series->terms(digits + BSPLIT_GUARD_DIGITS);
+}
+
+bool bsplit_finish_ratio(const bsplit_series *series, bigint_t *out, const bsplit_pqt *sum, uint32_t digits, uint32_t num, uint32_t den)
+{
+    bigint_t n, d;
+    bigint_init(&n);
+    bigint_init(&d);
+
+    bool ok = bigint_mul_pow10(&n, &sum->T, digits);
+    ok = ok && bigint_mul_u32(&n, &n, num);
+    ok = ok && bigint_mul_u32(&d, &sum->Q, den);
+    if (series->b != NULL) {
+        ok = ok && bigint_mul(&d, &d, &sum->B);
+    }
+    ok = ok && bigint_divmod(out, NULL, &n, &d);
+
+    bigint_free(&n);
+    bigint_free(&d);
+    return ok;
+}
+
+bool bsplit_result(const bsplit_series *series, const bsplit_pqt *sum, uint32_t digits, bigint_t *out)
+{
+    bool ok = series->finish(series, out, sum, digits + BSPLIT_GUARD_DIGITS);
+
+    //drop the guard digits again
+    for (uint32_t i = 0; ok && i < BSPLIT_GUARD_DIGITS; i++) {
+        bigint_div_u32(out, 10);
+    }
+    return ok;
+}
+
+bool bsplit_compute(const bsplit_series *series, uint32_t digits, bigint_t *out)
+{
+    uint32_t terms = bsplit_terms(series, digits);
+    bsplit_pqt sum;
+    bsplit_pqt_init(&sum);
+
+    bool ok = bsplit_range(series, 0, terms, &sum, false);
+    ok = ok && bsplit_result(series, &sum, digits, out);
+    bsplit_pqt_free(&sum);
+    return ok;
+}
+
+size_t bsplit_format(const bigint_t *fixed, uint32_t digits, char *buf, size_t buflen)
+{
+    size_t size = bigint_decimal_size(fixed);
+    char *tmp = malloc(size);
+    if (tmp == NULL) {
+        return 0;
+    }
+    size_t len = bigint_to_decimal(fixed, tmp, size);
+
+    //pad with zeros so that there is at least one digit before the decimal point
+    size_t pad = (len <= digits) ? digits + 1 - len : 0;
+    size_t total = pad + len + 1;
+    if (len == 0 || total + 1 > buflen) {
+        free(tmp);
+        return 0;
+    }
+    memset(buf, '0', pad);
+    memcpy(&buf[pad], tmp, len);
+    size_t intlen = pad + len - digits;
+    memmove(&buf[intlen + 1], &buf[intlen], digits);
+    buf[intlen] = '.';
+    buf[total] = '\0';
+
+    free(tmp);
+    return total;
+}
@@ -0,0 +1,323 @@
+#include <math.h>
+
+#include "../bsplit.h"
+
+// Term generators for the constants provided by the binary splitting engine.
+// Every series starts at n = 0 with p(0)/q(0) being the value of the first product.
+
+static uint32_t terms_linear(uint32_t digits, double digits_per_term)
+{
+    return (uint32_t)(digits / digits_per_term) + 2;
+}
+
+static bool term_one(bigint_t *out, uint32_t n)
+{
+    return bigint_set_u32(out, 1);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Pi, Chudnovsky: 1/pi = 12/640320^(3/2) * sum (-1)^n (6n)! (13591409 + 545140134n) / ((3n)! (n!)^3 640320^(3n))    */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static bool chudnovsky_p(bigint_t *out, uint32_t n)
+{
+    if (n == 0) {
+        return bigint_set_u32(out, 1);
+    }
+    bool ok = bigint_set_i64(out, -(6 * (int64_t)n - 5));
+    ok = ok && bigint_mul_u32(out, out, 2 * n - 1);
+    ok = ok && bigint_mul_u32(out, out, 6 * n - 1);
+    return ok;
+}
+
+static bool chudnovsky_q(bigint_t *out, uint32_t n)
+{
+    if (n == 0) {
+        return bigint_set_u32(out, 1);
+    }
+    bool ok = bigint_set_i64(out, 10939058860032000LL);
+    ok = ok && bigint_mul_u32(out, out, n);
+    ok = ok && bigint_mul_u32(out, out, n);
+    ok = ok && bigint_mul_u32(out, out, n);
+    return ok;
+}
+
+static bool chudnovsky_a(bigint_t *out, uint32_t n)
+{
+    return bigint_set_i64(out, 13591409 + 545140134 * (int64_t)n);
+}
+
+static uint32_t chudnovsky_terms(uint32_t digits)
+{
+    return terms_linear(digits, 14.181647462725477);
+}
+
+static bool chudnovsky_finish(const bsplit_series *series, bigint_t *out, const bsplit_pqt *sum, uint32_t digits)
+{
+    //pi = 426880 * sqrt(10005) * Q / T
+    bigint_t root, num;
+    bigint_init(&root);
+    bigint_init(&num);
+
+    bool ok = bigint_set_u32(&root, 10005);
+    ok = ok && bigint_mul_pow10(&root, &root, 2 * digits);
+    ok = ok && bigint_isqrt(&root, &root);
+    ok = ok && bigint_mul(&num, &sum->Q, &root);
+    ok = ok && bigint_mul_u32(&num, &num, 426880);
+    ok = ok && bigint_divmod(out, NULL, &num, &sum->T);
+
+    bigint_free(&root);
+    bigint_free(&num);
+    return ok;
+}
+
+const bsplit_series bsplit_pi_chudnovsky = {
+    .name = "Pi (Chudnovsky)",
+    .symbol = "pi",
+    .p = chudnovsky_p,
+    .q = chudnovsky_q,
+    .a = chudnovsky_a,
+    .b = NULL,
+    .terms = chudnovsky_terms,
+    .finish = chudnovsky_finish,
+};
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   e = sum 1/n!                                                                                                      */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static bool e_q(bigint_t *out, uint32_t n)
+{
+    return bigint_set_u32(out, (n == 0) ? 1 : n);
+}
+
+static uint32_t e_terms(uint32_t digits)
+{
+    //smallest N with log10(N!) > digits
+    double sum = 0;
+    uint32_t n = 1;
+    while (sum <= digits) {
+        n++;
+        sum += log10((double)n);
+    }
+    return n + 1;
+}
+
+static bool e_finish(const bsplit_series *series, bigint_t *out, const bsplit_pqt *sum, uint32_t digits)
+{
+    return bsplit_finish_ratio(series, out, sum, digits, 1, 1);
+}
+
+const bsplit_series bsplit_e = {
+    .name = "Euler's number",
+    .symbol = "e",
+    .p = term_one,
+    .q = e_q,
+    .a = NULL,
+    .b = NULL,
+    .terms = e_terms,
+    .finish = e_finish,
+};
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   ln 2 = 2 atanh(1/3) = 2/3 * sum 1/((2n+1) 9^n)                                                                    */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static bool ln2_q(bigint_t *out, uint32_t n)
+{
+    return bigint_set_u32(out, (n == 0) ? 1 : 9);
+}
+
+static bool ln2_b(bigint_t *out, uint32_t n)
+{
+    return bigint_set_u32(out, 2 * n + 1);
+}
+
+static uint32_t ln2_terms(uint32_t digits)
+{
+    return terms_linear(digits, 0.9542425094393249);
+}
+
+static bool ln2_finish(const bsplit_series *series, bigint_t *out, const bsplit_pqt *sum, uint32_t digits)
+{
+    return bsplit_finish_ratio(series, out, sum, digits, 2, 3);
+}
+
+const bsplit_series bsplit_ln2 = {
+    .name = "Natural log of 2",
+    .symbol = "ln2",
+    .p = term_one,
+    .q = ln2_q,
+    .a = NULL,
+    .b = ln2_b,
+    .terms = ln2_terms,
+    .finish = ln2_finish,
+};
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   sqrt 2 = 7/5 * (1 - 1/50)^(-1/2) = 7/5 * sum C(2n,n) / 200^n                                                       */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static bool sqrt2_p(bigint_t *out, uint32_t n)
+{
+    return bigint_set_u32(out, (n == 0) ? 1 : 2 * n - 1);
+}
+
+static bool sqrt2_q(bigint_t *out, uint32_t n)
+{
+    return bigint_set_i64(out, (n == 0) ? 1 : 100 * (int64_t)n);
+}
+
+static uint32_t sqrt2_terms(uint32_t digits)
+{
+    return terms_linear(digits, 1.6989700043360187);
+}
+
+static bool sqrt2_finish(const bsplit_series *series, bigint_t *out, const bsplit_pqt *sum, uint32_t digits)
+{
+    return bsplit_finish_ratio(series, out, sum, digits, 7, 5);
+}
+
+const bsplit_series bsplit_sqrt2 = {
+    .name = "Square root of 2",
+    .symbol = "sqrt2",
+    .p = sqrt2_p,
+    .q = sqrt2_q,
+    .a = NULL,
+    .b = NULL,
+    .terms = sqrt2_terms,
+    .finish = sqrt2_finish,
+};
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   zeta(3), Amdeberhan-Zeilberger: 1/64 * sum (-1)^n (n!)^10 (205n^2 + 250n + 77) / ((2n+1)!)^5                       */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static bool zeta3_p(bigint_t *out, uint32_t n)
+{
+    if (n == 0) {
+        return bigint_set_u32(out, 1);
+    }
+    bool ok = bigint_set_i64(out, -(int64_t)n);
+    for (int i = 0; i < 4; i++) {
+        ok = ok && bigint_mul_u32(out, out, n);
+    }
+    return ok;
+}
+
+static bool zeta3_q(bigint_t *out, uint32_t n)
+{
+    if (n == 0) {
+        return bigint_set_u32(out, 1);
+    }
+    bool ok = bigint_set_u32(out, 32);
+    for (int i = 0; i < 5; i++) {
+        ok = ok && bigint_mul_u32(out, out, 2 * n + 1);
+    }
+    return ok;
+}
+
+static bool zeta3_a(bigint_t *out, uint32_t n)
+{
+    return bigint_set_i64(out, 205 * (int64_t)n * n + 250 * (int64_t)n + 77);
+}
+
+static uint32_t zeta3_terms(uint32_t digits)
+{
+    return terms_linear(digits, 3.0102999566398120);
+}
+
+static bool zeta3_finish(const bsplit_series *series, bigint_t *out, const bsplit_pqt *sum, uint32_t digits)
+{
+    return bsplit_finish_ratio(series, out, sum, digits, 1, 64);
+}
+
+const bsplit_series bsplit_zeta3 = {
+    .name = "Apery's constant zeta(3)",
+    .symbol = "zeta3",
+    .p = zeta3_p,
+    .q = zeta3_q,
+    .a = zeta3_a,
+    .b = NULL,
+    .terms = zeta3_terms,
+    .finish = zeta3_finish,
+};
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Catalan, Lupas: 1/64 * sum_{m>=1} (-1)^(m-1) 256^m (40m^2 - 24m + 3) (2m)!^3 (m!)^2 / (m^3 (2m-1) (4m)!^2)          */
+/*   The series index is shifted by one, n = m - 1                                                                     */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static bool catalan_p(bigint_t *out, uint32_t n)
+{
+    if (n == 0) {
+        return bigint_set_u32(out, 32);
+    }
+    uint32_t m = n + 1;
+    bool ok = bigint_set_i64(out, -32 * (int64_t)m);
+    ok = ok && bigint_mul_u32(out, out, m);
+    ok = ok && bigint_mul_u32(out, out, m);
+    ok = ok && bigint_mul_u32(out, out, 2 * m - 1);
+    return ok;
+}
+
+static bool catalan_q(bigint_t *out, uint32_t n)
+{
+    if (n == 0) {
+        return bigint_set_u32(out, 9);
+    }
+    uint32_t m = n + 1;
+    bool ok = bigint_set_u32(out, 4 * m - 1);
+    ok = ok && bigint_mul_u32(out, out, 4 * m - 1);
+    ok = ok && bigint_mul_u32(out, out, 4 * m - 3);
+    ok = ok && bigint_mul_u32(out, out, 4 * m - 3);
+    return ok;
+}
+
+static bool catalan_a(bigint_t *out, uint32_t n)
+{
+    int64_t m = n + 1;
+    return bigint_set_i64(out, 40 * m * m - 24 * m + 3);
+}
+
+static bool catalan_b(bigint_t *out, uint32_t n)
+{
+    uint32_t m = n + 1;
+    bool ok = bigint_set_u32(out, m);
+    ok = ok && bigint_mul_u32(out, out, m);
+    ok = ok && bigint_mul_u32(out, out, m);
+    ok = ok && bigint_mul_u32(out, out, 2 * m - 1);
+    return ok;
+}
+
+static uint32_t catalan_terms(uint32_t digits)
+{
+    return terms_linear(digits, 0.6020599913279624);
+}
+
+static bool catalan_finish(const bsplit_series *series, bigint_t *out, const bsplit_pqt *sum, uint32_t digits)
+{
+    return bsplit_finish_ratio(series, out, sum, digits, 1, 64);
+}
+
+const bsplit_series bsplit_catalan = {
+    .name = "Catalan's constant",
+    .symbol = "catalan",
+    .p = catalan_p,
+    .q = catalan_q,
+    .a = catalan_a,
+    .b = catalan_b,
+    .terms = catalan_terms,
+    .finish = catalan_finish,
+};
+
+const bsplit_series *const bsplit_series_list[] = {
+    &bsplit_pi_chudnovsky,
+    &bsplit_e,
+    &bsplit_ln2,
+    &bsplit_sqrt2,
+    &bsplit_zeta3,
+    &bsplit_catalan,
+};
+
+const uint32_t bsplit_series_count = sizeof(bsplit_series_list) / sizeof(bsplit_series_list[0]);
@@ -0,0 +1,366 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../digitstore.h"
+
+#define HEADER_CRC_OFFSET (DIGITSTORE_HEADER_SIZE - 4)
+
+static const uint64_t pow10_u64[DIGITSTORE_DIGITS_PER_WORD] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+    10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+};
+
+uint32_t digitstore_crc32(uint32_t crc, const void *data, size_t len)
+{
+    //CRC-32 (IEEE 802.3) with a nibble table, small enough for the firmware
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    const uint8_t *p = data;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc >> 4) ^ table[(crc ^ p[i]) & 0x0F];
+        crc = (crc >> 4) ^ table[(crc ^ (p[i] >> 4)) & 0x0F];
+    }
+    return ~crc;
+}
+
+static void put_le(uint8_t *p, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t get_le(const uint8_t *p, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)p[i] << (8 * i);
+    }
+    return value;
+}
+
+static void header_encode(const digitstore_header *h, uint8_t *buf)
+{
+    memset(buf, 0, DIGITSTORE_HEADER_SIZE);
+    memcpy(&buf[0], DIGITSTORE_MAGIC, 4);
+    put_le(&buf[4], DIGITSTORE_VERSION, 2);
+    put_le(&buf[6], DIGITSTORE_DIGITS_PER_WORD, 2);
+    put_le(&buf[8], h->words_per_block, 4);
+    put_le(&buf[12], h->block_count, 4);
+    put_le(&buf[16], h->digits, 8);
+    put_le(&buf[24], h->index_offset, 8);
+    memcpy(&buf[32], h->symbol, DIGITSTORE_SYMBOL_LEN);
+    memcpy(&buf[48], h->integer, DIGITSTORE_INTEGER_LEN);
+    put_le(&buf[HEADER_CRC_OFFSET], digitstore_crc32(0, buf, HEADER_CRC_OFFSET), 4);
+}
+
+static bool header_decode(digitstore_header *h, const uint8_t *buf)
+{
+    if (memcmp(buf, DIGITSTORE_MAGIC, 4) != 0 || get_le(&buf[4], 2) != DIGITSTORE_VERSION
+        || get_le(&buf[6], 2) != DIGITSTORE_DIGITS_PER_WORD
+        || get_le(&buf[HEADER_CRC_OFFSET], 4) != digitstore_crc32(0, buf, HEADER_CRC_OFFSET)) {
+        return false;
+    }
+    h->words_per_block = get_le(&buf[8], 4);
+    h->block_count = get_le(&buf[12], 4);
+    h->digits = get_le(&buf[16], 8);
+    h->index_offset = get_le(&buf[24], 8);
+    memcpy(h->symbol, &buf[32], DIGITSTORE_SYMBOL_LEN);
+    memcpy(h->integer, &buf[48], DIGITSTORE_INTEGER_LEN);
+    h->symbol[DIGITSTORE_SYMBOL_LEN - 1] = '\0';
+    h->integer[DIGITSTORE_INTEGER_LEN - 1] = '\0';
+
+    uint64_t block_digits = (uint64_t)h->words_per_block * DIGITSTORE_DIGITS_PER_WORD;
+    return h->words_per_block == DIGITSTORE_WORDS_PER_BLOCK && h->block_count == (h->digits + block_digits - 1) / block_digits
+           && h->index_offset == DIGITSTORE_HEADER_SIZE + (uint64_t)h->block_count * h->words_per_block * 8;
+}
+
+uint64_t digitstore_size(uint64_t digits)
+{
+    uint64_t blocks = (digits + DIGITSTORE_BLOCK_DIGITS - 1) / DIGITSTORE_BLOCK_DIGITS;
+    return DIGITSTORE_HEADER_SIZE + blocks * (DIGITSTORE_BLOCK_BYTES + 4);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Writer                                                                                                            */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static bool write_next(digitstore_writer *w, const void *data, size_t len)
+{
+    if (w->file == NULL) {
+        if (w->mem == NULL || w->mem_pos + len > w->mem_size) {
+            return false;
+        }
+        memcpy(&w->mem[w->mem_pos], data, len);
+        w->mem_pos += len;
+        return true;
+    }
+    return fwrite(data, 1, len, w->file) == len;
+}
+
+static bool writer_begin(digitstore_writer *w, const char *symbol, const char *integer)
+{
+    w->header.words_per_block = DIGITSTORE_WORDS_PER_BLOCK;
+    w->header.index_offset = DIGITSTORE_HEADER_SIZE;
+    strncpy(w->header.symbol, symbol, DIGITSTORE_SYMBOL_LEN - 1);
+    strncpy(w->header.integer, integer, DIGITSTORE_INTEGER_LEN - 1);
+
+    //placeholder, the final header is written by digitstore_finish
+    uint8_t buf[DIGITSTORE_HEADER_SIZE];
+    header_encode(&w->header, buf);
+    return write_next(w, buf, sizeof(buf));
+}
+
+bool digitstore_create(digitstore_writer *w, const char *path, const char *symbol, const char *integer)
+{
+    memset(w, 0, sizeof(*w));
+    w->file = fopen(path, "wb");
+    if (w->file == NULL) {
+        return false;
+    }
+    if (!writer_begin(w, symbol, integer)) {
+        fclose(w->file);
+        w->file = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool digitstore_create_memory(digitstore_writer *w, uint8_t *buf, size_t size, const char *symbol, const char *integer)
+{
+    memset(w, 0, sizeof(*w));
+    w->mem = buf;
+    w->mem_size = size;
+    return writer_begin(w, symbol, integer);
+}
+
+static bool flush_block(digitstore_writer *w)
+{
+    uint8_t buf[DIGITSTORE_BLOCK_BYTES];
+    for (int i = 0; i < DIGITSTORE_WORDS_PER_BLOCK; i++) {
+        put_le(&buf[8 * i], w->words[i], 8);
+    }
+    if (w->header.block_count == w->crc_capacity) {
+        uint32_t capacity = w->crc_capacity ? 2 * w->crc_capacity : 64;
+        uint32_t *crcs = realloc(w->crcs, capacity * sizeof(uint32_t));
+        if (crcs == NULL) {
+            return false;
+        }
+        w->crcs = crcs;
+        w->crc_capacity = capacity;
+    }
+    w->crcs[w->header.block_count++] = digitstore_crc32(0, buf, sizeof(buf));
+    memset(w->words, 0, sizeof(w->words));
+    w->fill = 0;
+    return write_next(w, buf, sizeof(buf));
+}
+
+bool digitstore_append(digitstore_writer *w, const char *digits, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (digits[i] < '0' || digits[i] > '9') {
+            return false;
+        }
+        uint32_t word = w->fill / DIGITSTORE_DIGITS_PER_WORD;
+        uint32_t pos = w->fill % DIGITSTORE_DIGITS_PER_WORD;
+        w->words[word] += (uint64_t)(digits[i] - '0') * pow10_u64[DIGITSTORE_DIGITS_PER_WORD - 1 - pos];
+        w->header.digits++;
+        if (++w->fill == DIGITSTORE_BLOCK_DIGITS && !flush_block(w)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool digitstore_finish(digitstore_writer *w)
+{
+    //the last block is padded with zeros, so every block has the same size
+    bool ok = (w->fill == 0) || flush_block(w);
+
+    uint8_t crc[4];
+    for (uint32_t b = 0; ok && b < w->header.block_count; b++) {
+        put_le(crc, w->crcs[b], 4);
+        ok = write_next(w, crc, sizeof(crc));
+    }
+
+    uint8_t buf[DIGITSTORE_HEADER_SIZE];
+    w->header.index_offset = DIGITSTORE_HEADER_SIZE + (uint64_t)w->header.block_count * DIGITSTORE_BLOCK_BYTES;
+    header_encode(&w->header, buf);
+    if (w->file != NULL) {
+        ok = ok && fseek(w->file, 0, SEEK_SET) == 0;
+        ok = ok && fwrite(buf, 1, sizeof(buf), w->file) == sizeof(buf);
+        ok = (fclose(w->file) == 0) && ok;
+    } else if (ok) {
+        memcpy(w->mem, buf, sizeof(buf));
+    }
+    free(w->crcs);
+    w->crcs = NULL;
+    w->file = NULL;
+    return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Reader                                                                                                            */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static bool read_at(digitstore_reader *r, uint64_t offset, void *out, size_t len)
+{
+    if (r->file == NULL) {
+        if (offset + len > r->size) {
+            return false;
+        }
+        memcpy(out, &r->data[offset], len);
+        return true;
+    }
+    return fseek(r->file, (long)offset, SEEK_SET) == 0 && fread(out, 1, len, r->file) == len;
+}
+
+static bool load_index(digitstore_reader *r)
+{
+    uint8_t buf[DIGITSTORE_HEADER_SIZE];
+    if (!read_at(r, 0, buf, sizeof(buf)) || !header_decode(&r->header, buf)) {
+        return false;
+    }
+    r->crcs = malloc((r->header.block_count + 1) * sizeof(uint32_t));
+    if (r->crcs == NULL) {
+        return false;
+    }
+    uint8_t crc[4];
+    for (uint32_t b = 0; b < r->header.block_count; b++) {
+        if (!read_at(r, r->header.index_offset + 4 * (uint64_t)b, crc, sizeof(crc))) {
+            return false;
+        }
+        r->crcs[b] = get_le(crc, 4);
+    }
+    return true;
+}
+
+bool digitstore_open(digitstore_reader *r, const char *path)
+{
+    memset(r, 0, sizeof(*r));
+    r->file = fopen(path, "rb");
+    if (r->file == NULL) {
+        return false;
+    }
+    if (!load_index(r)) {
+        digitstore_close(r);
+        return false;
+    }
+    return true;
+}
+
+bool digitstore_open_memory(digitstore_reader *r, const void *data, size_t size)
+{
+    memset(r, 0, sizeof(*r));
+    r->data = data;
+    r->size = size;
+    if (!load_index(r)) {
+        digitstore_close(r);
+        return false;
+    }
+    return true;
+}
+
+void digitstore_close(digitstore_reader *r)
+{
+    if (r->file != NULL) {
+        fclose(r->file);
+    }
+    free(r->crcs);
+    r->file = NULL;
+    r->data = NULL;
+    r->crcs = NULL;
+}
+
+static uint64_t word_offset(const digitstore_reader *r, uint64_t k)
+{
+    uint64_t block_digits = (uint64_t)r->header.words_per_block * DIGITSTORE_DIGITS_PER_WORD;
+    uint64_t block = k / block_digits;
+    uint64_t word = (k % block_digits) / DIGITSTORE_DIGITS_PER_WORD;
+    return DIGITSTORE_HEADER_SIZE + (block * r->header.words_per_block + word) * 8;
+}
+
+int digitstore_digit(digitstore_reader *r, uint64_t k)
+{
+    uint8_t buf[8];
+    if (k >= r->header.digits || !read_at(r, word_offset(r, k), buf, sizeof(buf))) {
+        return -1;
+    }
+    uint32_t pos = k % DIGITSTORE_DIGITS_PER_WORD;
+    return (get_le(buf, 8) / pow10_u64[DIGITSTORE_DIGITS_PER_WORD - 1 - pos]) % 10;
+}
+
+size_t digitstore_read(digitstore_reader *r, uint64_t first, char *out, size_t count)
+{
+    size_t done = 0;
+    uint8_t buf[8];
+
+    if (first >= r->header.digits) {
+        return 0;
+    }
+    if (count > r->header.digits - first) {
+        count = r->header.digits - first;
+    }
+    //one word at a time, the digits of a word are unpacked from the least significant end
+    while (done < count) {
+        uint64_t k = first + done;
+        uint32_t pos = k % DIGITSTORE_DIGITS_PER_WORD;
+        uint32_t n = DIGITSTORE_DIGITS_PER_WORD - pos;
+        if (n > count - done) {
+            n = count - done;
+        }
+        if (!read_at(r, word_offset(r, k), buf, sizeof(buf))) {
+            break;
+        }
+        uint64_t word = get_le(buf, 8) / pow10_u64[DIGITSTORE_DIGITS_PER_WORD - pos - n];
+        for (int i = n - 1; i >= 0; i--) {
+            out[done + i] = '0' + word % 10;
+            word /= 10;
+        }
+        done += n;
+    }
+    return done;
+}
+
+const uint8_t *digitstore_block_data(const digitstore_reader *r, uint32_t block)
+{
+    if (r->file != NULL || block >= r->header.block_count) {
+        return NULL;
+    }
+    return &r->data[DIGITSTORE_HEADER_SIZE + (uint64_t)block * r->header.words_per_block * 8];
+}
+
+bool digitstore_verify_block(digitstore_reader *r, uint32_t block)
+{
+    if (block >= r->header.block_count) {
+        return false;
+    }
+    const uint8_t *data = digitstore_block_data(r, block);
+    if (data != NULL) {
+        return digitstore_crc32(0, data, r->header.words_per_block * 8) == r->crcs[block];
+    }
+    uint8_t buf[64];
+    uint32_t crc = 0;
+    uint64_t offset = DIGITSTORE_HEADER_SIZE + (uint64_t)block * r->header.words_per_block * 8;
+    for (uint32_t done = 0; done < r->header.words_per_block * 8; done += sizeof(buf)) {
+        if (!read_at(r, offset + done, buf, sizeof(buf))) {
+            return false;
+        }
+        crc = digitstore_crc32(crc, buf, sizeof(buf));
+    }
+    return crc == r->crcs[block];
+}
+
+int64_t digitstore_verify(digitstore_reader *r)
+{
+    for (uint32_t b = 0; b < r->header.block_count; b++) {
+        if (!digitstore_verify_block(r, b)) {
+            return b;
+        }
+    }
+    return -1;
+}
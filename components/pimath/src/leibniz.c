@@ -0,0 +1,97 @@
+#include <math.h>
+
+#include "../leibniz.h"
+
+// The lane loop relies on strict IEEE evaluation for the compensation, never build this file with -ffast-math.
+
+void leibniz_acc_init(leibniz_acc *acc)
+{
+    acc->sum = 0;
+    acc->comp = 0;
+}
+
+void leibniz_acc_add(leibniz_acc *acc, double value)
+{
+    double t = acc->sum + value;
+    if (fabs(acc->sum) >= fabs(value)) {
+        acc->comp += (acc->sum - t) + value;
+    } else {
+        acc->comp += (value - t) + acc->sum;
+    }
+    acc->sum = t;
+}
+
+double leibniz_acc_value(const leibniz_acc *acc)
+{
+    return acc->sum + acc->comp;
+}
+
+static leibniz_acc leibniz_sum(uint64_t first, uint64_t stride, uint64_t count)
+{
+    //terms k = first + i * stride for i < count, lane l takes every i with i % LEIBNIZ_LANES == l.
+    //A lane advances k by LEIBNIZ_LANES * stride, which is even, so its sign never changes.
+    double num[LEIBNIZ_LANES], den[LEIBNIZ_LANES], sum[LEIBNIZ_LANES], comp[LEIBNIZ_LANES];
+    double step = 2.0 * LEIBNIZ_LANES * stride;
+    uint64_t rounds = count / LEIBNIZ_LANES;
+    uint32_t tail = count % LEIBNIZ_LANES;
+
+    for (int l = 0; l < LEIBNIZ_LANES; l++) {
+        uint64_t k = first + l * stride;
+        num[l] = (k & 1) ? -4.0 : 4.0;
+        den[l] = 2.0 * k + 1.0;
+        sum[l] = 0;
+        comp[l] = 0;
+    }
+
+    //Kahan per lane, the same operation on every lane so host compilers turn it into vector instructions
+    for (uint64_t r = 0; r < rounds; r++) {
+        for (int l = 0; l < LEIBNIZ_LANES; l++) {
+            double y = num[l] / den[l] - comp[l];
+            double t = sum[l] + y;
+            comp[l] = (t - sum[l]) - y;
+            sum[l] = t;
+            den[l] += step;
+        }
+    }
+    for (uint32_t l = 0; l < tail; l++) {
+        double y = num[l] / den[l] - comp[l];
+        double t = sum[l] + y;
+        comp[l] = (t - sum[l]) - y;
+        sum[l] = t;
+    }
+
+    leibniz_acc acc;
+    leibniz_acc_init(&acc);
+    for (int l = 0; l < LEIBNIZ_LANES; l++) {
+        leibniz_acc_add(&acc, sum[l]);
+        leibniz_acc_add(&acc, -comp[l]);
+    }
+    return acc;
+}
+
+leibniz_acc leibniz_partial(uint64_t terms, uint32_t worker, uint32_t workers, leibniz_split split)
+{
+    if (split == LEIBNIZ_INTERLEAVED) {
+        uint64_t count = (terms > worker) ? (terms - worker + workers - 1) / workers : 0;
+        return leibniz_sum(worker, workers, count);
+    }
+    uint64_t first = terms * worker / workers;
+    uint64_t last = terms * (worker + 1) / workers;
+    return leibniz_sum(first, 1, last - first);
+}
+
+double leibniz_reduce(const leibniz_acc *partials, uint32_t workers)
+{
+    leibniz_acc acc;
+    leibniz_acc_init(&acc);
+    for (uint32_t w = 0; w < workers; w++) {
+        leibniz_acc_add(&acc, partials[w].sum);
+        leibniz_acc_add(&acc, partials[w].comp);
+    }
+    return leibniz_acc_value(&acc);
+}
+
+const char *leibniz_split_name(leibniz_split split)
+{
+    return (split == LEIBNIZ_INTERLEAVED) ? "interleaved" : "blocked";
+}
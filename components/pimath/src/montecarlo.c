@@ -0,0 +1,99 @@
+#include "../montecarlo.h"
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+// x^2 + y^2 < 1 with 31bit coordinates, so the sum of squares fits into 63 bits
+#define MC_COORD_SHIFT 1
+#define MC_RADIUS_SQ (1ULL << 62)
+
+void mc_sampler_init(mc_sampler *s, uint64_t seed, uint32_t stream)
+{
+    s->key[0] = (uint32_t)seed;
+    s->key[1] = (uint32_t)(seed >> 32) ^ stream;
+    mc_sampler_reset(s);
+}
+
+void mc_sampler_reset(mc_sampler *s)
+{
+    s->counter = 0;
+    s->hits = 0;
+    s->samples = 0;
+}
+
+void mc_philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4])
+{
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for (int r = 0; r < PHILOX_ROUNDS; r++) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t)p1;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+uint64_t mc_sample(mc_sampler *s, uint32_t blocks)
+{
+    //structure of arrays over the lanes, every round is the same operation on all lanes
+    uint32_t c0[MC_LANES], c1[MC_LANES], c2[MC_LANES], c3[MC_LANES];
+    uint64_t hits = 0;
+    uint64_t counter = s->counter;
+
+    for (uint32_t b = 0; b < blocks; b++) {
+        uint32_t k0 = s->key[0], k1 = s->key[1];
+
+        for (int l = 0; l < MC_LANES; l++) {
+            c0[l] = (uint32_t)(counter + l);
+            c1[l] = (uint32_t)((counter + l) >> 32);
+            c2[l] = 0;
+            c3[l] = 0;
+        }
+
+        for (int r = 0; r < PHILOX_ROUNDS; r++) {
+            for (int l = 0; l < MC_LANES; l++) {
+                uint64_t p0 = (uint64_t)PHILOX_M0 * c0[l];
+                uint64_t p1 = (uint64_t)PHILOX_M1 * c2[l];
+                c0[l] = (uint32_t)(p1 >> 32) ^ c1[l] ^ k0;
+                c1[l] = (uint32_t)p1;
+                c2[l] = (uint32_t)(p0 >> 32) ^ c3[l] ^ k1;
+                c3[l] = (uint32_t)p0;
+            }
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+
+        for (int l = 0; l < MC_LANES; l++) {
+            uint64_t x0 = c0[l] >> MC_COORD_SHIFT, y0 = c1[l] >> MC_COORD_SHIFT;
+            uint64_t x1 = c2[l] >> MC_COORD_SHIFT, y1 = c3[l] >> MC_COORD_SHIFT;
+            hits += (x0 * x0 + y0 * y0 < MC_RADIUS_SQ);
+            hits += (x1 * x1 + y1 * y1 < MC_RADIUS_SQ);
+        }
+        counter += MC_LANES;
+    }
+
+    s->counter = counter;
+    s->hits += hits;
+    s->samples += (uint64_t)blocks * MC_POINTS_PER_BLOCK;
+    return hits;
+}
+
+double mc_estimate(uint64_t hits, uint64_t samples)
+{
+    if (samples == 0) {
+        return 0;
+    }
+    return 4.0 * (double)hits / (double)samples;
+}
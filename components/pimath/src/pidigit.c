@@ -0,0 +1,334 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../pidigit.h"
+#include "../bsplit.h"
+
+// Montgomery arithmetic modulo an odd m < 2^31 with R = 2^32
+typedef struct {
+    uint32_t m;
+    uint32_t minv;      // -m^-1 mod R
+    uint32_t r1;        // R mod m
+    uint32_t r2;        // R^2 mod m
+} mont_ctx;
+
+static void mont_init(mont_ctx *c, uint32_t m)
+{
+    uint32_t inv = m;   // Newton iteration for m^-1 mod 2^32, correct to 3 bits to start with
+    for (int i = 0; i < 4; i++) {
+        inv *= 2 - m * inv;
+    }
+    c->m = m;
+    c->minv = -inv;
+    c->r1 = (uint32_t)((1ULL << 32) % m);
+    c->r2 = (uint32_t)(((uint64_t)c->r1 * c->r1) % m);
+}
+
+static inline uint32_t mont_redc(const mont_ctx *c, uint64_t t)
+{
+    uint32_t q = (uint32_t)t * c->minv;
+    uint32_t u = (uint32_t)((t + (uint64_t)q * c->m) >> 32);
+    return (u >= c->m) ? u - c->m : u;
+}
+
+static inline uint32_t mont_mul(const mont_ctx *c, uint32_t a, uint32_t b)
+{
+    return mont_redc(c, (uint64_t)a * b);
+}
+
+static inline uint32_t mont_add(const mont_ctx *c, uint32_t a, uint32_t b)
+{
+    uint32_t s = a + b;
+    return (s >= c->m) ? s - c->m : s;
+}
+
+static inline uint32_t mont_from(const mont_ctx *c, uint64_t x)
+{
+    return mont_mul(c, (uint32_t)(x % c->m), c->r2);
+}
+
+static uint32_t inverse_mod(uint32_t x, uint32_t m)
+{
+    int64_t t = 0, newt = 1;
+    int64_t r = m, newr = x;
+    while (newr != 0) {
+        int64_t q = r / newr, tmp;
+        tmp = t - q * newt; t = newt; newt = tmp;
+        tmp = r - q * newr; r = newr; newr = tmp;
+    }
+    return (uint32_t)((t < 0) ? t + m : t);
+}
+
+static uint32_t pow_mod(uint32_t base, uint32_t exp, uint32_t m)
+{
+    uint64_t result = 1 % m, b = base % m;
+    while (exp > 0) {
+        if (exp & 1) {
+            result = result * b % m;
+        }
+        b = b * b % m;
+        exp >>= 1;
+    }
+    return (uint32_t)result;
+}
+
+// Strips all factors a from f, returns the unit part in Montgomery form and adds the valuation to v
+static inline uint32_t unit_part(const mont_ctx *c, uint64_t f, uint32_t a, int32_t *v, int32_t sign)
+{
+    while (f % a == 0) {
+        f /= a;
+        *v += sign;
+    }
+    return mont_from(c, f);
+}
+
+// State of one prime while the terms are walked, see pidigit_primes()
+typedef struct {
+    mont_ctx c;
+    uint32_t a;
+    uint32_t vmax;
+    uint32_t apow[32];
+    uint32_t F, dF, ddF;
+    uint32_t G, dG, ddG;
+    uint32_t X, dX;
+    uint32_t rk, r_k2, r_k3a, r_k3b;
+    uint32_t S, UF, UG;
+    int32_t v;
+} pidigit_lane;
+
+static void pidigit_lane_init(pidigit_lane *l, const pidigit_job *job, uint32_t a)
+{
+    mont_ctx *c = &l->c;
+    uint64_t m = 1;
+    l->a = a;
+    l->vmax = 0;
+    while (m * a <= job->limit) {
+        m *= a;
+        l->vmax++;
+    }
+    mont_init(c, (uint32_t)m);
+
+    l->apow[0] = c->r1;
+    for (uint32_t j = 1; j <= l->vmax; j++) {
+        l->apow[j] = mont_mul(c, l->apow[j - 1], mont_from(c, a));
+    }
+
+    //D_k / D_(k-1) = F(k) / G(k) with F(k) = 3 (3k-1)(3k-2) = 27k^2 - 27k + 6 and G(k) = k (2k-1) = 2k^2 - k,
+    //both are stepped with finite differences in Montgomery form, as is the numerator X(k) = 50k - 6
+    l->F = mont_from(c, 6);
+    l->dF = 0;
+    l->ddF = mont_from(c, 54);
+    l->G = 0;
+    l->dG = c->r1;
+    l->ddG = mont_from(c, 4);
+    l->X = mont_from(c, m - 6 % m);
+    l->dX = mont_from(c, 50);
+
+    //F or G contain a only if k mod a hits one of these residues
+    l->rk = 0;
+    l->r_k2 = (a + 1) / 2;                                  // 2k = 1
+    l->r_k3a = (a == 3) ? 0 : inverse_mod(3, a);           // 3k = 1
+    l->r_k3b = (a == 3) ? 0 : (2 * l->r_k3a) % a;          // 3k = 2
+
+    l->S = 0;
+    l->UF = c->r1;
+    l->UG = c->r1;
+    l->v = 0;
+}
+
+static inline void pidigit_lane_step(pidigit_lane *l, uint32_t k)
+{
+    const mont_ctx *c = &l->c;
+    uint32_t a = l->a;
+
+    l->F = mont_add(c, l->F, l->dF);
+    l->dF = mont_add(c, l->dF, l->ddF);
+    l->G = mont_add(c, l->G, l->dG);
+    l->dG = mont_add(c, l->dG, l->ddG);
+    l->X = mont_add(c, l->X, l->dX);
+    l->rk = (l->rk + 1 == a) ? 0 : l->rk + 1;
+
+    uint32_t f = l->F, g = l->G;
+    if (a == 3 || l->rk == l->r_k3a || l->rk == l->r_k3b) {
+        f = mont_mul(c, unit_part(c, 3ULL * k - 1, a, &l->v, 1), unit_part(c, 3ULL * k - 2, a, &l->v, 1));
+        f = mont_mul(c, f, unit_part(c, 3, a, &l->v, 1));
+    }
+    if (l->rk == 0 || l->rk == l->r_k2) {
+        g = mont_mul(c, unit_part(c, k, a, &l->v, -1), unit_part(c, 2ULL * k - 1, a, &l->v, -1));
+    }
+
+    l->S = mont_mul(c, l->S, f);
+    l->UF = mont_mul(c, l->UF, f);
+    l->UG = mont_mul(c, l->UG, g);
+
+    //only terms whose denominator contains a have an a-part
+    if (l->v > 0) {
+        l->S = mont_add(c, l->S, mont_mul(c, mont_mul(c, l->X, l->UG), l->apow[l->vmax - l->v]));
+    }
+}
+
+static double pidigit_lane_result(const pidigit_lane *l, const pidigit_job *job)
+{
+    //a-part = S / UF * 10^e / a^vmax
+    const mont_ctx *c = &l->c;
+    uint32_t s = mont_redc(c, l->S);
+    uint32_t uf = mont_redc(c, l->UF);
+    uint64_t r = (uint64_t)s * inverse_mod(uf, c->m) % c->m;
+    r = r * pow_mod(10, job->exponent, c->m) % c->m;
+    return (double)r / (double)c->m;
+}
+
+// Walks the terms for up to PIDIGIT_LANES primes at once. Every prime is a serial chain of
+// multiplications, interleaving independent primes keeps the multiplier busy.
+static double pidigit_primes(const pidigit_job *job, const uint32_t *primes, uint32_t count)
+{
+    pidigit_lane lanes[PIDIGIT_LANES];
+    double sum = 0;
+
+    for (uint32_t l = 0; l < count; l++) {
+        pidigit_lane_init(&lanes[l], job, primes[l]);
+    }
+    for (uint32_t k = 1; k < job->terms; k++) {
+        for (uint32_t l = 0; l < count; l++) {
+            pidigit_lane_step(&lanes[l], k);
+        }
+    }
+    for (uint32_t l = 0; l < count; l++) {
+        sum += pidigit_lane_result(&lanes[l], job);
+    }
+    return sum;
+}
+
+static uint32_t *sieve_odd_primes(uint32_t limit, uint32_t *count)
+{
+    uint8_t *composite = calloc(limit + 1, 1);
+    if (composite == NULL) {
+        return NULL;
+    }
+    uint32_t n = 0;
+    for (uint32_t i = 3; i <= limit; i += 2) {
+        if (composite[i]) {
+            continue;
+        }
+        n++;
+        for (uint64_t j = (uint64_t)i * i; j <= limit; j += 2 * i) {
+            composite[j] = 1;
+        }
+    }
+    uint32_t *primes = malloc(sizeof(uint32_t) * (n + 1));
+    if (primes != NULL) {
+        n = 0;
+        for (uint32_t i = 3; i <= limit; i += 2) {
+            if (!composite[i]) {
+                primes[n++] = i;
+            }
+        }
+    }
+    free(composite);
+    *count = n;
+    return primes;
+}
+
+bool pidigit_job_init(pidigit_job *job, uint32_t position)
+{
+    memset(job, 0, sizeof(*job));
+    if (position == 0) {
+        return false;
+    }
+    job->position = position;
+    job->exponent = position - 1;
+
+    //10^e * term_N must be below 10^-guard
+    double terms = (job->exponent + PIDIGIT_DIGITS + PIDIGIT_GUARD_DIGITS) / log10(13.5) + 2;
+    if (terms * 3 >= (double)(1u << 31)) {
+        return false;
+    }
+    job->terms = (uint32_t)terms;
+    job->limit = 3 * job->terms;
+
+    //2^(k + v2(C(3k,k))) must divide 10^e for every term, otherwise the power of two part is not an integer
+    if (job->exponent < job->terms + (uint32_t)log2(job->limit) + 1) {
+        job->direct = true;
+        return true;
+    }
+    job->primes = sieve_odd_primes(job->limit, &job->prime_count);
+    return job->primes != NULL;
+}
+
+void pidigit_job_free(pidigit_job *job)
+{
+    free(job->primes);
+    job->primes = NULL;
+}
+
+double pidigit_partial(const pidigit_job *job, uint32_t worker, uint32_t workers)
+{
+    //primes are dealt round robin, neighbouring primes cost about the same
+    double sum = 0;
+    if (job->direct) {
+        return 0;
+    }
+    uint32_t batch[PIDIGIT_LANES];
+    uint32_t count = 0;
+    for (uint32_t i = worker; i < job->prime_count; i += workers) {
+        batch[count++] = job->primes[i];
+        if (count == PIDIGIT_LANES || i + workers >= job->prime_count) {
+            sum += pidigit_primes(job, batch, count);
+            sum -= floor(sum);
+            count = 0;
+        }
+    }
+    return sum;
+}
+
+static bool pidigit_direct(const pidigit_job *job, char *out)
+{
+    uint32_t digits = job->position + PIDIGIT_DIGITS;
+    bigint_t fixed;
+    bigint_init(&fixed);
+    bool ok = bsplit_compute(&bsplit_pi_chudnovsky, digits, &fixed);
+
+    char *buf = NULL;
+    if (ok) {
+        size_t size = bigint_decimal_size(&fixed);
+        buf = malloc(size);
+        ok = (buf != NULL) && (bigint_to_decimal(&fixed, buf, size) == digits + 1);
+    }
+    if (ok) {
+        //buf is "3" followed by the digits after the decimal point
+        memcpy(out, &buf[job->position], PIDIGIT_DIGITS);
+        out[PIDIGIT_DIGITS] = '\0';
+    }
+    free(buf);
+    bigint_free(&fixed);
+    return ok;
+}
+
+bool pidigit_digits(const pidigit_job *job, double partial_sum, char *out)
+{
+    if (job->direct) {
+        return pidigit_direct(job, out);
+    }
+    double frac = partial_sum - floor(partial_sum);
+    for (int i = 0; i < PIDIGIT_DIGITS; i++) {
+        frac *= 10;
+        int d = (int)frac;
+        out[i] = '0' + d;
+        frac -= d;
+    }
+    out[PIDIGIT_DIGITS] = '\0';
+    return true;
+}
+
+bool pidigit_compute(uint32_t position, char *out)
+{
+    pidigit_job job;
+    if (!pidigit_job_init(&job, position)) {
+        pidigit_job_free(&job);
+        return false;
+    }
+    bool ok = pidigit_digits(&job, pidigit_partial(&job, 0, 1), out);
+    pidigit_job_free(&job);
+    return ok;
+}
@@ -0,0 +1,98 @@
+#include "trace.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "trace_ring.h"
+
+#define TAG "TRACE"
+
+// internal RAM, the scheduler hook also runs while the flash cache is off
+static DRAM_ATTR trace_event events[TRACE_MAX_CORES][TRACE_RING_EVENTS];
+static DRAM_ATTR trace_ring rings[TRACE_MAX_CORES];
+static DRAM_ATTR volatile bool recording = false;
+static TaskStatus_t task_states[TRACE_MAX_TASKS];
+
+void IRAM_ATTR trace_record(trace_type type, uint16_t id, uint32_t arg) {
+    if (!recording) {
+        return;
+    }
+    //a task moved to the other core between the two lines only lands in the other ring, the slot stays its own
+    uint32_t core = xPortGetCoreID();
+    trace_event *e = trace_ring_claim(&rings[core]);
+    e->time_us = (uint32_t)esp_timer_get_time();
+    e->type = type;
+    e->core = core;
+    e->id = id;
+    e->arg = arg;
+    e->task = (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle();
+}
+
+void IRAM_ATTR trace_task_switched_in(void) {
+    trace_record(TRACE_TASK_SWITCH, 0, 0);
+}
+
+void trace_init(void) {
+    _Static_assert((TRACE_RING_EVENTS & (TRACE_RING_EVENTS - 1)) == 0, "TRACE_RING_EVENTS must be a power of two");
+    _Static_assert(sizeof(trace_event) == 16, "the host tool expects 16 byte events");
+    for (int core = 0; core < TRACE_MAX_CORES; core++) {
+        trace_ring_init(&rings[core], events[core], TRACE_RING_EVENTS, sizeof(trace_event));
+    }
+    trace_start();
+}
+
+void trace_start(void) {
+    //older events are dropped, the rings start empty
+    recording = false;
+    trace_ring_clear(rings, TRACE_MAX_CORES);
+    recording = true;
+}
+
+void trace_stop(void) {
+    recording = false;
+}
+
+bool trace_enabled(void) {
+    return recording;
+}
+
+void trace_serialize(trace_writer write, void *ctx) {
+    bool was_recording = recording;
+    trace_header header = {
+        .magic = TRACE_MAGIC,
+        .version = TRACE_VERSION,
+        .cores = portNUM_PROCESSORS,
+        .event_size = sizeof(trace_event),
+        .ring_events = TRACE_RING_EVENTS,
+    };
+
+    //a tick for events which were being written when the recording stopped
+    recording = false;
+    vTaskDelay(1);
+
+    header.task_count = uxTaskGetSystemState(task_states, TRACE_MAX_TASKS, NULL);
+    if (header.task_count == 0) {
+        ESP_LOGW(TAG, "More than %i tasks, the dump has no task names", TRACE_MAX_TASKS);
+    }
+    write(&header, sizeof(header), ctx);
+    for (uint32_t i = 0; i < header.task_count; i++) {
+        trace_task task = {.task = (uint32_t)(uintptr_t)task_states[i].xHandle};
+        strncpy(task.name, task_states[i].pcTaskName, TRACE_TASK_NAME_LEN - 1);
+        write(&task, sizeof(task), ctx);
+    }
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        trace_ring_serialize(&rings[core], write, ctx);
+    }
+
+    //the dump continues where it stopped, the gap shows as missing events
+    recording = was_recording;
+}
+
+void trace_dump(void) {
+    trace_ring_hexdump("trace", trace_serialize);
+}
@@ -0,0 +1,64 @@
+#include "trace_ring.h"
+
+#include <stdio.h>
+
+#define TRACE_RING_HEX_LINE 32          //bytes per line of the console dump
+
+typedef struct {
+    uint8_t line[TRACE_RING_HEX_LINE];
+    size_t fill;
+} hex_writer;
+
+void trace_ring_init(trace_ring *ring, void *entries, uint32_t capacity, uint32_t entry_size) {
+    ring->head = 0;
+    ring->capacity = capacity;
+    ring->entry_size = entry_size;
+    ring->entries = entries;
+}
+
+void trace_ring_clear(trace_ring *rings, int count) {
+    for (int i = 0; i < count; i++) {
+        __atomic_store_n(&rings[i].head, 0, __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void trace_ring_serialize(const trace_ring *ring, trace_ring_writer write, void *ctx) {
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    uint32_t count = (head < ring->capacity) ? head : ring->capacity;
+    write(&count, sizeof(count), ctx);
+    for (uint32_t i = head - count; i != head; i++) {
+        write(&ring->entries[(i & (ring->capacity - 1)) * ring->entry_size], ring->entry_size, ctx);
+    }
+}
+
+static void hex_flush(hex_writer *w) {
+    for (size_t i = 0; i < w->fill; i++) {
+        printf("%02x", w->line[i]);
+    }
+    printf("\n");
+    w->fill = 0;
+}
+
+static void hex_write(const void *data, size_t len, void *ctx) {
+    hex_writer *w = ctx;
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        w->line[w->fill++] = bytes[i];
+        if (w->fill == TRACE_RING_HEX_LINE) {
+            hex_flush(w);
+        }
+    }
+}
+
+void trace_ring_hexdump(const char *name, void (*serialize)(trace_ring_writer write, void *ctx)) {
+    //between markers like the benchmark results, the host tools cut it out of a terminal log
+    hex_writer w = {.fill = 0};
+    printf("----- %s -----\n", name);
+    serialize(hex_write, &w);
+    if (w.fill > 0) {
+        hex_flush(&w);
+    }
+    printf("----- end -----\n");
+    fflush(stdout);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Event tracer with one lock-free ring per core
+//
+// Every event is 16 bytes: time (low 32 bits of esp_timer in us), type, core, id, arg and the running task.
+// The rings overwrite their oldest events, so the last TRACE_RING_EVENTS of every core are always at hand.
+// A dump is the binary below, on the console as hex lines between "----- trace -----" and "----- end -----":
+//
+//      trace_header | task_count * trace_task | per core: count (u32) | count * trace_event, oldest first
+//
+// All integers are little endian. host/trace2json turns a console log or the binary into a Chrome/Perfetto trace.
+
+#define TRACE_MAGIC "CPTR"
+#define TRACE_VERSION 1
+#define TRACE_RING_EVENTS 1024          //per core, power of two
+#define TRACE_MAX_CORES 2
+#define TRACE_MAX_TASKS 32              //tasks with a name in the dump
+#define TRACE_TASK_NAME_LEN 16          //configMAX_TASK_NAME_LEN
+
+typedef enum {
+    TRACE_TASK_SWITCH = 1,              // task is the task switched in
+    TRACE_CALC_STATE = 2,               // id: method, arg: new calc_state
+    TRACE_LCD_FLUSH_BEGIN = 3,
+    TRACE_LCD_FLUSH_END = 4,
+    TRACE_FS_BEGIN = 5,                 // littlefs held by the task
+    TRACE_FS_END = 6,
+    TRACE_BUTTON = 7,                   // arg: button event bits
+    TRACE_MARK = 8,                     // id and arg free for ad hoc markers
+} trace_type;
+
+typedef struct __attribute__((packed)) {
+    uint32_t time_us;
+    uint8_t type;
+    uint8_t core;
+    uint16_t id;
+    uint32_t arg;
+    uint32_t task;
+} trace_event;
+
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint8_t version;
+    uint8_t cores;
+    uint16_t event_size;
+    uint32_t ring_events;
+    uint32_t task_count;
+} trace_header;
+
+typedef struct __attribute__((packed)) {
+    uint32_t task;
+    char name[TRACE_TASK_NAME_LEN];
+} trace_task;
+
+typedef void (*trace_writer)(const void *data, size_t len, void *ctx);
+
+void trace_init(void);
+void trace_start(void);
+void trace_stop(void);
+bool trace_enabled(void);
+
+// Safe from any task and from ISRs, never blocks
+void trace_record(trace_type type, uint16_t id, uint32_t arg);
+
+// Writes the dump, tracing is paused meanwhile
+void trace_serialize(trace_writer write, void *ctx);
+// Prints the dump on the console
+void trace_dump(void);
+
+// Called by the scheduler through traceTASK_SWITCHED_IN, see trace_freertos.h
+void trace_task_switched_in(void);
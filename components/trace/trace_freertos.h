@@ -0,0 +1,7 @@
+#pragma once
+// Force-included into every C file of the build (CMakeLists.txt of the project), so the FreeRTOS kernel picks up
+// the hook instead of its empty default. Nothing else may be declared here.
+#ifndef __ASSEMBLER__
+void trace_task_switched_in(void);
+#define traceTASK_SWITCHED_IN() trace_task_switched_in()
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Lock-free ring of fixed size entries, one per core, shared by the event tracer and dlog
+//
+// Writers claim the next slot and overwrite the oldest entry. Readers stop the writers before they serialize.
+// A ring is written as count (u32) | count * entry, oldest first, the hex dump puts a serialized binary
+// on the console between "----- <name> -----" and "----- end -----".
+
+typedef struct {
+    uint32_t head;                      // entries ever written, the slot is head % capacity
+    uint32_t capacity;                  // power of two
+    uint32_t entry_size;
+    uint8_t *entries;
+} trace_ring;
+
+typedef void (*trace_ring_writer)(const void *data, size_t len, void *ctx);
+
+void trace_ring_init(trace_ring *ring, void *entries, uint32_t capacity, uint32_t entry_size);
+// Drops all entries of count rings
+void trace_ring_clear(trace_ring *rings, int count);
+
+// Slot of the next entry, safe from any task and from ISRs, never blocks. Inlined into the IRAM callers.
+static inline __attribute__((always_inline)) void *trace_ring_claim(trace_ring *ring) {
+    uint32_t slot = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED) & (ring->capacity - 1);
+    return &ring->entries[slot * ring->entry_size];
+}
+
+void trace_ring_serialize(const trace_ring *ring, trace_ring_writer write, void *ctx);
+// Prints what serialize writes as hex lines between the markers of name
+void trace_ring_hexdump(const char *name, void (*serialize)(trace_ring_writer write, void *ctx));
@@ -0,0 +1,577 @@
+/********************************************************************************************* */
+//    Benchmark of all calculation engines over a matrix of digit targets and thread counts
+//    Every configuration runs warm-up rounds first, then the measured repetitions.
+//    The CSV has one line per measured run and starts with the columns of documentation/tests/runtimes_*.csv.
+//
+//    usage: bench [-m methods] [-d digits] [-t threads] [-w warmup] [-r reps] [-j out.json] [-c base.json] [-T tol]
+//           bench compare <base.json> <current.json> [tolerance in %]
+//           methods, digits and threads are comma separated lists, methods are A, B, C (the firmware methods),
+//           bsplit-<symbol> (binary splitting, e.g. bsplit-pi), pidigit (digits is the position), leibniz-par
+//           (parallel Leibniz) and montecarlo (Monte Carlo, up to 4 digits), default all
+//           -j writes the results as JSON, -c compares the medians with a saved JSON (table on stderr), exit code 2 on regressions
+/********************************************************************************************* */
+#define _GNU_SOURCE
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bsplit.h"
+#include "calcpi.h"
+#include "leibniz.h"
+#include "montecarlo.h"
+#include "pidigit.h"
+
+#define MAX_LIST 32
+#define MAX_ENGINES 16
+#define DEFAULT_DIGITS "3,5,7,14,1000,10000"   // 3 is for montecarlo, which reaches at most 4 digits
+#define DEFAULT_TOLERANCE 10.0          // percent the median may grow before it counts as a regression
+#define COMPARE_FLOOR_MS 0.01           // smaller changes are below the resolution of a single run
+#define ITER_BATCH 65536
+#define MC_BATCH_BLOCKS 4096
+#define MC_SEED 0x5EED314159265ULL
+#define MC_SIGMA 1.642                  // standard deviation of a single sample of 4 * hit, sqrt(pi * (4 - pi))
+
+typedef struct engine {
+    char name[24];
+    uint32_t max_digits;
+    bool threaded;
+    bool (*run)(const struct engine *e, uint32_t digits, uint32_t threads);
+    const calc_method *method;
+    const bsplit_series *series;
+} engine;
+
+typedef struct {
+    char method[24];
+    uint32_t digits;
+    uint32_t threads;
+    uint32_t count;
+    double *ms;                         // measured runs in order
+    double median, p10, p90, p99, min, max;
+    double digits_per_s;
+} result;
+
+typedef struct {
+    pthread_t thread;
+    uint32_t worker;
+    uint32_t workers;
+    const bsplit_series *series;
+    uint32_t terms;
+    bsplit_pqt sum;
+    const pidigit_job *job;
+    double partial;
+    uint64_t count;                     // Leibniz terms or Monte Carlo blocks of all workers
+    leibniz_acc acc;
+    uint64_t hits;
+    bool ok;
+} worker;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+static void pin(uint32_t index)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % sysconf(_SC_NPROCESSORS_ONLN), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static bool run_iterative(const engine *e, uint32_t digits, uint32_t threads)
+{
+    //same kernels and precision check as the calculation tasks of the firmware
+    struct pi_bounds bounds = pi_bounds_for_digits(digits);
+
+    void *state = malloc(e->method->state_size);
+    if (state == NULL) {
+        return false;
+    }
+    e->method->init(state);
+    e->method->reset(state);
+    bool reached = false;
+    while (!reached) {
+        e->method->step_batch(state, ITER_BATCH, &bounds);
+        reached = check_for_precision(e->method->snapshot(state), bounds);
+        if (!reached && e->method->exhausted != NULL && e->method->exhausted(state)) {
+            break;
+        }
+    }
+    free(state);
+    return reached;
+}
+
+static void *bsplit_thread(void *param)
+{
+    worker *w = param;
+    pin(w->worker);
+    w->ok = bsplit_part(w->series, w->terms, w->worker, w->workers, &w->sum);
+    return NULL;
+}
+
+static bool run_bsplit(const engine *e, uint32_t digits, uint32_t threads)
+{
+    //same split and merge order as the job server
+    worker w[threads];
+    uint32_t terms = bsplit_terms(e->series, digits);
+    for (uint32_t i = 0; i < threads; i++) {
+        w[i].worker = i;
+        w[i].workers = threads;
+        w[i].series = e->series;
+        w[i].terms = terms;
+        bsplit_pqt_init(&w[i].sum);
+        pthread_create(&w[i].thread, NULL, bsplit_thread, &w[i]);
+    }
+    bool ok = true;
+    for (uint32_t i = 0; i < threads; i++) {
+        pthread_join(w[i].thread, NULL);
+        ok = ok && w[i].ok;
+    }
+    for (uint32_t i = 1; ok && i < threads; i++) {
+        ok = bsplit_merge(e->series, &w[0].sum, &w[i].sum, i + 1 < threads);
+    }
+    bigint_t fixed;
+    bigint_init(&fixed);
+    ok = ok && bsplit_result(e->series, &w[0].sum, digits, &fixed);
+    bigint_free(&fixed);
+    for (uint32_t i = 0; i < threads; i++) {
+        bsplit_pqt_free(&w[i].sum);
+    }
+    return ok;
+}
+
+static void *pidigit_thread(void *param)
+{
+    worker *w = param;
+    pin(w->worker);
+    w->partial = pidigit_partial(w->job, w->worker, w->workers);
+    return NULL;
+}
+
+static bool run_pidigit(const engine *e, uint32_t digits, uint32_t threads)
+{
+    //digits is the position, the time includes the prime sieve like the firmware task
+    pidigit_job job;
+    if (!pidigit_job_init(&job, digits)) {
+        return false;
+    }
+    worker w[threads];
+    for (uint32_t i = 0; i < threads; i++) {
+        w[i].worker = i;
+        w[i].workers = threads;
+        w[i].job = &job;
+        pthread_create(&w[i].thread, NULL, pidigit_thread, &w[i]);
+    }
+    double sum = 0;
+    for (uint32_t i = 0; i < threads; i++) {
+        pthread_join(w[i].thread, NULL);
+        sum += w[i].partial;
+    }
+    char out[PIDIGIT_DIGITS + 1];
+    bool ok = pidigit_digits(&job, sum, out);
+    pidigit_job_free(&job);
+    return ok;
+}
+
+static uint64_t leibniz_terms_for(struct pi_bounds bounds)
+{
+    //the partial sum of n terms misses pi by about 1/n, above for odd n and below for even n,
+    //so take the side of pi with the wider margin to the bounds and stay a bit inside of it
+    double above = bounds.upper - M_PI, below = M_PI - bounds.lower;
+    uint64_t terms = (uint64_t)(1.01 / ((above > below) ? above : below)) + 1;
+    if ((terms % 2 == 1) != (above > below)) {
+        terms++;
+    }
+    return terms;
+}
+
+static void *leibniz_thread(void *param)
+{
+    worker *w = param;
+    pin(w->worker);
+    w->acc = leibniz_partial(w->count, w->worker, w->workers, LEIBNIZ_BLOCKED);
+    return NULL;
+}
+
+static bool run_leibniz(const engine *e, uint32_t digits, uint32_t threads)
+{
+    //fixed number of terms for the digits, reduced in worker order like the firmware scaling test
+    struct pi_bounds bounds = pi_bounds_for_digits(digits);
+    uint64_t terms = leibniz_terms_for(bounds);
+    worker w[threads];
+    leibniz_acc partials[threads];
+    for (uint32_t i = 0; i < threads; i++) {
+        w[i].worker = i;
+        w[i].workers = threads;
+        w[i].count = terms;
+        pthread_create(&w[i].thread, NULL, leibniz_thread, &w[i]);
+    }
+    for (uint32_t i = 0; i < threads; i++) {
+        pthread_join(w[i].thread, NULL);
+        partials[i] = w[i].acc;
+    }
+    return check_for_precision(leibniz_reduce(partials, threads), bounds);
+}
+
+static void *montecarlo_thread(void *param)
+{
+    worker *w = param;
+    pin(w->worker);
+    mc_sampler sampler;
+    mc_sampler_init(&sampler, MC_SEED, w->worker);
+    uint64_t blocks = w->count / w->workers + (w->worker < w->count % w->workers);
+    while (blocks > 0) {
+        uint32_t batch = (blocks < MC_BATCH_BLOCKS) ? blocks : MC_BATCH_BLOCKS;
+        mc_sample(&sampler, batch);
+        blocks -= batch;
+    }
+    w->hits = sampler.hits;
+    return NULL;
+}
+
+static bool run_montecarlo(const engine *e, uint32_t digits, uint32_t threads)
+{
+    //samples until the standard error is half a step of the last digit, one sampler stream per thread like the cores
+    //of the firmware. Whether a run lands inside the bounds is chance, so only the time counts
+    double step = pow(10.0, -(double)digits);
+    uint64_t samples = (uint64_t)ceil(pow(2 * MC_SIGMA / step, 2));
+    uint64_t blocks = (samples + MC_POINTS_PER_BLOCK - 1) / MC_POINTS_PER_BLOCK;
+    worker w[threads];
+    uint64_t hits = 0;
+    for (uint32_t i = 0; i < threads; i++) {
+        w[i].worker = i;
+        w[i].workers = threads;
+        w[i].count = blocks;
+        pthread_create(&w[i].thread, NULL, montecarlo_thread, &w[i]);
+    }
+    for (uint32_t i = 0; i < threads; i++) {
+        pthread_join(w[i].thread, NULL);
+        hits += w[i].hits;
+    }
+    double estimate = mc_estimate(hits, blocks * MC_POINTS_PER_BLOCK);
+    return fabs(estimate - M_PI) < 1.0;
+}
+
+static uint32_t list_engines(engine *engines)
+{
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < calc_method_count; i++) {
+        //Leibniz needs 10^digits iterations, the series stop at 14 digits because 3.141592653589793 reads as the
+        //double of pi itself and the strict bound check can never pass
+        engine e = {.max_digits = (calc_methods[i]->exhausted == NULL) ? 8 : 14, .run = run_iterative, .method = calc_methods[i]};
+        snprintf(e.name, sizeof(e.name), "%c", calc_method_letter(calc_methods[i]->id));
+        engines[n++] = e;
+    }
+    for (uint32_t i = 0; i < bsplit_series_count && n < MAX_ENGINES - 3; i++) {
+        engine e = {.max_digits = UINT32_MAX, .threaded = true, .run = run_bsplit, .series = bsplit_series_list[i]};
+        snprintf(e.name, sizeof(e.name), "bsplit-%s", bsplit_series_list[i]->symbol);
+        engines[n++] = e;
+    }
+    engines[n++] = (engine){.name = "pidigit", .max_digits = UINT32_MAX, .threaded = true, .run = run_pidigit};
+    //10^digits terms, the same limit as the sequential Leibniz
+    engines[n++] = (engine){.name = "leibniz-par", .max_digits = 8, .threaded = true, .run = run_leibniz};
+    //the error shrinks with 1/sqrt(samples), 5 digits would already take 10^11 samples
+    engines[n++] = (engine){.name = "montecarlo", .max_digits = 4, .threaded = true, .run = run_montecarlo};
+    return n;
+}
+
+static uint32_t parse_list(const char *text, uint32_t *out)
+{
+    uint32_t n = 0;
+    char *end;
+    while (*text != '\0' && n < MAX_LIST) {
+        out[n++] = strtoul(text, &end, 0);
+        text = (*end == ',') ? end + 1 : end;
+        if (end == text && *end != '\0') {
+            break;
+        }
+    }
+    return n;
+}
+
+static bool selected(const char *list, const char *name)
+{
+    if (list == NULL) {
+        return true;
+    }
+    size_t len = strlen(name);
+    for (const char *p = list; (p = strstr(p, name)) != NULL; p += len) {
+        if ((p == list || p[-1] == ',') && (p[len] == ',' || p[len] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, uint32_t n, double p)
+{
+    //linear interpolation between the closest ranks
+    double rank = p / 100.0 * (n - 1);
+    uint32_t i = (uint32_t)rank;
+    return (i + 1 < n) ? sorted[i] + (rank - i) * (sorted[i + 1] - sorted[i]) : sorted[n - 1];
+}
+
+static void summarise(result *r)
+{
+    double sorted[r->count];
+    memcpy(sorted, r->ms, sizeof(sorted));
+    qsort(sorted, r->count, sizeof(double), compare_double);
+    r->min = sorted[0];
+    r->max = sorted[r->count - 1];
+    r->median = percentile(sorted, r->count, 50);
+    r->p10 = percentile(sorted, r->count, 10);
+    r->p90 = percentile(sorted, r->count, 90);
+    r->p99 = percentile(sorted, r->count, 99);
+    r->digits_per_s = r->digits / (r->median / 1000.0);
+}
+
+static void print_csv(const result *results, uint32_t count)
+{
+    printf("Run,Zeit in ms,Methode,Stellen,Threads,Median in ms,P10 in ms,P90 in ms,P99 in ms,Stellen pro s\n");
+    for (uint32_t i = 0; i < count; i++) {
+        const result *r = &results[i];
+        for (uint32_t run = 0; run < r->count; run++) {
+            printf("%u,%.3f,%s,%u,%u,%.3f,%.3f,%.3f,%.3f,%.0f\n", run + 1, r->ms[run], r->method, r->digits, r->threads,
+                   r->median, r->p10, r->p90, r->p99, r->digits_per_s);
+        }
+    }
+}
+
+static bool write_json(const char *path, const result *results, uint32_t count, uint32_t warmup)
+{
+    //one result per line, load_json relies on it
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    fprintf(f, "{\n  \"cpus\": %ld,\n  \"warmup\": %u,\n  \"results\": [\n", sysconf(_SC_NPROCESSORS_ONLN), warmup);
+    for (uint32_t i = 0; i < count; i++) {
+        const result *r = &results[i];
+        fprintf(f, "    {\"method\": \"%s\", \"digits\": %u, \"threads\": %u, \"median_ms\": %.4f, \"p10_ms\": %.4f, "
+                   "\"p90_ms\": %.4f, \"p99_ms\": %.4f, \"min_ms\": %.4f, \"max_ms\": %.4f, \"digits_per_s\": %.1f, \"runs_ms\": [",
+                r->method, r->digits, r->threads, r->median, r->p10, r->p90, r->p99, r->min, r->max, r->digits_per_s);
+        for (uint32_t run = 0; run < r->count; run++) {
+            fprintf(f, "%s%.4f", run ? ", " : "", r->ms[run]);
+        }
+        fprintf(f, "]}%s\n", (i + 1 < count) ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+static bool json_number(const char *line, const char *key, double *out)
+{
+    const char *p = strstr(line, key);
+    if (p == NULL || (p = strchr(p + strlen(key), ':')) == NULL) {
+        return false;
+    }
+    *out = strtod(p + 1, NULL);
+    return true;
+}
+
+static uint32_t load_json(const char *path, result *results, uint32_t max)
+{
+    //reads the medians back from a file of write_json
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return 0;
+    }
+    char line[4096];
+    uint32_t n = 0;
+    while (n < max && fgets(line, sizeof(line), f) != NULL) {
+        const char *method = strstr(line, "\"method\": \"");
+        double digits, threads, median;
+        if (method == NULL || !json_number(line, "\"digits\"", &digits) || !json_number(line, "\"threads\"", &threads)
+            || !json_number(line, "\"median_ms\"", &median)) {
+            continue;
+        }
+        result *r = &results[n++];
+        memset(r, 0, sizeof(*r));
+        sscanf(method + 11, "%23[^\"]", r->method);
+        r->digits = digits;
+        r->threads = threads;
+        r->median = median;
+        json_number(line, "\"p90_ms\"", &r->p90);
+    }
+    fclose(f);
+    return n;
+}
+
+static int compare(FILE *out, const result *base, uint32_t base_count, const result *current, uint32_t count, double tolerance)
+{
+    //medians only, the percentiles of a few repetitions are too noisy to judge a change
+    int regressions = 0;
+    fprintf(out, "Methode,Stellen,Threads,Basis in ms,Aktuell in ms,Aenderung in %%,Status\n");
+    for (uint32_t i = 0; i < count; i++) {
+        const result *c = &current[i];
+        const result *b = NULL;
+        for (uint32_t j = 0; j < base_count && b == NULL; j++) {
+            if (strcmp(base[j].method, c->method) == 0 && base[j].digits == c->digits && base[j].threads == c->threads) {
+                b = &base[j];
+            }
+        }
+        if (b == NULL || b->median <= 0) {
+            fprintf(out, "%s,%u,%u,,%.3f,,new\n", c->method, c->digits, c->threads, c->median);
+            continue;
+        }
+        double change = (c->median / b->median - 1.0) * 100.0;
+        const char *status = "ok";
+        if (fabs(c->median - b->median) < COMPARE_FLOOR_MS) {
+            status = "ok";
+        } else if (change > tolerance) {
+            status = "REGRESSION";
+            regressions++;
+        } else if (change < -tolerance) {
+            status = "faster";
+        }
+        fprintf(out, "%s,%u,%u,%.3f,%.3f,%+.1f,%s\n", c->method, c->digits, c->threads, b->median, c->median, change, status);
+    }
+    fprintf(stderr, "%d regressions (tolerance %.1f %%)\n", regressions, tolerance);
+    return regressions ? 2 : 0;
+}
+
+static int usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-m methods] [-d digits] [-t threads] [-w warmup] [-r reps] [-j out.json] [-c base.json] [-T tol]\n"
+                    "       %s compare <base.json> <current.json> [tolerance in %%]\n", name, name);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *methods = NULL, *json_path = NULL, *baseline_path = NULL;
+    uint32_t digits[MAX_LIST], threads[MAX_LIST] = {1, (uint32_t)sysconf(_SC_NPROCESSORS_ONLN)};
+    uint32_t digit_count = parse_list(DEFAULT_DIGITS, digits), thread_count = (threads[1] > 1) ? 2 : 1;
+    uint32_t warmup = 1, reps = 5;
+    double tolerance = DEFAULT_TOLERANCE;
+    int opt;
+
+    if (argc >= 4 && strcmp(argv[1], "compare") == 0) {
+        static result base[MAX_ENGINES * MAX_LIST * MAX_LIST], current[MAX_ENGINES * MAX_LIST * MAX_LIST];
+        uint32_t base_count = load_json(argv[2], base, sizeof(base) / sizeof(base[0]));
+        uint32_t count = load_json(argv[3], current, sizeof(current) / sizeof(current[0]));
+        return compare(stdout, base, base_count, current, count, (argc >= 5) ? atof(argv[4]) : tolerance);
+    }
+
+    while ((opt = getopt(argc, argv, "m:d:t:w:r:j:c:T:")) != -1) {
+        switch (opt) {
+        case 'm':
+            methods = optarg;
+            break;
+        case 'd':
+            digit_count = parse_list(optarg, digits);
+            break;
+        case 't':
+            thread_count = parse_list(optarg, threads);
+            break;
+        case 'w':
+            warmup = atoi(optarg);
+            break;
+        case 'r':
+            reps = atoi(optarg);
+            break;
+        case 'j':
+            json_path = optarg;
+            break;
+        case 'c':
+            baseline_path = optarg;
+            break;
+        case 'T':
+            tolerance = atof(optarg);
+            break;
+        default:
+            return usage(argv[0]);
+        }
+    }
+    if (reps < 1 || digit_count == 0 || thread_count == 0) {
+        return usage(argv[0]);
+    }
+
+    engine engines[MAX_ENGINES];
+    uint32_t engine_count = list_engines(engines);
+    result *results = calloc(engine_count * digit_count * thread_count, sizeof(result));
+    uint32_t count = 0;
+    if (results == NULL) {
+        return 1;
+    }
+
+    for (uint32_t e = 0; e < engine_count; e++) {
+        if (!selected(methods, engines[e].name)) {
+            continue;
+        }
+        //an engine without a single reachable target would otherwise be missing from the results without a word
+        uint32_t reachable = 0;
+        for (uint32_t d = 0; d < digit_count; d++) {
+            reachable += (digits[d] > 0 && digits[d] <= engines[e].max_digits);
+        }
+        if (reachable == 0) {
+            fprintf(stderr, "%s skipped, max %u digits\n", engines[e].name, engines[e].max_digits);
+            continue;
+        }
+        for (uint32_t d = 0; d < digit_count; d++) {
+            for (uint32_t t = 0; t < thread_count; t++) {
+                if (digits[d] == 0 || digits[d] > engines[e].max_digits || threads[t] < 1 || (!engines[e].threaded && threads[t] > 1)) {
+                    continue;
+                }
+                result *r = &results[count];
+                snprintf(r->method, sizeof(r->method), "%s", engines[e].name);
+                r->digits = digits[d];
+                r->threads = threads[t];
+                r->ms = malloc(reps * sizeof(double));
+                bool ok = r->ms != NULL;
+                for (uint32_t i = 0; ok && i < warmup; i++) {
+                    ok = engines[e].run(&engines[e], r->digits, r->threads);
+                }
+                for (uint32_t i = 0; ok && i < reps; i++) {
+                    double start = now_ms();
+                    ok = engines[e].run(&engines[e], r->digits, r->threads);
+                    r->ms[r->count++] = now_ms() - start;
+                }
+                if (!ok) {
+                    fprintf(stderr, "%s failed for %u digits with %u threads\n", r->method, r->digits, r->threads);
+                    free(r->ms);
+                    memset(r, 0, sizeof(*r));
+                    continue;
+                }
+                summarise(r);
+                fprintf(stderr, "%-14s %6u digits %3u threads: median %10.3f ms, p90 %10.3f ms\n", r->method, r->digits,
+                        r->threads, r->median, r->p90);
+                count++;
+            }
+        }
+    }
+
+    print_csv(results, count);
+    int status = 0;
+    if (json_path != NULL && !write_json(json_path, results, count, warmup)) {
+        status = 1;
+    }
+    if (baseline_path != NULL) {
+        static result base[MAX_ENGINES * MAX_LIST * MAX_LIST];
+        uint32_t base_count = load_json(baseline_path, base, sizeof(base) / sizeof(base[0]));
+        //the CSV of the runs keeps stdout, the comparison goes next to the progress lines
+        fprintf(stderr, "\n");
+        status = compare(stderr, base, base_count, results, count, tolerance);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        free(results[i].ms);
+    }
+    free(results);
+    return status;
+}
@@ -0,0 +1,543 @@
+/********************************************************************************************* */
+//    Distributed binary splitting over TCP
+//    The coordinator cuts [0,N) into chunks and hands them to worker processes, which return the
+//    serialised (P,Q,B,T) of their range (P,Q,R of binary_split() in documentation/chudnovsky.py).
+//    Results are merged in a fixed binary tree over the chunk indices. All values are exact integers,
+//    so the digits are identical to a single process run whatever the worker count or arrival order.
+//
+//    usage: bsplit_dist worker [-p port] [-a address]
+//           bsplit_dist coordinator [-c chunks] [-o out.cpdg] [-v] <symbol> <digits> <host:port>...
+//           bsplit_dist local [-n workers] [-c chunks] [-o out.cpdg] [-v] <symbol> <digits>
+/********************************************************************************************* */
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bsplit.h"
+#include "digitstore.h"
+
+#define DIST_REQUEST 'R'
+#define DIST_REQUEST_SIZE 10        // type, series, a u32, b u32
+#define DIST_REPLY_HEADER 16        // status u32, compute us u32, payload length u64
+
+typedef struct {
+    int fd;
+    const char *name;
+    int32_t chunk;                  // chunk in flight, -1 if idle
+    uint32_t chunks_done;
+    uint64_t bytes;
+    double compute_s;
+} dist_worker;
+
+typedef struct {
+    uint32_t levels;
+    uint32_t *count;                // nodes per level
+    bsplit_pqt **nodes;
+    bool **present;
+} merge_tree;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool write_all(int fd, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void *buf, size_t len)
+{
+    uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static const bsplit_series *find_series(const char *symbol, uint8_t *index)
+{
+    for (uint32_t i = 0; i < bsplit_series_count; i++) {
+        if (strcmp(bsplit_series_list[i]->symbol, symbol) == 0) {
+            *index = i;
+            return bsplit_series_list[i];
+        }
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Worker                                                                                                            */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static void serve(int fd)
+{
+    //one request after the other until the coordinator closes the connection
+    uint8_t req[DIST_REQUEST_SIZE];
+    while (read_all(fd, req, sizeof(req)) && req[0] == DIST_REQUEST && req[1] < bsplit_series_count) {
+        const bsplit_series *series = bsplit_series_list[req[1]];
+        uint32_t a = get_u32(&req[2]), b = get_u32(&req[6]);
+        bsplit_pqt sum;
+        bsplit_pqt_init(&sum);
+
+        double start = now_s();
+        //P is always sent, the coordinator decides whether the merge needs it
+        bool ok = (b > a) && bsplit_range(series, a, b, &sum, true);
+        uint32_t compute_us = (uint32_t)((now_s() - start) * 1e6);
+
+        size_t size = ok ? bsplit_pqt_serial_size(&sum) : 0;
+        uint8_t *payload = ok ? malloc(size) : NULL;
+        uint8_t header[DIST_REPLY_HEADER];
+        ok = ok && payload != NULL;
+        if (ok) {
+            bsplit_pqt_serialize(&sum, payload);
+        }
+        put_u32(&header[0], ok ? 0 : 1);
+        put_u32(&header[4], compute_us);
+        put_u32(&header[8], ok ? (uint32_t)size : 0);
+        put_u32(&header[12], ok ? (uint32_t)((uint64_t)size >> 32) : 0);
+        bool sent = write_all(fd, header, sizeof(header)) && (!ok || write_all(fd, payload, size));
+        free(payload);
+        bsplit_pqt_free(&sum);
+        if (!sent) {
+            break;
+        }
+    }
+    close(fd);
+}
+
+static int listen_on(const char *address, uint16_t port, uint16_t *bound)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port)};
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0
+        || getsockname(fd, (struct sockaddr *)&addr, &len) != 0) {
+        close(fd);
+        return -1;
+    }
+    *bound = ntohs(addr.sin_port);
+    return fd;
+}
+
+static void worker_loop(int listen_fd)
+{
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        serve(fd);
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Coordinator                                                                                                       */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static int connect_to(const char *hostport)
+{
+    char host[256];
+    const char *colon = strrchr(hostport, ':');
+    if (colon == NULL || (size_t)(colon - hostport) >= sizeof(host)) {
+        return -1;
+    }
+    memcpy(host, hostport, colon - hostport);
+    host[colon - hostport] = '\0';
+
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM}, *res;
+    if (getaddrinfo(host, colon + 1, &hints, &res) != 0) {
+        return -1;
+    }
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai != NULL && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static bool tree_init(merge_tree *t, uint32_t leaves)
+{
+    t->levels = 1;
+    for (uint32_t n = leaves; n > 1; n = (n + 1) / 2) {
+        t->levels++;
+    }
+    t->count = calloc(t->levels, sizeof(uint32_t));
+    t->nodes = calloc(t->levels, sizeof(bsplit_pqt *));
+    t->present = calloc(t->levels, sizeof(bool *));
+    if (t->count == NULL || t->nodes == NULL || t->present == NULL) {
+        return false;
+    }
+    uint32_t n = leaves;
+    for (uint32_t l = 0; l < t->levels; l++, n = (n + 1) / 2) {
+        t->count[l] = n;
+        t->nodes[l] = calloc(n, sizeof(bsplit_pqt));
+        t->present[l] = calloc(n, sizeof(bool));
+        if (t->nodes[l] == NULL || t->present[l] == NULL) {
+            return false;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            bsplit_pqt_init(&t->nodes[l][i]);
+        }
+    }
+    return true;
+}
+
+static void tree_free(merge_tree *t)
+{
+    for (uint32_t l = 0; t->count != NULL && l < t->levels; l++) {
+        for (uint32_t i = 0; t->nodes[l] != NULL && i < t->count[l]; i++) {
+            bsplit_pqt_free(&t->nodes[l][i]);
+        }
+        free(t->nodes[l]);
+        free(t->present[l]);
+    }
+    free(t->count);
+    free(t->nodes);
+    free(t->present);
+}
+
+static bool tree_insert(const bsplit_series *series, merge_tree *t, uint32_t leaf)
+{
+    //node i of level l+1 is the merge of the nodes 2i and 2i+1 of level l, an odd last node moves up unchanged
+    uint32_t l = 0, i = leaf;
+    t->present[0][leaf] = true;
+    while (l + 1 < t->levels) {
+        uint32_t left = i & ~1u, right = left + 1;
+        bsplit_pqt *parent = &t->nodes[l + 1][i / 2];
+        if (right >= t->count[l]) {
+            bsplit_pqt tmp = *parent;
+            *parent = t->nodes[l][left];
+            t->nodes[l][left] = tmp;
+        } else if (t->present[l][left] && t->present[l][right]) {
+            //P is only needed if the merged range is not the rightmost one
+            bool need_p = i / 2 + 1 < t->count[l + 1];
+            if (!bsplit_merge(series, &t->nodes[l][left], &t->nodes[l][right], need_p)) {
+                return false;
+            }
+            bsplit_pqt tmp = *parent;
+            *parent = t->nodes[l][left];
+            t->nodes[l][left] = tmp;
+            bsplit_pqt_free(&t->nodes[l][left]);
+            bsplit_pqt_free(&t->nodes[l][right]);
+        } else {
+            return true;
+        }
+        t->present[l + 1][i / 2] = true;
+        l++;
+        i /= 2;
+    }
+    return true;
+}
+
+static bool send_chunk(dist_worker *w, uint8_t series, uint32_t terms, uint32_t chunk, uint32_t chunks)
+{
+    uint8_t req[DIST_REQUEST_SIZE] = {DIST_REQUEST, series};
+    put_u32(&req[2], (uint64_t)terms * chunk / chunks);
+    put_u32(&req[6], (uint64_t)terms * (chunk + 1) / chunks);
+    w->chunk = chunk;
+    return write_all(w->fd, req, sizeof(req));
+}
+
+static bool receive_chunk(dist_worker *w, bsplit_pqt *out)
+{
+    uint8_t header[DIST_REPLY_HEADER];
+    if (!read_all(w->fd, header, sizeof(header)) || get_u32(&header[0]) != 0) {
+        return false;
+    }
+    uint64_t size = get_u32(&header[8]) | ((uint64_t)get_u32(&header[12]) << 32);
+    uint8_t *payload = malloc(size);
+    bool ok = payload != NULL && read_all(w->fd, payload, size) && bsplit_pqt_deserialize(out, payload, size) == size;
+    free(payload);
+    w->compute_s += get_u32(&header[4]) * 1e-6;
+    w->bytes += sizeof(header) + size;
+    w->chunks_done++;
+    w->chunk = -1;
+    return ok;
+}
+
+static int coordinate(const char *symbol, uint32_t digits, uint32_t chunks, const char *out, bool verify,
+                      char **addresses, int workers)
+{
+    uint8_t series_index;
+    const bsplit_series *series = find_series(symbol, &series_index);
+    if (series == NULL) {
+        fprintf(stderr, "unknown symbol %s\n", symbol);
+        return 1;
+    }
+    uint32_t terms = bsplit_terms(series, digits);
+    if (chunks == 0) {
+        chunks = 4 * workers;
+    }
+    if (chunks > terms) {
+        chunks = terms;
+    }
+
+    dist_worker *w = calloc(workers, sizeof(dist_worker));
+    struct pollfd *pfd = calloc(workers, sizeof(struct pollfd));
+    merge_tree tree = {0};
+    bool ok = w != NULL && pfd != NULL && tree_init(&tree, chunks);
+    for (int i = 0; ok && i < workers; i++) {
+        w[i].name = addresses[i];
+        w[i].chunk = -1;
+        w[i].fd = connect_to(addresses[i]);
+        if (w[i].fd < 0) {
+            fprintf(stderr, "cannot connect to %s\n", addresses[i]);
+            ok = false;
+        }
+    }
+
+    //every worker has one chunk in flight, the next one is sent as soon as its result is in
+    double start = now_s();
+    uint32_t next = 0, done = 0;
+    for (int i = 0; ok && i < workers && next < chunks; i++) {
+        ok = send_chunk(&w[i], series_index, terms, next++, chunks);
+    }
+    while (ok && done < chunks) {
+        for (int i = 0; i < workers; i++) {
+            pfd[i].fd = (w[i].chunk >= 0) ? w[i].fd : -1;
+            pfd[i].events = POLLIN;
+        }
+        if (poll(pfd, workers, -1) <= 0) {
+            ok = false;
+            break;
+        }
+        for (int i = 0; ok && i < workers; i++) {
+            if (!(pfd[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            uint32_t chunk = w[i].chunk;
+            ok = receive_chunk(&w[i], &tree.nodes[0][chunk]);
+            if (!ok) {
+                fprintf(stderr, "worker %s failed on chunk %u\n", w[i].name, chunk);
+                break;
+            }
+            if (next < chunks) {
+                ok = send_chunk(&w[i], series_index, terms, next++, chunks);
+            }
+            ok = ok && tree_insert(series, &tree, chunk);
+            done++;
+        }
+    }
+    double sum_s = now_s() - start;
+
+    bigint_t fixed;
+    bigint_init(&fixed);
+    ok = ok && bsplit_result(series, &tree.nodes[tree.levels - 1][0], digits, &fixed);
+    double total_s = now_s() - start;
+
+    if (ok) {
+        printf("%s: %u digits, %u terms in %u chunks on %d workers, sum %.3f s, total %.3f s\n", series->name, digits,
+               terms, chunks, workers, sum_s, total_s);
+        for (int i = 0; i < workers; i++) {
+            printf("  %-24s %5u chunks, %10.3f s compute, %12llu bytes\n", w[i].name, w[i].chunks_done, w[i].compute_s,
+                   (unsigned long long)w[i].bytes);
+        }
+    }
+
+    if (ok && verify) {
+        bigint_t single;
+        bigint_init(&single);
+        double verify_start = now_s();
+        ok = bsplit_compute(series, digits, &single);
+        printf("single process: %.3f s, result %s\n", now_s() - verify_start,
+               (ok && bigint_cmp(&single, &fixed) == 0) ? "identical" : "DIFFERENT");
+        ok = ok && bigint_cmp(&single, &fixed) == 0;
+        bigint_free(&single);
+    }
+
+    if (ok && out != NULL) {
+        size_t buflen = digits + 32;
+        char *text = malloc(buflen);
+        size_t len = (text != NULL) ? bsplit_format(&fixed, digits, text, buflen) : 0;
+        char *point = (len > 0) ? strchr(text, '.') : NULL;
+        digitstore_writer dw;
+        ok = point != NULL && (size_t)(point - text) < DIGITSTORE_INTEGER_LEN;
+        if (ok) {
+            *point = '\0';
+            ok = digitstore_create(&dw, out, symbol, text);
+            ok = ok && digitstore_append(&dw, point + 1, digits);
+            ok = digitstore_finish(&dw) && ok;
+        }
+        free(text);
+        if (!ok) {
+            fprintf(stderr, "writing %s failed\n", out);
+        }
+    }
+
+    bigint_free(&fixed);
+    tree_free(&tree);
+    for (int i = 0; w != NULL && i < workers; i++) {
+        if (w[i].fd >= 0) {
+            close(w[i].fd);
+        }
+    }
+    free(w);
+    free(pfd);
+    return ok ? 0 : 1;
+}
+
+static int run_local(int workers, const char *symbol, uint32_t digits, uint32_t chunks, const char *out, bool verify)
+{
+    //forks workers on free localhost ports, the coordinator talks to them over TCP like to remote ones
+    char **addresses = calloc(workers, sizeof(char *));
+    pid_t *pids = calloc(workers, sizeof(pid_t));
+    if (addresses == NULL || pids == NULL) {
+        return 1;
+    }
+    for (int i = 0; i < workers; i++) {
+        uint16_t port;
+        int fd = listen_on("127.0.0.1", 0, &port);
+        if (fd < 0) {
+            perror("listen");
+            return 1;
+        }
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            worker_loop(fd);
+            _exit(0);
+        }
+        close(fd);
+        addresses[i] = malloc(32);
+        snprintf(addresses[i], 32, "127.0.0.1:%u", port);
+    }
+
+    int ret = coordinate(symbol, digits, chunks, out, verify, addresses, workers);
+
+    for (int i = 0; i < workers; i++) {
+        kill(pids[i], SIGTERM);
+        waitpid(pids[i], NULL, 0);
+        free(addresses[i]);
+    }
+    free(addresses);
+    free(pids);
+    return ret;
+}
+
+static int usage(const char *name)
+{
+    fprintf(stderr, "usage: %s worker [-p port] [-a address]\n"
+                    "       %s coordinator [-c chunks] [-o out.cpdg] [-v] <symbol> <digits> <host:port>...\n"
+                    "       %s local [-n workers] [-c chunks] [-o out.cpdg] [-v] <symbol> <digits>\n", name, name, name);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        return usage(argv[0]);
+    }
+    const char *mode = argv[1];
+    const char *address = "127.0.0.1", *out = NULL;
+    uint16_t port = 0;
+    uint32_t chunks = 0;
+    int workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    bool verify = false;
+    int opt;
+
+    signal(SIGPIPE, SIG_IGN);
+    optind = 2;
+    while ((opt = getopt(argc, argv, "p:a:c:o:n:v")) != -1) {
+        switch (opt) {
+        case 'p':
+            port = atoi(optarg);
+            break;
+        case 'a':
+            address = optarg;
+            break;
+        case 'c':
+            chunks = strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            out = optarg;
+            break;
+        case 'n':
+            workers = atoi(optarg);
+            break;
+        case 'v':
+            verify = true;
+            break;
+        default:
+            return usage(argv[0]);
+        }
+    }
+
+    if (strcmp(mode, "worker") == 0) {
+        uint16_t bound;
+        int fd = listen_on(address, port, &bound);
+        if (fd < 0) {
+            perror("listen");
+            return 1;
+        }
+        printf("worker listening on %s:%u\n", address, bound);
+        fflush(stdout);
+        worker_loop(fd);
+        return 0;
+    }
+    if (argc - optind < 2) {
+        return usage(argv[0]);
+    }
+    uint32_t digits = strtoul(argv[optind + 1], NULL, 0);
+    if (strcmp(mode, "coordinator") == 0 && argc - optind >= 3) {
+        return coordinate(argv[optind], digits, chunks, out, verify, &argv[optind + 2], argc - optind - 2);
+    }
+    if (strcmp(mode, "local") == 0 && workers > 0) {
+        return run_local(workers, argv[optind], digits, chunks, out, verify);
+    }
+    return usage(argv[0]);
+}
@@ -0,0 +1,267 @@
+/********************************************************************************************* */
+//    The firmware of src/ on Linux: app_main and its tasks (buttons, logic, display, calculations,
+//    Monte Carlo, job server) run unchanged on the FreeRTOS port of esp_shim/src/posix_port.c, for
+//    profiling with perf and the sanitizers. The eduboard2 drivers are replaced by this file:
+//    buttons come from stdin, the LCD driver draws into the in-memory panel of framebuffer.c which
+//    prices the SPI transfers of the ILI9488, the flash driver and littlefs run on the W25 model of
+//    w25_model.c, the UART has no host attached.
+//
+//    usage: calcpi_sim [-f fontdir] [-t seconds] [-u]
+//           -t ends the run after the given time, -u lets the host schedule the tasks on all CPUs
+//    stdin, one command per line:
+//           0..3      short press of SW0..SW3, several digits press them together (03 is SW0+SW3)
+//           0l..3l    long press, a trailing l makes all buttons of the line long
+//           wait ms   pause before the next command, for scripts
+//           frame f   writes the next finished frame to the file f, as PNG for a name ending in .png, else as PPM
+//           quit      ends the run with the task report
+/********************************************************************************************* */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#include "eduboard2.h"
+#include "eduboardLCD/src/framebuffer.h"
+#include <driver/gpio.h>
+#include <driver/uart.h>
+#include <driver/uart_vfs.h>
+#include "esp_timer.h"
+#include "memon.h"
+#include "memprof.h"
+#include "memlat.h"
+#include "posix_port.h"
+#include "w25_model.h"
+
+#ifndef CALCPI_SIM_FONT_DIR
+#define CALCPI_SIM_FONT_DIR "data/fonts"
+#endif
+
+#define TAG "calcpi_sim"
+
+#define SIM_BUTTONS 4
+#define SIM_MAX_TASKS 32
+#define SIM_LINE 160
+
+static button_state buttons[SIM_BUTTONS];
+static int64_t button_times[SIM_BUTTONS];
+static portMUX_TYPE buttonLock = portMUX_INITIALIZER_UNLOCKED;
+static const char *font_dir = CALCPI_SIM_FONT_DIR;
+
+FontxFile fx16M[2];
+FontxFile fx24M[2];
+FontxFile fx32M[2];
+
+void app_main(void);
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   eduboard2 drivers                                                                                                 */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+void gpspi_init(spi_device_handle_t* handle, int pinMOSI, int pinMISO, int pinSCK, int pinCS, uint32_t frequency, bool halfduplex)
+{
+    //the flash is the only SPI device, the LCD is the framebuffer panel
+    *handle = NULL;
+    w25.frequency = frequency;
+}
+
+bool gpspi_read_write_data(spi_device_handle_t* handle, uint8_t* txdata, uint8_t* rxdata, uint32_t len)
+{
+    w25_model_transfer(txdata, rxdata, len);
+    return true;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio) { return ESP_OK; }
+esp_err_t gpio_set_direction(gpio_num_t gpio, gpio_mode_t mode) { return ESP_OK; }
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level) { return ESP_OK; }
+int gpio_get_level(gpio_num_t gpio) { return 0; }
+
+// no host on the console UART, the job server polls an idle line
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer, int tx_buffer, int queue_size, QueueHandle_t *queue, int flags) { return ESP_OK; }
+void uart_vfs_dev_use_driver(uart_port_t port) {}
+int uart_write_bytes(uart_port_t port, const void *data, size_t len) { return len; }
+
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t len, TickType_t ticks)
+{
+    vTaskDelay(ticks);
+    return 0;
+}
+
+button_state button_get_state(uint8_t button_num, bool reset)
+{
+    taskENTER_CRITICAL(&buttonLock);
+    button_state state = buttons[button_num];
+    if (reset) {
+        buttons[button_num] = NOT_PRESSED;
+    }
+    taskEXIT_CRITICAL(&buttonLock);
+    return state;
+}
+
+int64_t button_get_time(uint8_t button_num)
+{
+    taskENTER_CRITICAL(&buttonLock);
+    int64_t time_us = button_times[button_num];
+    taskEXIT_CRITICAL(&buttonLock);
+    return time_us;
+}
+
+// memon and memprof read the ESP-IDF heap and task internals, on the host perf and the sanitizers take their place
+void initMemon(void) {}
+void memon_enable() {}
+void memon_setFrameOutput(uart_port_t uart, SemaphoreHandle_t writeLock) {}
+void initMemprof(void) {}
+void memprof_set_stack_budget(const char *prefix, uint32_t stack_size) {}
+void memprof_start(void) {}
+void memprof_report(void) { printf("memprof is not available on the host\n"); }
+
+static rotation_t screen_rotation(void)
+{
+    return SCREEN_ROTATION == 90 ? rot_90 : SCREEN_ROTATION == 180 ? rot_180 : SCREEN_ROTATION == 270 ? rot_270 : rot_0;
+}
+
+static void fonts_init(void)
+{
+    //the fonts of main.c from the data directory instead of /spiffs, like lcd_bench
+    static char path16[256], path24[256], path32[256];
+    snprintf(path16, sizeof(path16), "%s/ILMH16XB.FNT", font_dir);
+    snprintf(path24, sizeof(path24), "%s/ILMH24XB.FNT", font_dir);
+    snprintf(path32, sizeof(path32), "%s/ILMH32XB.FNT", font_dir);
+    InitFontx(fx16M, path16, "");
+    InitFontx(fx24M, path24, "");
+    InitFontx(fx32M, path32, "");
+}
+
+void eduboard2_init()
+{
+    //the drivers main.c uses, set up like eduboard_init_lcd and eduboard_init_flash do on the board
+    ESP_LOGI(TAG, "Init Eduboard2...");
+    fonts_init();
+    lcd_init();
+    lcdSetupVScreen(screen_rotation());
+    lcdBacklightOn();
+    lcdFillScreen(BLACK);
+    lcdUpdateVScreen();
+    w25_model_init();
+    eduboard_init_flash();
+    ESP_LOGI(TAG, "Init Eduboard2 done");
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Input and report                                                                                                  */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static void press(const char *line)
+{
+    //all buttons of the line at the same instant, like a combination pressed on the board
+    bool is_long = strchr(line, 'l') != NULL;
+    int64_t now = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&buttonLock);
+    for (const char *c = line; *c != '\0'; c++) {
+        if (*c >= '0' && *c < '0' + SIM_BUTTONS) {
+            buttons[*c - '0'] = is_long ? LONG_PRESSED : SHORT_PRESSED;
+            button_times[*c - '0'] = now;
+        }
+    }
+    taskEXIT_CRITICAL(&buttonLock);
+}
+
+static void print_report(void)
+{
+    static TaskStatus_t tasks[SIM_MAX_TASKS];
+    static char latency[1024];
+    framebuffer_stats lcd;
+    configRUN_TIME_COUNTER_TYPE total;
+    UBaseType_t count = uxTaskGetSystemState(tasks, SIM_MAX_TASKS, &total);
+
+    printf("\n----- tasks -----\n");
+    printf("task             core  prio     cpu[ms]  load[%%]\n");
+    for (UBaseType_t i = 0; i < count; i++) {
+        char core[12] = "-";
+        if (tasks[i].xCoreID != tskNO_AFFINITY) {
+            snprintf(core, sizeof(core), "%d", (int)tasks[i].xCoreID);
+        }
+        printf("%-16s %4s %5u %11.1f %8.1f\n", tasks[i].pcTaskName, core, tasks[i].uxBasePriority,
+               tasks[i].ulRunTimeCounter / 1000.0, total ? 100.0 * tasks[i].ulRunTimeCounter / total : 0.0);
+    }
+    framebuffer_get_stats(&lcd);
+    printf("LCD: %llu frames, SPI %llu bytes (%llu pixel data) in %llu transactions (%llu commands)\n",
+           (unsigned long long)lcd.frames, (unsigned long long)lcd.bytes, (unsigned long long)lcd.pixel_bytes,
+           (unsigned long long)lcd.transactions, (unsigned long long)lcd.cmd_transactions);
+    printf("LCD wire time at %.0f MHz: %.1f ms, per frame %.3f ms average, %.3f ms last, %.3f ms max\n",
+           CONFIG_FRAMEBUFFER_SPI_FREQUENCY / 1e6, lcd.wire_ns / 1e6, lcd.frames ? lcd.wire_ns / 1e6 / lcd.frames : 0.0,
+           lcd.frame_wire_ns_last / 1e6, lcd.frame_wire_ns_max / 1e6);
+    if (memlat_report(latency, sizeof(latency)) > 0) {
+        printf("%s\n", latency);
+    }
+    printf("----- end -----\n");
+    fflush(stdout);
+}
+
+static void InputTask(void *param)
+{
+    //commands from stdin, at the end of the input the firmware keeps running
+    char line[SIM_LINE];
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        char *start = line;
+        while (isspace((unsigned char)*start)) {
+            start++;
+        }
+        start[strcspn(start, "\r\n#")] = '\0';
+        if (*start == '\0') {
+            continue;
+        }
+        if (strncmp(start, "wait", 4) == 0) {
+            vTaskDelay(pdMS_TO_TICKS(atoi(&start[4])));
+        } else if (strncmp(start, "frame", 5) == 0) {
+            char *path = &start[5];
+            while (isspace((unsigned char)*path)) {
+                path++;
+            }
+            framebuffer_request_dump(*path != '\0' ? path : "frame.ppm", screen_rotation());
+        } else if (strcmp(start, "quit") == 0) {
+            print_report();
+            exit(0);
+        } else {
+            press(start);
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+static void TimeoutTask(void *param)
+{
+    vTaskDelay(pdMS_TO_TICKS((uintptr_t)param * 1000));
+    print_report();
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seconds = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:t:u")) != -1) {
+        switch (opt) {
+        case 'f': font_dir = optarg; break;
+        case 't': seconds = strtoul(optarg, NULL, 10); break;
+        case 'u': posix_port_pin_cores(false); break;
+        default:
+            fprintf(stderr, "usage: %s [-f fontdir] [-t seconds] [-u]\n", argv[0]);
+            return 1;
+        }
+    }
+    //the console of the board is not buffered either, logs and reports keep their order
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    xTaskCreate(InputTask, "sim input", 4096, NULL, 1, NULL);
+    if (seconds > 0) {
+        xTaskCreate(TimeoutTask, "sim timeout", 4096, (void *)(uintptr_t)seconds, 1, NULL);
+    }
+    //the main thread becomes the task "main" of ESP-IDF, app_main does not return
+    app_main();
+    return 0;
+}
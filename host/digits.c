@@ -0,0 +1,297 @@
+/********************************************************************************************* */
+//    Tool for digit containers (components/pimath/digitstore.h)
+//
+//    usage: digits compute <symbol> <digits> <out.cpdg>    binary splitting, symbols of bsplit_series_list
+//           digits pack <symbol> <in.txt> <out.cpdg>       text like "3.14159...", whitespace is skipped
+//           digits unpack <file.cpdg>                      prints the constant as text
+//           digits get <file.cpdg> <position> [count]      position 1 is the first digit after the point
+//           digits verify <file.cpdg>
+//           digits diff <a.cpdg> <b.cpdg>                  first differing digit, both files are mapped
+/********************************************************************************************* */
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bsplit.h"
+#include "digitstore.h"
+
+#define CHUNK_DIGITS 4096
+
+static int usage(const char *name)
+{
+    fprintf(stderr, "usage: %s compute <symbol> <digits> <out.cpdg>\n"
+                    "       %s pack <symbol> <in.txt> <out.cpdg>\n"
+                    "       %s unpack <file.cpdg>\n"
+                    "       %s get <file.cpdg> <position> [count]\n"
+                    "       %s verify <file.cpdg>\n"
+                    "       %s diff <a.cpdg> <b.cpdg>\n", name, name, name, name, name, name);
+    return 1;
+}
+
+static bool store_text(const char *text, size_t len, const char *symbol, const char *path)
+{
+    //text is "<integer>.<fraction>"
+    const char *point = memchr(text, '.', len);
+    char integer[DIGITSTORE_INTEGER_LEN] = "0";
+    size_t intlen = point ? (size_t)(point - text) : len;
+    if (intlen >= DIGITSTORE_INTEGER_LEN) {
+        fprintf(stderr, "integer part too long\n");
+        return false;
+    }
+    if (point != NULL) {
+        memcpy(integer, text, intlen);
+        integer[intlen] = '\0';
+    }
+
+    digitstore_writer w;
+    if (!digitstore_create(&w, path, symbol, integer)) {
+        perror(path);
+        return false;
+    }
+    bool ok = true;
+    if (point != NULL) {
+        ok = digitstore_append(&w, point + 1, len - intlen - 1);
+    }
+    ok = digitstore_finish(&w) && ok;
+    if (!ok) {
+        fprintf(stderr, "writing %s failed\n", path);
+    }
+    return ok;
+}
+
+static int cmd_compute(const char *symbol, uint32_t digits, const char *path)
+{
+    const bsplit_series *series = NULL;
+    for (uint32_t i = 0; i < bsplit_series_count; i++) {
+        if (strcmp(bsplit_series_list[i]->symbol, symbol) == 0) {
+            series = bsplit_series_list[i];
+        }
+    }
+    if (series == NULL) {
+        fprintf(stderr, "unknown symbol %s\n", symbol);
+        return 1;
+    }
+
+    bigint_t fixed;
+    bigint_init(&fixed);
+    size_t buflen = digits + 64;
+    char *buf = malloc(buflen);
+    size_t len = 0;
+    if (buf != NULL && bsplit_compute(series, digits, &fixed)) {
+        len = bsplit_format(&fixed, digits, buf, buflen);
+    }
+    bigint_free(&fixed);
+    bool ok = len > 0 && store_text(buf, len, symbol, path);
+    free(buf);
+    if (ok) {
+        printf("%s: %u digits of %s, %llu bytes\n", path, digits, series->name, (unsigned long long)digitstore_size(digits));
+    }
+    return ok ? 0 : 1;
+}
+
+static int cmd_pack(const char *symbol, const char *in, const char *out)
+{
+    FILE *f = fopen(in, "r");
+    if (f == NULL) {
+        perror(in);
+        return 1;
+    }
+    size_t cap = 1 << 20, len = 0;
+    char *text = malloc(cap);
+    int c;
+    while (text != NULL && (c = fgetc(f)) != EOF) {
+        if (isspace(c)) {
+            continue;
+        }
+        if (len == cap) {
+            cap *= 2;
+            char *grown = realloc(text, cap);
+            if (grown == NULL) {
+                free(text);
+                text = NULL;
+                break;
+            }
+            text = grown;
+        }
+        text[len++] = (char)c;
+    }
+    fclose(f);
+    bool ok = text != NULL && store_text(text, len, symbol, out);
+    free(text);
+    return ok ? 0 : 1;
+}
+
+static int print_digits(digitstore_reader *r, uint64_t first, uint64_t count)
+{
+    char buf[CHUNK_DIGITS];
+    while (count > 0) {
+        size_t n = digitstore_read(r, first, buf, count < CHUNK_DIGITS ? count : CHUNK_DIGITS);
+        if (n == 0) {
+            return 1;
+        }
+        fwrite(buf, 1, n, stdout);
+        first += n;
+        count -= n;
+    }
+    putchar('\n');
+    return 0;
+}
+
+static int cmd_unpack(const char *path)
+{
+    digitstore_reader r;
+    if (!digitstore_open(&r, path)) {
+        fprintf(stderr, "%s is not a digit container\n", path);
+        return 1;
+    }
+    printf("%s.", r.header.integer);
+    int ret = print_digits(&r, 0, r.header.digits);
+    digitstore_close(&r);
+    return ret;
+}
+
+static int cmd_get(const char *path, uint64_t position, uint64_t count)
+{
+    digitstore_reader r;
+    if (!digitstore_open(&r, path)) {
+        fprintf(stderr, "%s is not a digit container\n", path);
+        return 1;
+    }
+    int ret = 1;
+    if (position >= 1 && position <= r.header.digits) {
+        ret = print_digits(&r, position - 1, count);
+    } else {
+        fprintf(stderr, "%s holds the positions 1..%llu\n", path, (unsigned long long)r.header.digits);
+    }
+    digitstore_close(&r);
+    return ret;
+}
+
+static int cmd_verify(const char *path)
+{
+    digitstore_reader r;
+    if (!digitstore_open(&r, path)) {
+        fprintf(stderr, "%s is not a digit container\n", path);
+        return 1;
+    }
+    int64_t bad = digitstore_verify(&r);
+    if (bad < 0) {
+        printf("%s: %s, %llu digits in %u blocks, ok\n", path, r.header.symbol, (unsigned long long)r.header.digits, r.header.block_count);
+    } else {
+        printf("%s: block %lld (positions %llu..) is corrupt\n", path, (long long)bad, (unsigned long long)bad * DIGITSTORE_BLOCK_DIGITS + 1);
+    }
+    digitstore_close(&r);
+    return bad < 0 ? 0 : 1;
+}
+
+static const void *map_file(const char *path, size_t *size)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    *size = st.st_size;
+    return data;
+}
+
+static int cmd_diff(const char *path_a, const char *path_b)
+{
+    size_t size_a = 0, size_b = 0;
+    const void *map_a = map_file(path_a, &size_a);
+    const void *map_b = map_file(path_b, &size_b);
+    digitstore_reader a, b;
+    bool open_a = map_a != NULL && digitstore_open_memory(&a, map_a, size_a);
+    bool open_b = map_b != NULL && digitstore_open_memory(&b, map_b, size_b);
+    int ret = 2;
+
+    if (open_a && open_b) {
+        //whole blocks are compared as packed bytes, only the first differing block is unpacked
+        uint64_t common = (a.header.digits < b.header.digits) ? a.header.digits : b.header.digits;
+        uint32_t blocks = (common + DIGITSTORE_BLOCK_DIGITS - 1) / DIGITSTORE_BLOCK_DIGITS;
+        uint64_t match = common;
+        for (uint32_t block = 0; block < blocks; block++) {
+            if (memcmp(digitstore_block_data(&a, block), digitstore_block_data(&b, block), DIGITSTORE_BLOCK_BYTES) == 0) {
+                continue;
+            }
+            char da[DIGITSTORE_BLOCK_DIGITS], db[DIGITSTORE_BLOCK_DIGITS];
+            uint64_t first = (uint64_t)block * DIGITSTORE_BLOCK_DIGITS;
+            size_t na = digitstore_read(&a, first, da, DIGITSTORE_BLOCK_DIGITS);
+            size_t nb = digitstore_read(&b, first, db, DIGITSTORE_BLOCK_DIGITS);
+            size_t n = (na < nb) ? na : nb;
+            size_t i = 0;
+            while (i < n && da[i] == db[i]) {
+                i++;
+            }
+            if (i < n) {
+                match = first + i;
+                break;
+            }
+        }
+        if (strcmp(a.header.integer, b.header.integer) != 0) {
+            printf("integer parts differ: %s / %s\n", a.header.integer, b.header.integer);
+            ret = 1;
+        } else if (match < common) {
+            printf("first difference at position %llu: %d / %d, %llu matching digits\n", (unsigned long long)match + 1,
+                   digitstore_digit(&a, match), digitstore_digit(&b, match), (unsigned long long)match);
+            ret = 1;
+        } else {
+            printf("%llu matching digits (%llu / %llu stored)\n", (unsigned long long)common,
+                   (unsigned long long)a.header.digits, (unsigned long long)b.header.digits);
+            ret = 0;
+        }
+    } else {
+        fprintf(stderr, "could not map %s\n", open_a ? path_b : path_a);
+    }
+
+    if (open_a) {
+        digitstore_close(&a);
+    }
+    if (open_b) {
+        digitstore_close(&b);
+    }
+    if (map_a != NULL) {
+        munmap((void *)map_a, size_a);
+    }
+    if (map_b != NULL) {
+        munmap((void *)map_b, size_b);
+    }
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 5 && strcmp(argv[1], "compute") == 0) {
+        return cmd_compute(argv[2], strtoul(argv[3], NULL, 0), argv[4]);
+    }
+    if (argc >= 5 && strcmp(argv[1], "pack") == 0) {
+        return cmd_pack(argv[2], argv[3], argv[4]);
+    }
+    if (argc >= 3 && strcmp(argv[1], "unpack") == 0) {
+        return cmd_unpack(argv[2]);
+    }
+    if (argc >= 4 && strcmp(argv[1], "get") == 0) {
+        return cmd_get(argv[2], strtoull(argv[3], NULL, 0), (argc >= 5) ? strtoull(argv[4], NULL, 0) : 1);
+    }
+    if (argc >= 3 && strcmp(argv[1], "verify") == 0) {
+        return cmd_verify(argv[2]);
+    }
+    if (argc >= 4 && strcmp(argv[1], "diff") == 0) {
+        return cmd_diff(argv[2], argv[3]);
+    }
+    return usage(argv[0]);
+}
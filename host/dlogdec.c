@@ -0,0 +1,407 @@
+/********************************************************************************************* */
+//    Decodes the deferred log of the firmware (components/dlog) back into text
+//    The records only carry the addresses of the tag and format strings and the raw arguments. The
+//    strings are read from the firmware ELF of the same build and the records formatted with the host
+//    printf, all cores merged by time. The input is a console log with the hex dump between
+//    "----- dlog -----" and "----- end -----" (the last dump of the log is taken) or the binary dump.
+//    64 bit ELFs like calcpi_sim are read as well, the records keep 32 bit addresses, so the binary
+//    has to be linked without PIE and its strings have to sit below 4 GiB.
+//
+//    usage: dlogdec <firmware.elf> <log or dump> [out.txt]
+/********************************************************************************************* */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlog.h"
+
+#define ELF_SHF_ALLOC 0x2
+#define ELF_SHT_PROGBITS 1
+#define SPEC_LEN 32
+
+typedef struct {
+    dlog_record raw;
+    int64_t time_us;                    // unwrapped
+} record;
+
+typedef struct {
+    dlog_header header;
+    uint32_t counts[DLOG_MAX_CORES];
+    record records[DLOG_MAX_CORES][DLOG_RING_RECORDS];
+} dlog;
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    bool is64;
+    uint64_t shoff;
+    uint16_t shentsize;
+    uint16_t shnum;
+} elf;
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(len + 1);
+    if (data != NULL && fread(data, 1, len, f) != (size_t)len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    if (data != NULL) {
+        data[len] = '\0';
+        *size = len;
+    }
+    return data;
+}
+
+static uint32_t le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint64_t le64(const uint8_t *p)
+{
+    return le32(p) | ((uint64_t)le32(&p[4]) << 32);
+}
+
+static bool elf_open(elf *e, const uint8_t *data, size_t size)
+{
+    //little endian, 32 bit for the Xtensa and RISC-V images of the ESP32 family, 64 bit for the host
+    if (size < 64 || memcmp(data, "\x7f" "ELF", 4) != 0 || (data[4] != 1 && data[4] != 2) || data[5] != 1) {
+        return false;
+    }
+    e->data = data;
+    e->size = size;
+    e->is64 = data[4] == 2;
+    e->shoff = e->is64 ? le64(&data[0x28]) : le32(&data[0x20]);
+    e->shentsize = le16(&data[e->is64 ? 0x3a : 0x2e]);
+    e->shnum = le16(&data[e->is64 ? 0x3c : 0x30]);
+    return e->shentsize >= (e->is64 ? 64 : 40) && e->shoff <= size &&
+           (uint64_t)e->shentsize * e->shnum <= size - e->shoff;
+}
+
+static const char *elf_string(const elf *e, uint32_t addr)
+{
+    //the string at addr in a loaded section of the image, NULL if it is not there or not terminated
+    for (uint16_t i = 0; i < e->shnum; i++) {
+        const uint8_t *sh = &e->data[e->shoff + (size_t)i * e->shentsize];
+        uint32_t type = le32(&sh[4]);
+        uint64_t flags, sh_addr, offset, size;
+        if (e->is64) {
+            flags = le64(&sh[8]), sh_addr = le64(&sh[16]), offset = le64(&sh[24]), size = le64(&sh[32]);
+        } else {
+            flags = le32(&sh[8]), sh_addr = le32(&sh[12]), offset = le32(&sh[16]), size = le32(&sh[20]);
+        }
+        if (type != ELF_SHT_PROGBITS || !(flags & ELF_SHF_ALLOC) || addr < sh_addr || addr - sh_addr >= size ||
+            offset > e->size || size > e->size - offset) {
+            continue;
+        }
+        const char *s = (const char *)&e->data[offset + (addr - sh_addr)];
+        if (memchr(s, '\0', size - (addr - sh_addr)) == NULL) {
+            return NULL;
+        }
+        return s;
+    }
+    return NULL;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static uint8_t *decode_log(const char *text, size_t *size)
+{
+    //hex lines of the last dump in the log, log lines of other tasks in between are skipped
+    const char *start = NULL, *p = text;
+    while ((p = strstr(p, "----- dlog -----")) != NULL) {
+        start = p;
+        p++;
+    }
+    if (start == NULL) {
+        return NULL;
+    }
+    start = strchr(start, '\n');
+    const char *end = start != NULL ? strstr(start, "----- end -----") : NULL;
+    if (end == NULL) {
+        return NULL;
+    }
+
+    uint8_t *data = malloc((end - start) / 2 + 1);
+    size_t n = 0;
+    for (const char *line = start + 1; line < end; ) {
+        const char *eol = memchr(line, '\n', end - line);
+        if (eol == NULL) {
+            eol = end;
+        }
+        const char *c = line;
+        while (c < eol && (*c == ' ' || *c == '\r')) c++;
+        size_t len = eol - c;
+        while (len > 0 && (c[len - 1] == '\r' || c[len - 1] == ' ')) len--;
+        bool hex = len > 0 && len % 2 == 0;
+        for (size_t i = 0; hex && i < len; i++) {
+            hex = hex_value(c[i]) >= 0;
+        }
+        for (size_t i = 0; hex && i < len; i += 2) {
+            data[n++] = (hex_value(c[i]) << 4) | hex_value(c[i + 1]);
+        }
+        line = eol + 1;
+    }
+    *size = n;
+    return data;
+}
+
+static bool parse(const uint8_t *data, size_t size, dlog *d)
+{
+    size_t pos = 0;
+    if (size < sizeof(dlog_header)) {
+        return false;
+    }
+    memcpy(&d->header, data, sizeof(dlog_header));
+    pos += sizeof(dlog_header);
+    if (memcmp(d->header.magic, DLOG_MAGIC, 4) != 0 || d->header.version != DLOG_VERSION ||
+        d->header.record_size != sizeof(dlog_record) || d->header.cores > DLOG_MAX_CORES ||
+        d->header.ring_records > DLOG_RING_RECORDS) {
+        fprintf(stderr, "Not a dlog dump of this version (magic, version, sizes)\n");
+        return false;
+    }
+
+    for (int core = 0; core < d->header.cores; core++) {
+        uint32_t count;
+        if (pos + sizeof(count) > size) {
+            return false;
+        }
+        memcpy(&count, &data[pos], sizeof(count));
+        pos += sizeof(count);
+        if (count > d->header.ring_records || pos + count * sizeof(dlog_record) > size) {
+            return false;
+        }
+        d->counts[core] = count;
+        for (uint32_t i = 0; i < count; i++) {
+            memcpy(&d->records[core][i].raw, &data[pos], sizeof(dlog_record));
+            pos += sizeof(dlog_record);
+        }
+    }
+    return true;
+}
+
+static void unwrap(dlog *d)
+{
+    //32 bit us wrap after 71 minutes, every core is unwrapped on its own and then moved next to the first one
+    int64_t reference = -1;
+    for (int core = 0; core < d->header.cores; core++) {
+        int64_t high = 0;
+        uint32_t previous = 0;
+        for (uint32_t i = 0; i < d->counts[core]; i++) {
+            uint32_t now = d->records[core][i].raw.time_us;
+            if (i > 0 && now < previous && previous - now > 0x80000000u) {
+                high += 0x100000000LL;
+            }
+            previous = now;
+            d->records[core][i].time_us = high + now;
+        }
+        if (d->counts[core] == 0) {
+            continue;
+        }
+        if (reference < 0) {
+            reference = d->records[core][0].time_us;
+            continue;
+        }
+        int64_t shift = 0;
+        while (d->records[core][0].time_us + shift - reference > 0x80000000LL) shift -= 0x100000000LL;
+        while (reference - (d->records[core][0].time_us + shift) > 0x80000000LL) shift += 0x100000000LL;
+        for (uint32_t i = 0; i < d->counts[core]; i++) {
+            d->records[core][i].time_us += shift;
+        }
+    }
+}
+
+static size_t format_record(const elf *e, const dlog_record *r, char *out, size_t size)
+{
+    //printf of the device: int and long are 32 bits, only ll and j take all 64 bits of an argument
+    const char *format = elf_string(e, r->format);
+    size_t len = 0;
+    int arg = 0;
+
+    if (format == NULL) {
+        return snprintf(out, size, "<format at 0x%08x not in the ELF>", r->format);
+    }
+    for (const char *p = format; *p != '\0' && len < size; ) {
+        if (*p != '%') {
+            out[len++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[len++] = '%';
+            p += 2;
+            continue;
+        }
+
+        char spec[SPEC_LEN];
+        size_t n = 0;
+        spec[n++] = *p++;
+        while (*p != '\0' && strchr("-+ #0123456789.", *p) != NULL && n < SPEC_LEN - 4) {
+            spec[n++] = *p++;
+        }
+        int wide = 0, narrow = 0;
+        while (*p != '\0' && strchr("hlLqjzt", *p) != NULL) {
+            wide += (*p == 'l' || *p == 'q' || *p == 'j');
+            narrow += (*p == 'h');
+            p++;
+        }
+        char conversion = *p;
+        if (conversion == '\0') {
+            break;
+        }
+        p++;
+        if (arg >= r->nargs) {
+            len += snprintf(&out[len], size - len, "<?>");
+            continue;
+        }
+        uint64_t value = r->args[arg++];
+
+        switch (conversion) {
+        case 'd':
+        case 'i': {
+            int64_t v = (wide >= 2) ? (int64_t)value : (narrow == 2) ? (int8_t)value : (narrow == 1) ? (int16_t)value : (int32_t)value;
+            spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conversion; spec[n] = '\0';
+            len += snprintf(&out[len], size - len, spec, (long long)v);
+            break;
+        }
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            uint64_t v = (wide >= 2) ? value : (narrow == 2) ? (uint8_t)value : (narrow == 1) ? (uint16_t)value : (uint32_t)value;
+            spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conversion; spec[n] = '\0';
+            len += snprintf(&out[len], size - len, spec, (unsigned long long)v);
+            break;
+        }
+        case 'c':
+            spec[n++] = 'c'; spec[n] = '\0';
+            len += snprintf(&out[len], size - len, spec, (int)(char)value);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A': {
+            double v;
+            memcpy(&v, &value, sizeof(v));
+            spec[n++] = conversion; spec[n] = '\0';
+            len += snprintf(&out[len], size - len, spec, v);
+            break;
+        }
+        case 's': {
+            const char *s = elf_string(e, (uint32_t)value);
+            spec[n++] = 's'; spec[n] = '\0';
+            if (s != NULL) {
+                len += snprintf(&out[len], size - len, spec, s);
+            } else {
+                len += snprintf(&out[len], size - len, "<string at 0x%08x>", (uint32_t)value);
+            }
+            break;
+        }
+        case 'p':
+            len += snprintf(&out[len], size - len, "0x%08x", (uint32_t)value);
+            break;
+        default:
+            len += snprintf(&out[len], size - len, "<%%%c>", conversion);
+            break;
+        }
+    }
+    if (len >= size) {
+        len = size - 1;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+static void print_log(const elf *e, const dlog *d, FILE *out)
+{
+    //the rings are sorted by time, merging them keeps the order across cores
+    uint32_t next[DLOG_MAX_CORES] = {0};
+    char text[1024];
+    for (;;) {
+        int core = -1;
+        for (int c = 0; c < d->header.cores; c++) {
+            if (next[c] < d->counts[c] && (core < 0 || d->records[c][next[c]].time_us < d->records[core][next[core]].time_us)) {
+                core = c;
+            }
+        }
+        if (core < 0) {
+            break;
+        }
+        const record *r = &d->records[core][next[core]++];
+        const char *tag = elf_string(e, r->raw.tag);
+        format_record(e, &r->raw, text, sizeof(text));
+        fprintf(out, "D (%lld.%03lld) C%u %s: %s\n", (long long)(r->time_us / 1000), (long long)(r->time_us % 1000),
+                r->raw.core, tag != NULL ? tag : "?", text);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <firmware.elf> <log or dump> [out.txt]\n", argv[0]);
+        return 1;
+    }
+    size_t elf_size, size;
+    uint8_t *elf_data = read_file(argv[1], &elf_size);
+    elf e;
+    if (elf_data == NULL || !elf_open(&e, elf_data, elf_size)) {
+        fprintf(stderr, "%s is not a little endian ELF\n", argv[1]);
+        return 1;
+    }
+    uint8_t *file = read_file(argv[2], &size);
+    if (file == NULL) {
+        fprintf(stderr, "Could not read %s\n", argv[2]);
+        return 1;
+    }
+    uint8_t *data = file;
+    if (size < 4 || memcmp(file, DLOG_MAGIC, 4) != 0) {
+        data = decode_log((const char *)file, &size);
+        if (data == NULL) {
+            fprintf(stderr, "No dlog dump in %s\n", argv[2]);
+            return 1;
+        }
+    }
+
+    dlog *d = calloc(1, sizeof(dlog));
+    if (!parse(data, size, d)) {
+        fprintf(stderr, "The dump is cut off or corrupt\n");
+        return 1;
+    }
+    unwrap(d);
+
+    FILE *out = (argc > 3) ? fopen(argv[3], "w") : stdout;
+    if (out == NULL) {
+        fprintf(stderr, "Could not write %s\n", argv[3]);
+        return 1;
+    }
+    print_log(&e, d, out);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
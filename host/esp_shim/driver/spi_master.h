@@ -0,0 +1,12 @@
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct spi_device_t *spi_device_handle_t;
+typedef int spi_host_device_t;
+
+#define SPI2_HOST 1
+#define SPI3_HOST 2
+#define SPI_MASTER_FREQ_10M 10000000
+#define SPI_MASTER_FREQ_20M 20000000
+#define SPI_MASTER_FREQ_40M 40000000
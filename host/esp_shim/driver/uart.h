@@ -0,0 +1,14 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef int uart_port_t;
+
+#define UART_NUM_0 0
+#define UART_NUM_1 1
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer, int tx_buffer, int queue_size, QueueHandle_t *queue, int flags);
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t len, TickType_t ticks);
+int uart_write_bytes(uart_port_t port, const void *data, size_t len);
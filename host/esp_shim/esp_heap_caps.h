@@ -0,0 +1,13 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+
+// the host has one heap, the capabilities only place memory on the ESP32
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+static inline void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return malloc(size);
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <stdbool.h>
+
+// Tasks pinned to a core run on the host CPU with that number, the others on the CPUs of the board cores.
+// Without pinning the host scheduler may use all CPUs. Has to be set before the first task is created.
+void posix_port_pin_cores(bool pin);
@@ -0,0 +1,578 @@
+/********************************************************************************************* */
+//    FreeRTOS and esp_timer on POSIX threads, the thin port behind esp_shim for firmware code which
+//    needs a scheduler (host/calcpi_sim). Every task is a thread, tasks pinned to a core run on the
+//    host CPU with that number, the others share the CPUs of the board cores. Priorities are kept
+//    for uxTaskGetSystemState only, the host scheduler shares the CPUs fairly.
+//    The run time counter is the CPU time of the thread in us, so the accounting of the firmware
+//    sees the time other threads took the CPU as preempted time like on the board.
+/********************************************************************************************* */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "posix_port.h"
+
+#define TAG "posix_port"
+
+#define PORT_STACK_SCALE 4              // 64 bit pointers and the sanitizers need more stack than the board
+#define PORT_STACK_MIN (64 * 1024)
+#define PORT_MAIN_PRIO 1                // ESP-IDF runs app_main in the task "main" on core 0
+
+typedef struct port_task {
+    pthread_t thread;
+    char name[configMAX_TASK_NAME_LEN];
+    TaskFunction_t fn;
+    void *param;
+    UBaseType_t prio;
+    BaseType_t core;
+    uint32_t stack;
+    UBaseType_t number;
+    void *tag;
+    bool deleted;
+    configRUN_TIME_COUNTER_TYPE runtime;    // CPU time when the task was deleted
+    pthread_mutex_t lock;
+    pthread_cond_t notified;
+    uint32_t notify;
+    struct port_task *next;
+} port_task;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t count;
+    UBaseType_t max;
+} port_semaphore;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    EventBits_t bits;
+} port_event_group;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *items;
+} port_queue;
+
+static pthread_mutex_t tasks_lock = PTHREAD_MUTEX_INITIALIZER;
+static port_task *tasks = NULL;
+static UBaseType_t task_numbers = 0;
+static bool pin_cores = true;
+static __thread port_task *current = NULL;
+static struct timespec boot;
+static pthread_once_t boot_once = PTHREAD_ONCE_INIT;
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Time                                                                                                              */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static void boot_init(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &boot);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    //like on the board the timer starts near zero
+    struct timespec now;
+    pthread_once(&boot_once, boot_init);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - boot.tv_sec) * 1000000 + (now.tv_nsec - boot.tv_nsec) / 1000;
+}
+
+static void cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static struct timespec deadline(TickType_t ticks)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ns = (uint64_t)ticks * portTICK_PERIOD_MS * 1000000 + ts.tv_nsec;
+    ts.tv_sec += ns / 1000000000;
+    ts.tv_nsec = ns % 1000000000;
+    return ts;
+}
+
+// waits for the condition until the deadline of ticks, false once the time is up
+static bool cond_wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, const struct timespec *until)
+{
+    if (ticks == 0) {
+        return false;
+    }
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, until) != ETIMEDOUT;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Tasks                                                                                                             */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static void set_affinity(BaseType_t core)
+{
+    //pinned tasks get the host CPU of their core, the others the CPUs of all board cores
+    if (!pin_cores) {
+        return;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        if (core == tskNO_AFFINITY || core == c) {
+            CPU_SET(c % cpus, &set);
+        }
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static port_task *task_new(const char *name, UBaseType_t prio, BaseType_t core, uint32_t stack)
+{
+    port_task *t = calloc(1, sizeof(port_task));
+    strncpy(t->name, name, configMAX_TASK_NAME_LEN - 1);
+    t->prio = prio;
+    t->core = core;
+    t->stack = stack;
+    pthread_mutex_init(&t->lock, NULL);
+    cond_init(&t->notified);
+    pthread_mutex_lock(&tasks_lock);
+    t->number = ++task_numbers;
+    //in the order of creation, like the task numbers
+    port_task **tail = &tasks;
+    while (*tail != NULL) {
+        tail = &(*tail)->next;
+    }
+    *tail = t;
+    pthread_mutex_unlock(&tasks_lock);
+    return t;
+}
+
+static port_task *self(void)
+{
+    //threads the port did not start, the first one is main() running app_main
+    if (current == NULL) {
+        current = task_new((gettid() == getpid()) ? "main" : "host thread", PORT_MAIN_PRIO, tskNO_AFFINITY, 0);
+        current->thread = pthread_self();
+    }
+    return current;
+}
+
+static void *task_entry(void *arg)
+{
+    port_task *t = arg;
+    current = t;
+    t->thread = pthread_self();
+    pthread_setname_np(t->thread, t->name);
+    set_affinity(t->core);
+    t->fn(t->param);
+    //a FreeRTOS task must not return, here it ends like after vTaskDelete(NULL)
+    ESP_LOGW(TAG, "Task %s returned", t->name);
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+void posix_port_pin_cores(bool pin)
+{
+    pin_cores = pin;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *param, UBaseType_t prio, TaskHandle_t *handle, BaseType_t core)
+{
+    port_task *t = task_new(name, prio, core, stack);
+    pthread_attr_t attr;
+    size_t size = (size_t)stack * PORT_STACK_SCALE;
+
+    t->fn = fn;
+    t->param = param;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, (size < PORT_STACK_MIN) ? PORT_STACK_MIN : size);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (handle != NULL) {
+        *handle = t;
+    }
+    int err = pthread_create(&t->thread, &attr, task_entry, t);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        ESP_LOGE(TAG, "Task %s could not be started: %s", name, strerror(err));
+        t->deleted = true;
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *param, UBaseType_t prio, TaskHandle_t *handle)
+{
+    return xTaskCreatePinnedToCore(fn, name, stack, param, prio, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    port_task *t = self();
+    if (task != NULL && task != t) {
+        //threads cannot be stopped from outside at an arbitrary point, the firmware only deletes itself
+        ESP_LOGE(TAG, "vTaskDelete of another task is not supported");
+        return;
+    }
+    //the record stays, other tasks may still hold the handle
+    t->runtime = ulTaskGetRunTimeCounter(NULL);
+    t->deleted = true;
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec until = deadline(ticks);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000 / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return self();
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    port_task *t = self();
+    if (t->core != tskNO_AFFINITY) {
+        return t->core;
+    }
+    int cpu = sched_getcpu();
+    return (cpu < 0) ? 0 : cpu % portNUM_PROCESSORS;
+}
+
+void vPortYield(void)
+{
+    sched_yield();
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    port_task *t = task;
+    pthread_mutex_lock(&t->lock);
+    t->notify++;
+    pthread_cond_broadcast(&t->notified);
+    pthread_mutex_unlock(&t->lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    port_task *t = self();
+    struct timespec until = deadline(ticks);
+    uint32_t value;
+
+    pthread_mutex_lock(&t->lock);
+    while (t->notify == 0 && cond_wait(&t->notified, &t->lock, ticks, &until));
+    value = t->notify;
+    if (value > 0) {
+        t->notify = clear ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&t->lock);
+    return value;
+}
+
+void vTaskSetApplicationTaskTag(TaskHandle_t task, void *tag)
+{
+    ((port_task *)(task == NULL ? self() : task))->tag = tag;
+}
+
+configRUN_TIME_COUNTER_TYPE ulTaskGetRunTimeCounter(TaskHandle_t task)
+{
+    port_task *t = (task == NULL) ? self() : task;
+    clockid_t clock;
+    struct timespec ts;
+
+    if (t->deleted) {
+        return t->runtime;
+    }
+    if (t == self()) {
+        clock = CLOCK_THREAD_CPUTIME_ID;
+    } else if (pthread_getcpuclockid(t->thread, &clock) != 0) {
+        return t->runtime;
+    }
+    clock_gettime(clock, &ts);
+    return (configRUN_TIME_COUNTER_TYPE)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    //not measured on the host, the whole stack of the board counts as free
+    return ((port_task *)(task == NULL ? self() : task))->stack;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *states, UBaseType_t max, configRUN_TIME_COUNTER_TYPE *total)
+{
+    UBaseType_t count = 0;
+    pthread_mutex_lock(&tasks_lock);
+    for (port_task *t = tasks; t != NULL; t = t->next) {
+        if (t->deleted) {
+            continue;
+        }
+        if (count == max) {
+            //like FreeRTOS, an array which is too small gets nothing
+            count = 0;
+            break;
+        }
+        states[count++] = (TaskStatus_t){
+            .xHandle = t,
+            .pcTaskName = t->name,
+            .xTaskNumber = t->number,
+            .eCurrentState = (t == current) ? eRunning : eReady,
+            .uxCurrentPriority = t->prio,
+            .uxBasePriority = t->prio,
+            .ulRunTimeCounter = ulTaskGetRunTimeCounter(t),
+            .usStackHighWaterMark = t->stack,
+            .xCoreID = t->core,
+        };
+    }
+    pthread_mutex_unlock(&tasks_lock);
+    if (total != NULL) {
+        *total = (configRUN_TIME_COUNTER_TYPE)esp_timer_get_time();
+    }
+    return count;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Critical sections, semaphores, queues and event groups                                                            */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+void vPortEnterCritical(portMUX_TYPE *mux)
+{
+    uintptr_t owner = (uintptr_t)self();
+    if (__atomic_load_n(&mux->owner, __ATOMIC_RELAXED) == owner) {
+        mux->count++;
+        return;
+    }
+    uintptr_t expected = 0;
+    while (!__atomic_compare_exchange_n(&mux->owner, &expected, owner, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        expected = 0;
+        sched_yield();
+    }
+    mux->count = 1;
+}
+
+void vPortExitCritical(portMUX_TYPE *mux)
+{
+    if (--mux->count == 0) {
+        __atomic_store_n(&mux->owner, 0, __ATOMIC_RELEASE);
+    }
+}
+
+static SemaphoreHandle_t semaphore_new(UBaseType_t count, UBaseType_t max)
+{
+    port_semaphore *s = calloc(1, sizeof(port_semaphore));
+    pthread_mutex_init(&s->lock, NULL);
+    cond_init(&s->changed);
+    s->count = count;
+    s->max = max;
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return semaphore_new(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return semaphore_new(0, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    port_semaphore *s = sem;
+    struct timespec until = deadline(ticks);
+    BaseType_t taken = pdFALSE;
+
+    pthread_mutex_lock(&s->lock);
+    while (s->count == 0 && cond_wait(&s->changed, &s->lock, ticks, &until));
+    if (s->count > 0) {
+        s->count--;
+        taken = pdTRUE;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return taken;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    port_semaphore *s = sem;
+    BaseType_t given = pdFALSE;
+
+    pthread_mutex_lock(&s->lock);
+    if (s->count < s->max) {
+        s->count++;
+        given = pdTRUE;
+        pthread_cond_broadcast(&s->changed);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return given;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    port_semaphore *s = sem;
+    pthread_cond_destroy(&s->changed);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    port_queue *q = calloc(1, sizeof(port_queue));
+    pthread_mutex_init(&q->lock, NULL);
+    cond_init(&q->changed);
+    q->length = length;
+    q->item_size = item_size;
+    q->items = malloc((size_t)length * item_size);
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    port_queue *q = queue;
+    struct timespec until = deadline(ticks);
+    BaseType_t sent = pdFALSE;
+
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->length && cond_wait(&q->changed, &q->lock, ticks, &until));
+    if (q->count < q->length) {
+        memcpy(&q->items[((q->head + q->count) % q->length) * q->item_size], item, q->item_size);
+        q->count++;
+        sent = pdTRUE;
+        pthread_cond_broadcast(&q->changed);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return sent;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    port_queue *q = queue;
+    struct timespec until = deadline(ticks);
+    BaseType_t received = pdFALSE;
+
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && cond_wait(&q->changed, &q->lock, ticks, &until));
+    if (q->count > 0) {
+        memcpy(item, &q->items[q->head * q->item_size], q->item_size);
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+        received = pdTRUE;
+        pthread_cond_broadcast(&q->changed);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return received;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    port_queue *q = queue;
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t count = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return count;
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    port_event_group *g = calloc(1, sizeof(port_event_group));
+    pthread_mutex_init(&g->lock, NULL);
+    cond_init(&g->changed);
+    return g;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    port_event_group *g = group;
+    pthread_mutex_lock(&g->lock);
+    g->bits |= bits;
+    EventBits_t now = g->bits;
+    pthread_cond_broadcast(&g->changed);
+    pthread_mutex_unlock(&g->lock);
+    return now;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    port_event_group *g = group;
+    pthread_mutex_lock(&g->lock);
+    EventBits_t before = g->bits;
+    g->bits &= ~bits;
+    pthread_mutex_unlock(&g->lock);
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    port_event_group *g = group;
+    pthread_mutex_lock(&g->lock);
+    EventBits_t bits = g->bits;
+    pthread_mutex_unlock(&g->lock);
+    return bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear, BaseType_t all, TickType_t ticks)
+{
+    port_event_group *g = group;
+    struct timespec until = deadline(ticks);
+    EventBits_t value;
+
+    pthread_mutex_lock(&g->lock);
+    for (;;) {
+        bool met = all ? ((g->bits & bits) == bits) : ((g->bits & bits) != 0);
+        value = g->bits;
+        if (met) {
+            //the bits before clearing are returned, like FreeRTOS does
+            if (clear) {
+                g->bits &= ~bits;
+            }
+            break;
+        }
+        if (!cond_wait(&g->changed, &g->lock, ticks, &until)) {
+            value = g->bits;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g->lock);
+    return value;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    port_event_group *g = group;
+    pthread_cond_destroy(&g->changed);
+    pthread_mutex_destroy(&g->lock);
+    free(g);
+}
@@ -0,0 +1,128 @@
+/********************************************************************************************* */
+//    Storage benchmark of the littlefs block device (components/eduboard2/eduboardFlash)
+//    The unchanged flash driver, w25.c, littlefs and the digit cache of the firmware run against a
+//    W25Q32 in RAM. Time is virtual: every SPI transaction costs its bytes at the SPI clock plus a fixed
+//    overhead, programs and erases keep the busy bit set for the typical times of the datasheet.
+//    The firmware workload is replayed (mount, boot counter, digit cache stores and lookups) and the
+//    access statistics of flash_stats are printed per file operation, like flash_stats_print on the board.
+//
+//    usage: flash_bench [-n digits] [-s stores] [-p prog us] [-e erase us] [-o overhead us]
+/********************************************************************************************* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "eduboard2.h"
+#include "digit_cache.h"
+#include "trace.h"
+#include "w25_model.h"
+
+#define DEFAULT_DIGITS 10000
+#define DEFAULT_STORES 4
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Mock of the ESP-IDF and FreeRTOS functions the flash driver calls, single threaded without a scheduler            */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+int64_t esp_timer_get_time(void) { return (int64_t)w25.now_us; }
+void trace_record(trace_type type, uint16_t id, uint32_t arg) {}
+void vPortEnterCritical(portMUX_TYPE *mux) {}
+void vPortExitCritical(portMUX_TYPE *mux) {}
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return (SemaphoreHandle_t)&w25; }
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) { return pdTRUE; }
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) { return pdTRUE; }
+
+void gpspi_init(spi_device_handle_t* handle, int pinMOSI, int pinMISO, int pinSCK, int pinCS, uint32_t frequency, bool halfduplex)
+{
+    *handle = NULL;
+    w25.frequency = frequency;
+}
+
+bool gpspi_read_write_data(spi_device_handle_t* handle, uint8_t* txdata, uint8_t* rxdata, uint32_t len)
+{
+    w25_model_transfer(txdata, rxdata, len);
+    return true;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static void random_digits(char *digits, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        digits[i] = '0' + rand() % 10;
+    }
+    digits[count] = '\0';
+}
+
+static void run_step(const char *step, double start_us)
+{
+    printf("%-40s %10.1lf ms\n", step, (w25.now_us - start_us) / 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t digits = DEFAULT_DIGITS, stores = DEFAULT_STORES;
+    int opt;
+
+    //an erased chip, the first mount formats it like on a new board
+    w25_model_init();
+    while ((opt = getopt(argc, argv, "n:s:p:e:o:")) != -1) {
+        switch (opt) {
+        case 'n': digits = strtoul(optarg, NULL, 10); break;
+        case 's': stores = strtoul(optarg, NULL, 10); break;
+        case 'p': w25.prog_us = atof(optarg); break;
+        case 'e': w25.erase_us = atof(optarg); break;
+        case 'o': w25.overhead_us = atof(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-n digits] [-s stores] [-p prog us] [-e erase us] [-o overhead us]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (digits == 0 || digits > DIGIT_CACHE_MAX_DIGITS || stores == 0) {
+        fprintf(stderr, "1 to %d digits and at least one store\n", DIGIT_CACHE_MAX_DIGITS);
+        return 1;
+    }
+    char *written = malloc(digits + 1), *read = malloc(digits + 1);
+    random_digits(written, digits);
+
+    double start = w25.now_us;
+    eduboard_init_flash();
+    printf("W25 model: SPI %.0lf MHz, +%.0lf us per transaction, program %.0lf us, erase %.0lf us\n\n",
+           w25.frequency / 1e6, w25.overhead_us, w25.prog_us, w25.erase_us);
+    run_step("format and mount", start);
+
+    start = w25.now_us;
+    flash_checkConnection();
+    run_step("boot counter and listing", start);
+
+    start = w25.now_us;
+    digit_cache_init();
+    run_step("digit cache init", start);
+
+    //growing results of one method, every store replaces the container
+    bool ok = true;
+    for (uint32_t s = 1; s <= stores; s++) {
+        uint32_t count = (uint64_t)digits * s / stores;
+        char step[64];
+        start = w25.now_us;
+        ok = digit_cache_store("pi", "Leibniz", "3", written, count) && ok;
+        snprintf(step, sizeof(step), "digit cache store %u digits", count);
+        run_step(step, start);
+
+        start = w25.now_us;
+        ok = digit_cache_lookup("pi", "Leibniz", count, read) && memcmp(read, written, count) == 0 && ok;
+        snprintf(step, sizeof(step), "digit cache lookup %u digits", count);
+        run_step(step, start);
+    }
+    printf("\n");
+    flash_stats_print();
+
+    free(written);
+    free(read);
+    if (!ok) {
+        fprintf(stderr, "The digits read back differ from the stored ones\n");
+        return 1;
+    }
+    return 0;
+}
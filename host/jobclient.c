@@ -0,0 +1,346 @@
+/********************************************************************************************* */
+//    Client for the job server on the console UART (or on jobserver_sim)
+//
+//    usage: jobclient [-b baud] [-w window] <device> <command>
+//           ping
+//           submit <constant> <digits> [cores]     constant is a symbol of bsplit_series_list or its index
+//           status <job>
+//           cancel <job>
+//           get <job> [first [count]]              streams digits to stdout
+//           run <constant> <digits> [cores]        submit, wait and get
+//           telemetry [count]                      prints the memon telemetry frames (memon_setOutput)
+/********************************************************************************************* */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bsplit.h"
+#include "jobproto.h"
+
+#define REPLY_TIMEOUT_MS 2000
+#define DEFAULT_WINDOW 8
+
+static const char *state_names[] = {"free", "queued", "running", "done", "cancelled", "failed"};
+
+static int fd;
+static uint8_t seq;
+static bool telemetry;                  // hand out the unsolicited telemetry frames of memon
+static jobproto_parser parser;
+static uint32_t window = DEFAULT_WINDOW;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static speed_t baud_constant(long baud)
+{
+    switch (baud) {
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 2000000: return B2000000;
+    default: return B115200;
+    }
+}
+
+static bool open_device(const char *path, long baud)
+{
+    fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, baud_constant(baud));
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    jobproto_parser_init(&parser);
+    return true;
+}
+
+static bool send_frame(uint8_t type, uint8_t frame_seq, const uint8_t *payload, uint16_t len)
+{
+    uint8_t buf[JOBPROTO_MAX_FRAME];
+    size_t size = jobproto_encode(type, frame_seq, payload, len, buf);
+    return write(fd, buf, size) == (ssize_t)size;
+}
+
+static const jobproto_frame *next_frame(int timeout_ms)
+{
+    //skips log output and broken frames
+    double deadline = now_s() + timeout_ms / 1000.0;
+    uint8_t byte;
+    for (;;) {
+        int left = (int)((deadline - now_s()) * 1000);
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (left <= 0 || poll(&pfd, 1, left) <= 0) {
+            return NULL;
+        }
+        if (read(fd, &byte, 1) != 1) {
+            return NULL;
+        }
+        if (jobproto_parse(&parser, byte) && (telemetry || parser.frame.type != JOBPROTO_TELEMETRY)) {
+            return &parser.frame;
+        }
+    }
+}
+
+static const jobproto_frame *request(uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    uint8_t request_seq = ++seq;
+    if (!send_frame(type, request_seq, payload, len)) {
+        return NULL;
+    }
+    const jobproto_frame *f;
+    while ((f = next_frame(REPLY_TIMEOUT_MS)) != NULL) {
+        if (f->seq != request_seq) {
+            continue;
+        }
+        if (f->type == JOBPROTO_ERROR && f->len == 2) {
+            fprintf(stderr, "request 0x%02x failed with error %u\n", f->payload[0], f->payload[1]);
+            return NULL;
+        }
+        return f;
+    }
+    fprintf(stderr, "no reply to request 0x%02x\n", type);
+    return NULL;
+}
+
+static int parse_constant(const char *name)
+{
+    for (uint32_t i = 0; i < bsplit_series_count; i++) {
+        if (strcmp(bsplit_series_list[i]->symbol, name) == 0) {
+            return i;
+        }
+    }
+    char *end;
+    long index = strtol(name, &end, 0);
+    return (*end == '\0') ? (int)index : -1;
+}
+
+static int cmd_ping(void)
+{
+    const jobproto_frame *f = request(JOBPROTO_PING, NULL, 0);
+    if (f == NULL || f->type != JOBPROTO_PONG || f->len != 6) {
+        return 1;
+    }
+    printf("protocol %u, %u jobs, %u digits max\n", f->payload[0], f->payload[1], jobproto_get_u32(&f->payload[2]));
+    return 0;
+}
+
+static int submit(int constant, uint32_t digits, uint8_t cores)
+{
+    uint8_t payload[6] = {(uint8_t)constant, cores};
+    jobproto_put_u32(&payload[2], digits);
+    const jobproto_frame *f = request(JOBPROTO_SUBMIT, payload, sizeof(payload));
+    if (f == NULL || f->type != JOBPROTO_ACCEPTED || f->len != 3) {
+        return -1;
+    }
+    return jobproto_get_u16(f->payload);
+}
+
+static int job_state(uint8_t type, uint16_t job, bool print)
+{
+    uint8_t payload[2];
+    jobproto_put_u16(payload, job);
+    const jobproto_frame *f = request(type, payload, sizeof(payload));
+    if (f == NULL || f->type != JOBPROTO_STATE || f->len != 12) {
+        return -1;
+    }
+    uint8_t state = f->payload[2];
+    if (print) {
+        printf("job %u: %s, queue position %u, %u digits, %u ms\n", job, (state < 6) ? state_names[state] : "?",
+               f->payload[3], jobproto_get_u32(&f->payload[4]), jobproto_get_u32(&f->payload[8]));
+    }
+    return state;
+}
+
+static int cmd_get(uint16_t job, uint32_t first, uint32_t count)
+{
+    uint8_t payload[12];
+    uint8_t stream_seq = ++seq;
+    jobproto_put_u16(&payload[0], job);
+    jobproto_put_u32(&payload[2], first);
+    jobproto_put_u32(&payload[6], count);
+    jobproto_put_u16(&payload[10], window);
+    if (!send_frame(JOBPROTO_STREAM, stream_seq, payload, sizeof(payload))) {
+        return 1;
+    }
+
+    //one credit per received DATA frame keeps window frames in flight
+    char digits[2 * JOBPROTO_MAX_PAYLOAD];
+    uint32_t expected = first, received = 0, pending_credits = 0;
+    double start = now_s();
+    const jobproto_frame *f;
+    while ((f = next_frame(REPLY_TIMEOUT_MS)) != NULL) {
+        if (f->seq != stream_seq) {
+            continue;
+        }
+        if (f->type == JOBPROTO_ERROR) {
+            fprintf(stderr, "stream failed with error %u\n", f->payload[1]);
+            return 1;
+        }
+        if (f->type == JOBPROTO_END) {
+            double seconds = now_s() - start;
+            printf("\n");
+            fprintf(stderr, "%u digits in %.3f s, %.0f digits/s\n", received, seconds, received / seconds);
+            return (expected == jobproto_get_u32(&f->payload[2])) ? 0 : 1;
+        }
+        if (f->type != JOBPROTO_DATA || f->len < 8) {
+            continue;
+        }
+        uint32_t offset = jobproto_get_u32(&f->payload[2]);
+        uint16_t n = jobproto_get_u16(&f->payload[6]);
+        if (offset != expected || f->len != 8 + (n + 1) / 2) {
+            fprintf(stderr, "\nunexpected DATA frame at %u, expected %u\n", offset, expected);
+            return 1;
+        }
+        for (uint16_t i = 0; i < n; i++) {
+            uint8_t b = f->payload[8 + i / 2];
+            digits[i] = '0' + ((i & 1) ? (b & 0x0F) : (b >> 4));
+        }
+        fwrite(digits, 1, n, stdout);
+        expected += n;
+        received += n;
+
+        if (++pending_credits >= (window + 1) / 2) {
+            uint8_t credit[4];
+            jobproto_put_u16(&credit[0], job);
+            jobproto_put_u16(&credit[2], pending_credits);
+            send_frame(JOBPROTO_CREDIT, ++seq, credit, sizeof(credit));
+            pending_credits = 0;
+        }
+    }
+    fprintf(stderr, "\nstream timed out after %u digits\n", received);
+    return 1;
+}
+
+static int cmd_run(int constant, uint32_t digits, uint8_t cores)
+{
+    int job = submit(constant, digits, cores);
+    if (job < 0) {
+        return 1;
+    }
+    int state;
+    double start = now_s();
+    while ((state = job_state(JOBPROTO_STATUS, job, false)) == 1 || state == 2) {
+        usleep(50000);
+    }
+    if (state != 3) {
+        job_state(JOBPROTO_STATUS, job, true);
+        return 1;
+    }
+    fprintf(stderr, "job %d done after %.3f s\n", job, now_s() - start);
+    return cmd_get(job, 0, digits);
+}
+
+static int cmd_telemetry(long count)
+{
+    //payload layout in components/memon/include/memon.h
+    const jobproto_frame *f;
+    telemetry = true;
+    for (long n = 0; count <= 0 || n < count; ) {
+        if ((f = next_frame(60 * 1000)) == NULL) {
+            fprintf(stderr, "no telemetry, memon_setOutput(MEMON_OUTPUT_FRAME) on the board\n");
+            return 1;
+        }
+        const uint8_t *p = f->payload;
+        if (f->type != JOBPROTO_TELEMETRY || f->len < 3 || p[0] != 1 || f->len != 19 + 2 * p[1] + 8 * p[2]) {
+            continue;
+        }
+        uint8_t cores = p[1], tasks = p[2];
+        printf("#%u %.3f s, interval %u ms, heap %u (min %u), memon %u us\n", f->seq, jobproto_get_u32(&p[5]) / 1000.0,
+               jobproto_get_u16(&p[3]), jobproto_get_u32(&p[9]), jobproto_get_u32(&p[13]), jobproto_get_u16(&p[17 + 2 * cores]));
+        for (uint8_t c = 0; c < cores; c++) {
+            printf("  core %u: %5.1f %%\n", c, jobproto_get_u16(&p[17 + 2 * c]) / 10.0);
+        }
+        const uint8_t *t = &p[19 + 2 * cores];
+        for (uint8_t i = 0; i < tasks; i++, t += 8) {
+            char core[4] = "-";
+            if (t[2] != 0xFF) {
+                snprintf(core, sizeof(core), "%u", t[2]);
+            }
+            printf("  task %3u  core %-2s prio %2u  stack %5u  %5.1f %%\n", jobproto_get_u16(t), core, t[3],
+                   jobproto_get_u16(&t[6]), jobproto_get_u16(&t[4]) / 10.0);
+        }
+        fflush(stdout);
+        n++;
+    }
+    return 0;
+}
+
+static int usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-b baud] [-w window] <device> ping|submit|status|cancel|get|run|telemetry ...\n", name);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    long baud = 115200;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:w:")) != -1) {
+        switch (opt) {
+        case 'b':
+            baud = atol(optarg);
+            break;
+        case 'w':
+            window = atoi(optarg);
+            break;
+        default:
+            return usage(argv[0]);
+        }
+    }
+    if (argc - optind < 2 || window < 1 || !open_device(argv[optind], baud)) {
+        return usage(argv[0]);
+    }
+    const char *cmd = argv[optind + 1];
+    char **args = &argv[optind + 2];
+    int nargs = argc - optind - 2;
+
+    if (strcmp(cmd, "ping") == 0) {
+        return cmd_ping();
+    }
+    if ((strcmp(cmd, "submit") == 0 || strcmp(cmd, "run") == 0) && nargs >= 2) {
+        int constant = parse_constant(args[0]);
+        uint8_t cores = (nargs >= 3) ? atoi(args[2]) : 1;
+        if (constant < 0) {
+            fprintf(stderr, "unknown constant %s\n", args[0]);
+            return 1;
+        }
+        if (strcmp(cmd, "run") == 0) {
+            return cmd_run(constant, strtoul(args[1], NULL, 0), cores);
+        }
+        int job = submit(constant, strtoul(args[1], NULL, 0), cores);
+        if (job >= 0) {
+            printf("job %d\n", job);
+        }
+        return job < 0;
+    }
+    if ((strcmp(cmd, "status") == 0 || strcmp(cmd, "cancel") == 0) && nargs >= 1) {
+        return job_state(strcmp(cmd, "status") == 0 ? JOBPROTO_STATUS : JOBPROTO_CANCEL, atoi(args[0]), true) < 0;
+    }
+    if (strcmp(cmd, "get") == 0 && nargs >= 1) {
+        uint32_t first = (nargs >= 2) ? strtoul(args[1], NULL, 0) : 0;
+        uint32_t count = (nargs >= 3) ? strtoul(args[2], NULL, 0) : UINT32_MAX;
+        return cmd_get(atoi(args[0]), first, count);
+    }
+    if (strcmp(cmd, "telemetry") == 0) {
+        return cmd_telemetry((nargs >= 1) ? atol(args[0]) : 0);
+    }
+    return usage(argv[0]);
+}
@@ -0,0 +1,417 @@
+/********************************************************************************************* */
+//    Test of the job server (components/jobserver) on a pseudo-terminal from openpty
+//    The server runs on the master side like jobserver_sim, the test is the host on the raw slave side.
+//    Covered: PING, SUBMIT, STATUS, STREAM with credits, CANCEL, error replies, frames with a broken CRC
+//    and log lines written between the frames. The digits must not depend on the number of parts.
+//
+//    usage: jobserver_pty_test, exits with 0 if all checks passed (ctest)
+/********************************************************************************************* */
+#define _GNU_SOURCE
+#include <poll.h>
+#include <pthread.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bsplit.h"
+#include "jobserver.h"
+
+#define TEST_DIGITS 2000
+#define TEST_WINDOW 3
+#define REPLY_TIMEOUT_MS 5000
+#define JOB_TIMEOUT_MS 20000
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+static const char pi_prefix[] = "14159265358979323846264338327950288419716939937510";
+
+static jobserver server;
+static int master_fd, slave_fd;
+static volatile bool stop;
+static pthread_mutex_t server_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t write_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t wake_count;
+
+static jobproto_parser parser;
+static uint8_t seq;
+static int failures;
+
+static void check(bool ok, const char *what, int line)
+{
+    if (!ok) {
+        fprintf(stderr, "line %d: check failed: %s\n", line, what);
+        failures++;
+    }
+}
+
+static uint32_t millis(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Server on the master side, the backend of jobserver_sim with the parts computed one after the other               */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static int pty_read(void *ctx, uint8_t *buf, size_t len)
+{
+    struct pollfd pfd = {master_fd, POLLIN, 0};
+    if (poll(&pfd, 1, 10) <= 0) {
+        return 0;
+    }
+    ssize_t n = read(master_fd, buf, len);
+    return (n > 0) ? (int)n : 0;
+}
+
+static int pty_write(void *ctx, const uint8_t *buf, size_t len)
+{
+    size_t done = 0;
+    pthread_mutex_lock(&write_mutex);
+    while (done < len) {
+        ssize_t n = write(master_fd, &buf[done], len - done);
+        if (n <= 0) {
+            break;
+        }
+        done += n;
+    }
+    pthread_mutex_unlock(&write_mutex);
+    return (int)done;
+}
+
+static uint32_t server_millis(void *ctx) { return millis(); }
+static void server_lock(void *ctx) { pthread_mutex_lock(&server_mutex); }
+static void server_unlock(void *ctx) { pthread_mutex_unlock(&server_mutex); }
+
+static bool method_valid(void *ctx, uint8_t method, uint8_t cores, uint32_t digits)
+{
+    return method < bsplit_series_count;
+}
+
+static void wake_worker(void *ctx)
+{
+    pthread_mutex_lock(&wake_mutex);
+    wake_count++;
+    pthread_cond_signal(&wake_cond);
+    pthread_mutex_unlock(&wake_mutex);
+}
+
+static const jobserver_ops server_ops = {
+    .read = pty_read,
+    .write = pty_write,
+    .millis = server_millis,
+    .lock = server_lock,
+    .unlock = server_unlock,
+    .method_valid = method_valid,
+    .wake = wake_worker,
+};
+
+static char *run_job(const jobserver_job *job)
+{
+    //same split and merge order as the firmware
+    const bsplit_series *series = bsplit_series_list[job->method];
+    uint32_t terms = bsplit_terms(series, job->digits);
+    bsplit_pqt *parts = calloc(job->cores, sizeof(bsplit_pqt));
+    bool ok = parts != NULL;
+
+    for (uint32_t i = 0; ok && i < job->cores; i++) {
+        bsplit_pqt_init(&parts[i]);
+        ok = bsplit_part(series, terms, i, job->cores, &parts[i]);
+    }
+    for (uint32_t i = 1; ok && i < job->cores; i++) {
+        ok = bsplit_merge(series, &parts[0], &parts[i], i + 1 < job->cores);
+    }
+    bigint_t fixed;
+    bigint_init(&fixed);
+    ok = ok && bsplit_result(series, &parts[0], job->digits, &fixed);
+    for (uint32_t i = 0; parts != NULL && i < job->cores; i++) {
+        bsplit_pqt_free(&parts[i]);
+    }
+    free(parts);
+
+    char *text = NULL;
+    if (ok) {
+        size_t buflen = job->digits + 32;
+        text = malloc(buflen);
+        size_t len = (text != NULL) ? bsplit_format(&fixed, job->digits, text, buflen) : 0;
+        if (len > job->digits) {
+            memmove(text, &text[len - job->digits], job->digits);
+        } else {
+            free(text);
+            text = NULL;
+        }
+    }
+    bigint_free(&fixed);
+    return text;
+}
+
+static void *worker_thread(void *param)
+{
+    jobserver_job job;
+    while (!stop) {
+        pthread_mutex_lock(&wake_mutex);
+        while (wake_count == 0 && !stop) {
+            pthread_cond_wait(&wake_cond, &wake_mutex);
+        }
+        wake_count = 0;
+        pthread_mutex_unlock(&wake_mutex);
+
+        while (jobserver_next_job(&server, &job)) {
+            jobserver_job_done(&server, job.id, run_job(&job), job.digits);
+        }
+    }
+    return NULL;
+}
+
+static void *server_thread(void *param)
+{
+    while (!stop) {
+        jobserver_poll(&server);
+    }
+    return NULL;
+}
+
+static void server_log(const char *text)
+{
+    //log output of the board between the frames
+    pty_write(NULL, (const uint8_t *)text, strlen(text));
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Host on the slave side                                                                                            */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static bool send_raw(const uint8_t *buf, size_t len)
+{
+    return write(slave_fd, buf, len) == (ssize_t)len;
+}
+
+static bool send_frame(uint8_t type, uint8_t frame_seq, const uint8_t *payload, uint16_t len)
+{
+    uint8_t buf[JOBPROTO_MAX_FRAME];
+    return send_raw(buf, jobproto_encode(type, frame_seq, payload, len, buf));
+}
+
+static const jobproto_frame *next_frame(uint8_t frame_seq)
+{
+    uint32_t deadline = millis() + REPLY_TIMEOUT_MS;
+    uint8_t byte;
+    while ((int32_t)(deadline - millis()) > 0) {
+        struct pollfd pfd = {slave_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 10) <= 0) {
+            continue;
+        }
+        if (read(slave_fd, &byte, 1) != 1) {
+            return NULL;
+        }
+        if (jobproto_parse(&parser, byte) && parser.frame.seq == frame_seq) {
+            return &parser.frame;
+        }
+    }
+    return NULL;
+}
+
+static const jobproto_frame *request(uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    uint8_t request_seq = ++seq;
+    return send_frame(type, request_seq, payload, len) ? next_frame(request_seq) : NULL;
+}
+
+static int submit(uint8_t constant, uint32_t digits, uint8_t cores)
+{
+    uint8_t payload[6] = {constant, cores};
+    jobproto_put_u32(&payload[2], digits);
+    const jobproto_frame *f = request(JOBPROTO_SUBMIT, payload, sizeof(payload));
+    if (f == NULL || f->type != JOBPROTO_ACCEPTED || f->len != 3) {
+        return -1;
+    }
+    return jobproto_get_u16(f->payload);
+}
+
+static int job_state(uint8_t type, uint16_t job)
+{
+    uint8_t payload[2];
+    jobproto_put_u16(payload, job);
+    const jobproto_frame *f = request(type, payload, sizeof(payload));
+    if (f == NULL || f->type != JOBPROTO_STATE || f->len != 12) {
+        return -1;
+    }
+    return f->payload[2];
+}
+
+static int wait_job(uint16_t job)
+{
+    uint32_t deadline = millis() + JOB_TIMEOUT_MS;
+    int state;
+    while ((state = job_state(JOBPROTO_STATUS, job)) == JOBSERVER_QUEUED || state == JOBSERVER_RUNNING) {
+        if ((int32_t)(deadline - millis()) <= 0) {
+            break;
+        }
+        usleep(10000);
+    }
+    return state;
+}
+
+static bool stream(uint16_t job, uint32_t first, uint32_t count, char *digits)
+{
+    //credits are returned one frame at a time, so the server has to stop at the window
+    uint8_t payload[12];
+    uint8_t stream_seq = ++seq;
+    jobproto_put_u16(&payload[0], job);
+    jobproto_put_u32(&payload[2], first);
+    jobproto_put_u32(&payload[6], count);
+    jobproto_put_u16(&payload[10], TEST_WINDOW);
+    if (!send_frame(JOBPROTO_STREAM, stream_seq, payload, sizeof(payload))) {
+        return false;
+    }
+    uint32_t expected = first;
+    const jobproto_frame *f;
+    while ((f = next_frame(stream_seq)) != NULL) {
+        if (f->type == JOBPROTO_END) {
+            return f->len == 6 && jobproto_get_u32(&f->payload[2]) == expected && expected == first + count;
+        }
+        if (f->type != JOBPROTO_DATA || f->len < 8) {
+            return false;
+        }
+        uint32_t offset = jobproto_get_u32(&f->payload[2]);
+        uint16_t n = jobproto_get_u16(&f->payload[6]);
+        if (offset != expected || f->len != 8 + (n + 1) / 2 || offset + n > first + count) {
+            return false;
+        }
+        for (uint16_t i = 0; i < n; i++) {
+            uint8_t b = f->payload[8 + i / 2];
+            digits[offset - first + i] = '0' + ((i & 1) ? (b & 0x0F) : (b >> 4));
+        }
+        expected += n;
+
+        uint8_t credit[4];
+        jobproto_put_u16(&credit[0], job);
+        jobproto_put_u16(&credit[2], 1);
+        send_frame(JOBPROTO_CREDIT, ++seq, credit, sizeof(credit));
+    }
+    return false;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static void test_ping(void)
+{
+    server_log("I (10) JOBSERVER: a log line before the first frame\n");
+    const jobproto_frame *f = request(JOBPROTO_PING, NULL, 0);
+    CHECK(f != NULL && f->type == JOBPROTO_PONG && f->len == 6);
+    if (f != NULL && f->len == 6) {
+        CHECK(f->payload[0] == JOBPROTO_VERSION);
+        CHECK(f->payload[1] == JOBSERVER_MAX_JOBS);
+    }
+}
+
+static void test_broken_frames(void)
+{
+    //a frame with a flipped CRC bit and a truncated one are dropped, the next request is answered
+    uint8_t buf[JOBPROTO_MAX_FRAME];
+    size_t len = jobproto_encode(JOBPROTO_PING, ++seq, NULL, 0, buf);
+    uint32_t crc_errors = server.parser.crc_errors;
+    buf[len - 1] ^= 0x01;
+    CHECK(send_raw(buf, len));
+    len = jobproto_encode(JOBPROTO_PING, ++seq, NULL, 0, buf);
+    CHECK(send_raw(buf, 3));
+    CHECK(send_raw((const uint8_t *)"text\r\n", 6));
+
+    const jobproto_frame *f = request(JOBPROTO_PING, NULL, 0);
+    CHECK(f != NULL && f->type == JOBPROTO_PONG);
+    //the truncated frame takes "text" as seq and length, which is too long for a frame
+    CHECK(server.parser.crc_errors == crc_errors + 2);
+}
+
+static void test_errors(void)
+{
+    uint8_t payload[6] = {(uint8_t)bsplit_series_count, 1};
+    jobproto_put_u32(&payload[2], 100);
+    const jobproto_frame *f = request(JOBPROTO_SUBMIT, payload, sizeof(payload));
+    CHECK(f != NULL && f->type == JOBPROTO_ERROR && f->len == 2 && f->payload[1] == JOBPROTO_ERR_METHOD);
+
+    f = request(JOBPROTO_SUBMIT, payload, 3);
+    CHECK(f != NULL && f->type == JOBPROTO_ERROR && f->len == 2 && f->payload[1] == JOBPROTO_ERR_LENGTH);
+
+    CHECK(job_state(JOBPROTO_STATUS, 0xFFFF) == -1);
+    CHECK(job_state(JOBPROTO_CANCEL, 0xFFFF) == -1);
+}
+
+static void test_digits(void)
+{
+    //pi with 1, 2 and 3 parts, streamed with log lines in between
+    static char digits[3][TEST_DIGITS + 1];
+    for (uint8_t cores = 1; cores <= 3; cores++) {
+        char *d = digits[cores - 1];
+        int job = submit(0, TEST_DIGITS, cores);
+        CHECK(job >= 0);
+        if (job < 0) {
+            continue;
+        }
+        server_log("I (20) JOBSERVER: job submitted\n");
+        CHECK(wait_job(job) == JOBSERVER_DONE);
+        server_log("I (30) JOBSERVER: job done\n");
+        CHECK(stream(job, 0, TEST_DIGITS, d));
+        d[TEST_DIGITS] = '\0';
+        CHECK(strncmp(d, pi_prefix, strlen(pi_prefix)) == 0);
+    }
+    CHECK(memcmp(digits[0], digits[1], TEST_DIGITS) == 0);
+    CHECK(memcmp(digits[0], digits[2], TEST_DIGITS) == 0);
+
+    //a window inside the result
+    int job = submit(0, TEST_DIGITS, 2);
+    char part[700];
+    CHECK(job >= 0 && wait_job(job) == JOBSERVER_DONE);
+    CHECK(stream(job, 1000, sizeof(part), part));
+    CHECK(memcmp(part, &digits[0][1000], sizeof(part)) == 0);
+}
+
+static void test_cancel(void)
+{
+    //a cancelled job keeps its state whatever the worker was doing
+    int job = submit(0, 5 * TEST_DIGITS, 1);
+    CHECK(job >= 0);
+    if (job >= 0) {
+        CHECK(job_state(JOBPROTO_CANCEL, job) == JOBSERVER_CANCELLED);
+        CHECK(wait_job(job) == JOBSERVER_CANCELLED);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (openpty(&master_fd, &slave_fd, NULL, NULL, NULL) != 0) {
+        perror("openpty");
+        return 1;
+    }
+    struct termios tio;
+    tcgetattr(slave_fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave_fd, TCSANOW, &tio);
+    jobproto_parser_init(&parser);
+
+    jobserver_init(&server, &server_ops, NULL);
+    pthread_t server_hndl, worker_hndl;
+    pthread_create(&server_hndl, NULL, server_thread, NULL);
+    pthread_create(&worker_hndl, NULL, worker_thread, NULL);
+
+    test_ping();
+    test_broken_frames();
+    test_errors();
+    test_digits();
+    test_cancel();
+
+    stop = true;
+    wake_worker(NULL);
+    pthread_join(server_hndl, NULL);
+    pthread_join(worker_hndl, NULL);
+
+    printf("jobserver pty test: %s (%d failed checks)\n", failures ? "FAILED" : "passed", failures);
+    return failures ? 1 : 0;
+}
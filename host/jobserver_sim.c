@@ -0,0 +1,249 @@
+/********************************************************************************************* */
+//    Linux build of the job server (components/jobserver) on a pseudo-terminal
+//    The protocol layer is the one of the firmware, jobs are split over pthreads instead of pinned tasks.
+//    Drive it with host/jobclient on the printed pty.
+//
+//    usage: jobserver_sim [-l] [-L link]
+//           -l       writes a log line into the stream every second, like ESP_LOG on the console UART
+//           -L link  creates a symlink to the pty
+/********************************************************************************************* */
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bsplit.h"
+#include "jobserver.h"
+
+typedef struct {
+    const bsplit_series *series;
+    uint32_t terms;
+    uint32_t part;
+    uint32_t parts;
+    bsplit_pqt sum;
+    bool ok;
+    pthread_t thread;
+} job_part;
+
+static jobserver server;
+static int master_fd;
+static pthread_mutex_t server_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t write_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t wake_count;
+
+static int pty_read(void *ctx, uint8_t *buf, size_t len)
+{
+    struct pollfd pfd = {master_fd, POLLIN, 0};
+    if (poll(&pfd, 1, 10) <= 0) {
+        return 0;
+    }
+    ssize_t n = read(master_fd, buf, len);
+    return (n > 0) ? (int)n : 0;
+}
+
+static int pty_write(void *ctx, const uint8_t *buf, size_t len)
+{
+    //whole frames, so that log lines of the other thread never end up inside a frame
+    size_t done = 0;
+    pthread_mutex_lock(&write_mutex);
+    while (done < len) {
+        ssize_t n = write(master_fd, &buf[done], len - done);
+        if (n <= 0) {
+            break;
+        }
+        done += n;
+    }
+    pthread_mutex_unlock(&write_mutex);
+    return (int)done;
+}
+
+static uint32_t sim_millis(void *ctx)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static void sim_lock(void *ctx)
+{
+    pthread_mutex_lock(&server_mutex);
+}
+
+static void sim_unlock(void *ctx)
+{
+    pthread_mutex_unlock(&server_mutex);
+}
+
+static bool method_valid(void *ctx, uint8_t method, uint8_t cores, uint32_t digits)
+{
+    return method < bsplit_series_count;
+}
+
+static void wake_worker(void *ctx)
+{
+    pthread_mutex_lock(&wake_mutex);
+    wake_count++;
+    pthread_cond_signal(&wake_cond);
+    pthread_mutex_unlock(&wake_mutex);
+}
+
+static const jobserver_ops server_ops = {
+    .read = pty_read,
+    .write = pty_write,
+    .millis = sim_millis,
+    .lock = sim_lock,
+    .unlock = sim_unlock,
+    .method_valid = method_valid,
+    .wake = wake_worker,
+};
+
+static void *part_thread(void *param)
+{
+    job_part *p = param;
+    p->ok = bsplit_part(p->series, p->terms, p->part, p->parts, &p->sum);
+    return NULL;
+}
+
+static char *run_job(const jobserver_job *job)
+{
+    //same split and merge order as the firmware
+    const bsplit_series *series = bsplit_series_list[job->method];
+    uint32_t parts = job->cores;
+    uint32_t terms = bsplit_terms(series, job->digits);
+    job_part *p = calloc(parts, sizeof(job_part));
+    bool ok = p != NULL;
+
+    for (uint32_t i = 0; ok && i < parts; i++) {
+        p[i].series = series;
+        p[i].terms = terms;
+        p[i].part = i;
+        p[i].parts = parts;
+        bsplit_pqt_init(&p[i].sum);
+        pthread_create(&p[i].thread, NULL, part_thread, &p[i]);
+    }
+    for (uint32_t i = 0; ok && i < parts; i++) {
+        pthread_join(p[i].thread, NULL);
+    }
+    for (uint32_t i = 0; ok && i < parts; i++) {
+        ok = p[i].ok;
+    }
+    for (uint32_t i = 1; ok && i < parts; i++) {
+        ok = bsplit_merge(series, &p[0].sum, &p[i].sum, i + 1 < parts);
+    }
+
+    bigint_t fixed;
+    bigint_init(&fixed);
+    char *text = NULL;
+    ok = ok && !jobserver_job_cancelled(&server, job->id) && bsplit_result(series, &p[0].sum, job->digits, &fixed);
+    for (uint32_t i = 0; p != NULL && i < parts; i++) {
+        bsplit_pqt_free(&p[i].sum);
+    }
+    free(p);
+    if (ok) {
+        size_t buflen = job->digits + 32;
+        text = malloc(buflen);
+        size_t len = (text != NULL) ? bsplit_format(&fixed, job->digits, text, buflen) : 0;
+        if (len > job->digits) {
+            memmove(text, &text[len - job->digits], job->digits);
+        } else {
+            free(text);
+            text = NULL;
+        }
+    }
+    bigint_free(&fixed);
+    return text;
+}
+
+static void *worker_thread(void *param)
+{
+    jobserver_job job;
+    for (;;) {
+        pthread_mutex_lock(&wake_mutex);
+        while (wake_count == 0) {
+            pthread_cond_wait(&wake_cond, &wake_mutex);
+        }
+        wake_count = 0;
+        pthread_mutex_unlock(&wake_mutex);
+
+        while (jobserver_next_job(&server, &job)) {
+            fprintf(stderr, "job %u: %u digits of %s, %u parts\n", job.id, job.digits, bsplit_series_list[job.method]->name, job.cores);
+            jobserver_job_done(&server, job.id, run_job(&job), job.digits);
+        }
+    }
+    return NULL;
+}
+
+static void *log_thread(void *param)
+{
+    char line[80];
+    for (uint32_t n = 0;; n++) {
+        sleep(1);
+        int len = snprintf(line, sizeof(line), "I (%u) JOBSERVER: log line %u between the frames\n", sim_millis(NULL), n);
+        pty_write(NULL, (const uint8_t *)line, len);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    bool logs = false;
+    const char *link = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "lL:")) != -1) {
+        switch (opt) {
+        case 'l':
+            logs = true;
+            break;
+        case 'L':
+            link = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-l] [-L link]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master_fd < 0 || grantpt(master_fd) != 0 || unlockpt(master_fd) != 0) {
+        perror("pty");
+        return 1;
+    }
+    //raw mode on the slave side, the open slave also keeps the master readable between clients
+    const char *slave = ptsname(master_fd);
+    int slave_fd = open(slave, O_RDWR | O_NOCTTY);
+    struct termios tio;
+    if (slave_fd < 0 || tcgetattr(slave_fd, &tio) != 0) {
+        perror(slave);
+        return 1;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(slave_fd, TCSANOW, &tio);
+    if (link != NULL) {
+        unlink(link);
+        if (symlink(slave, link) != 0) {
+            perror(link);
+        }
+    }
+    printf("%s\n", slave);
+    fflush(stdout);
+
+    jobserver_init(&server, &server_ops, NULL);
+    pthread_t worker, logger;
+    pthread_create(&worker, NULL, worker_thread, NULL);
+    if (logs) {
+        pthread_create(&logger, NULL, log_thread, NULL);
+    }
+    for (;;) {
+        jobserver_poll(&server);
+    }
+    return 0;
+}
@@ -0,0 +1,382 @@
+/********************************************************************************************* */
+//    Microbenchmarks of the LCD rendering pipeline (components/eduboard2/eduboardLCD)
+//    The unchanged lcdDriver.c, ili9488.c and fontx.c run against a mock SPI bus which only counts
+//    bytes and transactions. Every stage is reported in ns per pixel, the DisplayTask frames of the
+//    firmware are replayed for the SPI bytes per frame and their wire time at the configured clock.
+//
+//    usage: lcd_bench [-f fontdir] [-n frames] [-r rounds]
+//           fontdir holds the FONTX files of data/fonts, rounds are repeated and the fastest one counts
+/********************************************************************************************* */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "eduboard2.h"
+#include <driver/gpio.h>
+#include "eduboardLCD/src/ili9488.h"
+#include "calcpi.h"
+
+#ifndef LCD_BENCH_FONT_DIR
+#define LCD_BENCH_FONT_DIR "data/fonts"
+#endif
+
+#define DEFAULT_FRAMES 20
+#define DEFAULT_ROUNDS 5
+#define AREA_SIZE 16                    // DIFFUPDATE_AREAWIDTH/HEIGHT of lcdDriver.c
+
+// diffupdate internals of lcdDriver.c, not part of lcdDriver.h
+void diffupdate_createDiffMap();
+void diffupdate_updateDiffLCD();
+void copyVScreenArea(uint16_t x1, uint16_t y1, uint16_t sizex, uint16_t sizey, uint16_t *buffer);
+
+FontxFile fx16M[2];
+FontxFile fx24M[2];
+FontxFile fx32M[2];
+
+typedef struct {
+    uint64_t bytes;
+    uint64_t transactions;
+    uint64_t cmd_transactions;          // sent with DC low
+    uint64_t pixel_bytes;               // RGB666 data transfers of more than one byte
+    uint32_t frequency;
+} spi_counters;
+
+static spi_counters spi;
+static int dc_level;
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   Mock of the ESP-IDF and FreeRTOS functions the LCD driver calls, single threaded without a scheduler              */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+void gpspi_init(spi_device_handle_t* handle, int pinMOSI, int pinMISO, int pinSCK, int pinCS, uint32_t frequency, bool halfduplex)
+{
+    *handle = NULL;
+    spi.frequency = frequency;
+}
+
+bool gpspi_write_data(spi_device_handle_t* handle, uint8_t* data, uint32_t len)
+{
+    //the data is not looked at, the compiler must still assume it is read
+    __asm__ volatile("" : : "r"(data) : "memory");
+    spi.bytes += len;
+    spi.transactions++;
+    if (dc_level == 0) {
+        spi.cmd_transactions++;
+    } else if (len > 1) {
+        spi.pixel_bytes += len;
+    }
+    return true;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio) { return ESP_OK; }
+esp_err_t gpio_set_direction(gpio_num_t gpio, gpio_mode_t mode) { return ESP_OK; }
+int gpio_get_level(gpio_num_t gpio) { return 0; }
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    if (gpio == GPIO_LCD_DC) {
+        dc_level = level;
+    }
+    return ESP_OK;
+}
+
+void vTaskDelay(TickType_t ticks) {}
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return (SemaphoreHandle_t)&spi; }
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) { return pdTRUE; }
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) { return pdTRUE; }
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void print_stage(const char *stage, uint64_t pixels, double ns)
+{
+    printf("%-44s %10llu %12.0lf %10.3lf\n", stage, (unsigned long long)pixels, ns, ns / pixels);
+}
+
+static void fonts_init(const char *dir)
+{
+    //same files as eduboard2_spiffs.c, read from the data directory instead of /spiffs
+    static char path16[256], path24[256], path32[256];
+    snprintf(path16, sizeof(path16), "%s/ILMH16XB.FNT", dir);
+    snprintf(path24, sizeof(path24), "%s/ILMH24XB.FNT", dir);
+    snprintf(path32, sizeof(path32), "%s/ILMH32XB.FNT", dir);
+    InitFontx(fx16M, path16, "");
+    InitFontx(fx24M, path24, "");
+    InitFontx(fx32M, path32, "");
+}
+
+static void screen_sync(void)
+{
+    //makes the shadow screen equal to the drawn one and clears the update map, the SPI traffic is not counted
+    diffupdate_createDiffMap();
+    diffupdate_updateDiffLCD();
+    memset(&spi, 0, offsetof(spi_counters, frequency));
+}
+
+static void bench_diffmap(int rounds)
+{
+    uint64_t pixels = (uint64_t)CONFIG_WIDTH * CONFIG_HEIGHT;
+    double best_same = 1e30, best_changed = 1e30;
+
+    for (int r = 0; r < rounds; r++) {
+        lcdFillScreen(r % 2 ? WHITE : BLACK);
+        double start = now_ns();
+        diffupdate_createDiffMap();
+        double changed = now_ns() - start;
+        screen_sync();
+
+        start = now_ns();
+        diffupdate_createDiffMap();
+        double same = now_ns() - start;
+
+        best_same = same < best_same ? same : best_same;
+        best_changed = changed < best_changed ? changed : best_changed;
+    }
+    print_stage("diffupdate_createDiffMap, unchanged", pixels, best_same);
+    print_stage("diffupdate_createDiffMap, all areas changed", pixels, best_changed);
+}
+
+static void bench_copy_area(int rounds)
+{
+    uint16_t buffer[AREA_SIZE * AREA_SIZE];
+    uint64_t pixels = (uint64_t)CONFIG_WIDTH * CONFIG_HEIGHT;
+    double best = 1e30;
+
+    for (int r = 0; r < rounds; r++) {
+        double start = now_ns();
+        for (int y = 0; y < CONFIG_HEIGHT; y += AREA_SIZE) {
+            for (int x = 0; x < CONFIG_WIDTH; x += AREA_SIZE) {
+                copyVScreenArea(x, y, AREA_SIZE, AREA_SIZE, buffer);
+                __asm__ volatile("" : : "r"(buffer) : "memory");
+            }
+        }
+        double ns = now_ns() - start;
+        best = ns < best ? ns : best;
+    }
+    print_stage("copyVScreenArea, 16x16 areas", pixels, best);
+}
+
+static void bench_write_colors(int rounds)
+{
+    //one diffupdate area and the longest transfer ili9488_spi_write_colors accepts
+    static const uint32_t lengths[] = {AREA_SIZE * AREA_SIZE, 1024};
+    uint16_t colors[1024];
+    int repeat = 2000;
+
+    for (int i = 0; i < 1024; i++) {
+        colors[i] = (uint16_t)(i * 40503u);
+    }
+    for (int l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        double best = 1e30;
+        for (int r = 0; r < rounds; r++) {
+            double start = now_ns();
+            for (int i = 0; i < repeat; i++) {
+                ili9488_spi_write_colors(colors, lengths[l]);
+            }
+            double ns = now_ns() - start;
+            best = ns < best ? ns : best;
+        }
+        char stage[64];
+        snprintf(stage, sizeof(stage), "ili9488_spi_write_colors, %u pixels", lengths[l]);
+        print_stage(stage, (uint64_t)lengths[l] * repeat, best);
+    }
+}
+
+static void bench_text(int rounds)
+{
+    static FontxFile *fonts[] = {fx16M, fx24M, fx32M};
+    static const char *names[] = {"fx16M", "fx24M", "fx32M"};
+    char line[] = "Aktueller Wert:  3.14159265358979311600";
+    int repeat = 50;
+
+    for (int f = 0; f < sizeof(fonts) / sizeof(fonts[0]); f++) {
+        //the first call opens the font file and fills in the glyph size
+        lcdDrawChar(fonts[f], 10, 40, 'A', WHITE);
+        uint64_t glyph = (uint64_t)fonts[f][0].w * fonts[f][0].h;
+        double best_char = 1e30, best_string = 1e30;
+
+        for (int r = 0; r < rounds; r++) {
+            double start = now_ns();
+            for (int i = 0; i < repeat; i++) {
+                lcdDrawChar(fonts[f], 10, 40, '0' + i % 10, WHITE);
+            }
+            double ns = now_ns() - start;
+            best_char = ns < best_char ? ns : best_char;
+
+            start = now_ns();
+            for (int i = 0; i < repeat; i++) {
+                lcdDrawString(fonts[f], 0, 40, line, WHITE);
+            }
+            ns = now_ns() - start;
+            best_string = ns < best_string ? ns : best_string;
+        }
+        char stage[64];
+        snprintf(stage, sizeof(stage), "lcdDrawChar, %s", names[f]);
+        print_stage(stage, glyph * repeat, best_char);
+        snprintf(stage, sizeof(stage), "lcdDrawString, %s, %zu chars", names[f], strlen(line));
+        print_stage(stage, glyph * strlen(line) * repeat, best_string);
+    }
+}
+
+static void bench_fill(int rounds)
+{
+    uint64_t screen = (uint64_t)CONFIG_WIDTH * CONFIG_HEIGHT;
+    double best_rect = 1e30, best_screen = 1e30;
+    int repeat = 10;
+
+    for (int r = 0; r < rounds; r++) {
+        double start = now_ns();
+        for (int i = 0; i < repeat; i++) {
+            lcdDrawFillRect(100, 100, 200, 200, i % 2 ? RED : BLUE);
+        }
+        double ns = now_ns() - start;
+        best_rect = ns < best_rect ? ns : best_rect;
+
+        start = now_ns();
+        for (int i = 0; i < repeat; i++) {
+            lcdFillScreen(i % 2 ? RED : BLUE);
+        }
+        ns = now_ns() - start;
+        best_screen = ns < best_screen ? ns : best_screen;
+    }
+    // lcdDrawFillRect leaves out x2 and y2
+    print_stage("lcdDrawFillRect, 100x100", 100 * 100 * repeat, best_rect);
+    print_stage("lcdFillScreen", screen * repeat, best_screen);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------*/
+/*   DisplayTask frames, same layout and strings as src/main.c                                                         */
+/*---------------------------------------------------------------------------------------------------------------------*/
+
+static void draw_method(int m, int frame, int y)
+{
+    const calc_method *method = calc_methods[m];
+    char letter = calc_method_letter(method->id);
+    char header_string[60], status_string[60], prec_reached_string[80], curr_value_string[60], curr_time_string[80];
+    double elapsed_ms = frame * 500.0 + m * 17.0;
+
+    //the first method keeps running, the others have reached the precision early on
+    sprintf(header_string, "Methode %c (%s)", letter, method->name);
+    lcdDrawString(fx24M, 10, y, header_string, m == 0 ? BLUE : GRAY);
+    if (m == 0) {
+        sprintf(status_string, "%c auf Kern %i: %.0lf it/s, CPU %.0lf it/s", letter, 1, 1.9e6 + frame * 731, 2.0e6 + frame * 977);
+        lcdDrawString(fx16M, 10, y + 15, status_string, GREEN);
+        sprintf(prec_reached_string, "Der Wert ist noch zu ungenau.");
+        lcdDrawString(fx16M, 10, y + 30, prec_reached_string, RED);
+    } else {
+        sprintf(status_string, "Methode %c inaktiv (Kern %i)", letter, m % 2);
+        lcdDrawString(fx16M, 10, y + 15, status_string, GRAY);
+        sprintf(prec_reached_string, "Genauigkeit nach %.3lf ms erreicht (CPU %.3lf ms)", 0.052 * m, 0.049 * m);
+        lcdDrawString(fx16M, 10, y + 30, prec_reached_string, GREEN);
+        elapsed_ms = 0.052 * m;
+    }
+    sprintf(curr_value_string, "Aktueller Wert:  %.20lf", m == 0 ? 3.14159 + 1.0 / (frame + 2) : 3.141592653589793);
+    sprintf(curr_time_string, "Zeit %c: %.3lf ms, CPU %.3lf ms, verdraengt %.3lf ms", letter, elapsed_ms, elapsed_ms * 0.97, elapsed_ms * 0.03);
+    lcdDrawString(fx16M, 10, y + 45, curr_value_string, WHITE);
+    lcdDrawString(fx16M, 10, y + 60, curr_time_string, WHITE);
+}
+
+static void draw_frame(int frame)
+{
+    char cache_string[60];
+
+    lcdFillScreen(BLACK);
+    lcdDrawString(fx32M, 10, 30, "ESP32 Pi Calcualtion", GREEN);
+    lcdDrawString(fx16M, 10, 50, "by Nathanael", GREEN);
+    sprintf(cache_string, "Cache: %u Treffer, %u Fehlschlaege", frame / 10, 1);
+    lcdDrawString(fx16M, 200, 50, cache_string, GRAY);
+    for (int m = 0; m < calc_method_count; m++) {
+        draw_method(m, frame, 80 + m * 85);
+    }
+}
+
+static void bench_frames(int frames)
+{
+    double draw_ns = 0, update_ns = 0;
+    spi_counters total = {0};
+
+    printf("\n%-6s %12s %12s %10s %12s %10s %12s\n", "Frame", "draw ns", "update ns", "SPI txn", "SPI bytes", "cmd txn", "wire ms");
+    for (int f = 0; f < frames; f++) {
+        memset(&spi, 0, offsetof(spi_counters, frequency));
+        double start = now_ns();
+        draw_frame(f);
+        double drawn = now_ns();
+        lcdUpdateVScreen();
+        double updated = now_ns();
+
+        double wire_ms = spi.bytes * 8e3 / spi.frequency;
+        printf("%-6i %12.0lf %12.0lf %10llu %12llu %10llu %12.3lf\n", f, drawn - start, updated - drawn,
+               (unsigned long long)spi.transactions, (unsigned long long)spi.bytes, (unsigned long long)spi.cmd_transactions, wire_ms);
+        //the first frame paints the whole screen, the rest is the steady state of the firmware
+        if (f > 0) {
+            draw_ns += drawn - start;
+            update_ns += updated - drawn;
+            total.bytes += spi.bytes;
+            total.transactions += spi.transactions;
+            total.cmd_transactions += spi.cmd_transactions;
+            total.pixel_bytes += spi.pixel_bytes;
+        }
+    }
+    if (frames > 1) {
+        int n = frames - 1;
+        uint64_t pixels = (uint64_t)CONFIG_WIDTH * CONFIG_HEIGHT;
+        printf("\nSteady frames (without the first): draw %.3lf ms (%.3lf ns/pixel), update %.3lf ms (%.3lf ns/pixel)\n",
+               draw_ns / n / 1e6, draw_ns / n / pixels, update_ns / n / 1e6, update_ns / n / pixels);
+        printf("SPI per frame: %.0lf bytes (%.0lf pixel data, %.1lf%% of a full screen), %.0lf transactions (%.0lf commands)\n",
+               (double)total.bytes / n, (double)total.pixel_bytes / n, 100.0 * total.pixel_bytes / n / (pixels * 3),
+               (double)total.transactions / n, (double)total.cmd_transactions / n);
+        printf("Wire time at %.0lf MHz: %.3lf ms per frame, without the per transaction overhead\n",
+               spi.frequency / 1e6, total.bytes * 8e3 / spi.frequency / n);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *font_dir = LCD_BENCH_FONT_DIR;
+    int frames = DEFAULT_FRAMES, rounds = DEFAULT_ROUNDS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:n:r:")) != -1) {
+        switch (opt) {
+        case 'f': font_dir = optarg; break;
+        case 'n': frames = atoi(optarg); break;
+        case 'r': rounds = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-f fontdir] [-n frames] [-r rounds]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (rounds < 1) {
+        rounds = 1;
+    }
+
+    //the same setup as eduboard2_init, rotated like the board
+    fonts_init(font_dir);
+    lcd_init();
+    lcdSetupVScreen(rot_90);
+    if (!OpenFontx(fx16M) || !OpenFontx(fx24M) || !OpenFontx(fx32M)) {
+        fprintf(stderr, "Fonts not found in %s (-f)\n", font_dir);
+        return 1;
+    }
+    screen_sync();
+
+    printf("%-44s %10s %12s %10s\n", "Stage", "pixels", "ns", "ns/pixel");
+    bench_diffmap(rounds);
+    bench_copy_area(rounds);
+    bench_write_colors(rounds);
+    bench_text(rounds);
+    bench_fill(rounds);
+
+    screen_sync();
+    bench_frames(frames);
+    return 0;
+}
@@ -0,0 +1,114 @@
+/********************************************************************************************* */
+//    Parallel Madhava-Leibniz summation on the host, baseline for CPU scaling tests
+//    The sum is computed with 1..threads pinned threads, every run reduces in the same order.
+//
+//    usage: leibniz [-t threads] [-n terms] [-i]
+/********************************************************************************************* */
+#define _GNU_SOURCE
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "leibniz.h"
+
+typedef struct {
+    pthread_t thread;
+    uint64_t terms;
+    uint32_t worker;
+    uint32_t workers;
+    leibniz_split split;
+    leibniz_acc partial;
+} __attribute__((aligned(64))) worker;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *leibniz_thread(void *param)
+{
+    worker *w = param;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(w->worker % sysconf(_SC_NPROCESSORS_ONLN), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+    w->partial = leibniz_partial(w->terms, w->worker, w->workers, w->split);
+    return NULL;
+}
+
+static double run(worker *workers, uint32_t count, uint64_t terms, leibniz_split split, double *seconds)
+{
+    leibniz_acc partials[count];
+    double start = now_s();
+
+    for (uint32_t i = 0; i < count; i++) {
+        workers[i].terms = terms;
+        workers[i].worker = i;
+        workers[i].workers = count;
+        workers[i].split = split;
+        pthread_create(&workers[i].thread, NULL, leibniz_thread, &workers[i]);
+    }
+    //fixed reduction order, the result does not depend on which thread finished first
+    for (uint32_t i = 0; i < count; i++) {
+        pthread_join(workers[i].thread, NULL);
+        partials[i] = workers[i].partial;
+    }
+    double value = leibniz_reduce(partials, count);
+    *seconds = now_s() - start;
+    return value;
+}
+
+int main(int argc, char **argv)
+{
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t terms = 1000000000ULL;
+    leibniz_split split = LEIBNIZ_BLOCKED;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:n:i")) != -1) {
+        switch (opt) {
+        case 't':
+            threads = atol(optarg);
+            break;
+        case 'n':
+            terms = strtoull(optarg, NULL, 0);
+            break;
+        case 'i':
+            split = LEIBNIZ_INTERLEAVED;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t threads] [-n terms] [-i]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    worker *workers = aligned_alloc(64, sizeof(worker) * threads);
+    if (workers == NULL) {
+        return 1;
+    }
+
+    printf("%llu terms, %s, %d lanes\n", (unsigned long long)terms, leibniz_split_name(split), LEIBNIZ_LANES);
+    printf("threads,seconds,terms/s,speedup,value,error\n");
+    double base = 0;
+    for (long t = 1; t <= threads; t++) {
+        double seconds;
+        double value = run(workers, t, terms, split, &seconds);
+        if (t == 1) {
+            base = seconds;
+        }
+        printf("%ld,%.4f,%.0f,%.2f,%.17g,%.3e\n", t, seconds, terms / seconds, base / seconds, value, value - M_PI);
+    }
+
+    free(workers);
+    return 0;
+}
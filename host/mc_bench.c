@@ -0,0 +1,107 @@
+/********************************************************************************************* */
+//    Host benchmark for the Monte Carlo engine
+//    One pinned sampling thread per core, counters are reduced after the run.
+//
+//    usage: mc_bench [-t threads] [-s seconds]
+/********************************************************************************************* */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "montecarlo.h"
+
+#define MC_BATCH_BLOCKS 4096
+#define MC_SEED 0x5EED314159265ULL
+
+typedef struct {
+    pthread_t thread;
+    uint32_t core;
+    mc_sampler sampler;
+    double seconds;
+} __attribute__((aligned(64))) worker;
+
+static atomic_bool running = true;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *sampling_thread(void *param)
+{
+    worker *w = param;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(w->core, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+    double start = now_s();
+    while (atomic_load_explicit(&running, memory_order_relaxed)) {
+        mc_sample(&w->sampler, MC_BATCH_BLOCKS);
+    }
+    w->seconds = now_s() - start;
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    double seconds = 2.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:s:")) != -1) {
+        switch (opt) {
+        case 't':
+            threads = atol(optarg);
+            break;
+        case 's':
+            seconds = atof(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t threads] [-s seconds]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    worker *workers = aligned_alloc(64, sizeof(worker) * threads);
+    if (workers == NULL) {
+        return 1;
+    }
+    for (long i = 0; i < threads; i++) {
+        workers[i].core = i % cores;
+        mc_sampler_init(&workers[i].sampler, MC_SEED, i);
+        pthread_create(&workers[i].thread, NULL, sampling_thread, &workers[i]);
+    }
+
+    struct timespec ts = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&ts, NULL);
+    atomic_store(&running, false);
+
+    uint64_t hits = 0, samples = 0;
+    double total_rate = 0;
+    for (long i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        double rate = workers[i].sampler.samples / workers[i].seconds;
+        printf("Thread %2ld (core %2u): %14llu samples, %14.0f samples/s\n", i, workers[i].core,
+               (unsigned long long)workers[i].sampler.samples, rate);
+        hits += workers[i].sampler.hits;
+        samples += workers[i].sampler.samples;
+        total_rate += rate;
+    }
+    printf("Pi ~ %.10f after %llu samples, %.0f samples/s total\n", mc_estimate(hits, samples),
+           (unsigned long long)samples, total_rate);
+
+    free(workers);
+    return 0;
+}
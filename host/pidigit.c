@@ -0,0 +1,99 @@
+/********************************************************************************************* */
+//    Decimal digits of pi at a given position, the primes are split over pinned threads
+//
+//    usage: pidigit [-t threads] position
+/********************************************************************************************* */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pidigit.h"
+
+typedef struct {
+    pthread_t thread;
+    const pidigit_job *job;
+    uint32_t worker;
+    uint32_t workers;
+    double partial;
+} worker;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *pidigit_thread(void *param)
+{
+    worker *w = param;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(w->worker % sysconf(_SC_NPROCESSORS_ONLN), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+    w->partial = pidigit_partial(w->job, w->worker, w->workers);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:")) != -1) {
+        switch (opt) {
+        case 't':
+            threads = atol(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t threads] position\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc || threads < 1) {
+        fprintf(stderr, "usage: %s [-t threads] position\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t position = strtoul(argv[optind], NULL, 10);
+    double start = now_s();
+    pidigit_job job;
+    if (!pidigit_job_init(&job, position)) {
+        fprintf(stderr, "position %u not supported\n", position);
+        return 1;
+    }
+
+    worker *workers = calloc(threads, sizeof(worker));
+    if (workers == NULL) {
+        return 1;
+    }
+    for (long i = 0; i < threads; i++) {
+        workers[i].job = &job;
+        workers[i].worker = i;
+        workers[i].workers = threads;
+        pthread_create(&workers[i].thread, NULL, pidigit_thread, &workers[i]);
+    }
+    //fixed reduction order, the result does not depend on which thread finishes first
+    double sum = 0;
+    for (long i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        sum += workers[i].partial;
+    }
+
+    char digits[PIDIGIT_DIGITS + 1];
+    bool ok = pidigit_digits(&job, sum, digits);
+    double elapsed = now_s() - start;
+    if (ok) {
+        printf("Position %u: %s (%u terms, %u primes, %ld threads, %.3f s)\n", position, digits, job.terms,
+               job.prime_count, threads, elapsed);
+    }
+
+    free(workers);
+    pidigit_job_free(&job);
+    return ok ? 0 : 1;
+}
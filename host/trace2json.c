@@ -0,0 +1,346 @@
+/********************************************************************************************* */
+//    Converts an event trace of the firmware (components/trace) into a Chrome JSON trace
+//    The input is a console log with the hex dump between "----- trace -----" and "----- end -----"
+//    (the last dump of the log is taken) or the binary trace.bin from the flash. The output opens in
+//    ui.perfetto.dev and chrome://tracing: one track per core with the running tasks, one track per task
+//    with its calc state changes, LCD flushes, littlefs operations and button events.
+//
+//    usage: trace2json <log or trace.bin> [out.json]
+/********************************************************************************************* */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+typedef struct {
+    trace_event raw;
+    int64_t time_us;                    // unwrapped
+} event;
+
+typedef struct {
+    trace_header header;
+    trace_task tasks[TRACE_MAX_TASKS];
+    uint32_t counts[TRACE_MAX_CORES];
+    event events[TRACE_MAX_CORES][TRACE_RING_EVENTS];
+} trace;
+
+static const char *state_names[] = {"STOPPED", "STARTING", "RUNNING", "RESETTING", "STOPPING"};
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(len + 1);
+    if (data != NULL && fread(data, 1, len, f) != (size_t)len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    if (data != NULL) {
+        data[len] = '\0';
+        *size = len;
+    }
+    return data;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static uint8_t *decode_log(const char *text, size_t *size)
+{
+    //hex lines of the last dump in the log, log lines of other tasks in between are skipped
+    const char *start = NULL, *p = text;
+    while ((p = strstr(p, "----- trace -----")) != NULL) {
+        start = p;
+        p++;
+    }
+    if (start == NULL) {
+        return NULL;
+    }
+    start = strchr(start, '\n');
+    const char *end = start != NULL ? strstr(start, "----- end -----") : NULL;
+    if (end == NULL) {
+        return NULL;
+    }
+
+    uint8_t *data = malloc((end - start) / 2 + 1);
+    size_t n = 0;
+    for (const char *line = start + 1; line < end; ) {
+        const char *eol = memchr(line, '\n', end - line);
+        if (eol == NULL) {
+            eol = end;
+        }
+        const char *c = line;
+        while (c < eol && (*c == ' ' || *c == '\r')) c++;
+        size_t len = eol - c;
+        while (len > 0 && (c[len - 1] == '\r' || c[len - 1] == ' ')) len--;
+        bool hex = len > 0 && len % 2 == 0;
+        for (size_t i = 0; hex && i < len; i++) {
+            hex = hex_value(c[i]) >= 0;
+        }
+        for (size_t i = 0; hex && i < len; i += 2) {
+            data[n++] = (hex_value(c[i]) << 4) | hex_value(c[i + 1]);
+        }
+        line = eol + 1;
+    }
+    *size = n;
+    return data;
+}
+
+static bool parse(const uint8_t *data, size_t size, trace *t)
+{
+    size_t pos = 0;
+    if (size < sizeof(trace_header)) {
+        return false;
+    }
+    memcpy(&t->header, data, sizeof(trace_header));
+    pos += sizeof(trace_header);
+    if (memcmp(t->header.magic, TRACE_MAGIC, 4) != 0 || t->header.version != TRACE_VERSION ||
+        t->header.event_size != sizeof(trace_event) || t->header.cores > TRACE_MAX_CORES ||
+        t->header.task_count > TRACE_MAX_TASKS || t->header.ring_events > TRACE_RING_EVENTS) {
+        fprintf(stderr, "Not a trace of this version (magic, version, sizes)\n");
+        return false;
+    }
+    if (pos + t->header.task_count * sizeof(trace_task) > size) {
+        return false;
+    }
+    memcpy(t->tasks, &data[pos], t->header.task_count * sizeof(trace_task));
+    pos += t->header.task_count * sizeof(trace_task);
+
+    for (int core = 0; core < t->header.cores; core++) {
+        uint32_t count;
+        if (pos + sizeof(count) > size) {
+            return false;
+        }
+        memcpy(&count, &data[pos], sizeof(count));
+        pos += sizeof(count);
+        if (count > t->header.ring_events || pos + count * sizeof(trace_event) > size) {
+            return false;
+        }
+        t->counts[core] = count;
+        for (uint32_t i = 0; i < count; i++) {
+            memcpy(&t->events[core][i].raw, &data[pos], sizeof(trace_event));
+            pos += sizeof(trace_event);
+        }
+    }
+    return true;
+}
+
+static void unwrap(trace *t)
+{
+    //32 bit us wrap after 71 minutes, every core is unwrapped on its own and then moved next to core 0
+    int64_t reference = -1;
+    for (int core = 0; core < t->header.cores; core++) {
+        int64_t high = 0;
+        uint32_t previous = 0;
+        for (uint32_t i = 0; i < t->counts[core]; i++) {
+            uint32_t now = t->events[core][i].raw.time_us;
+            if (i > 0 && now < previous && previous - now > 0x80000000u) {
+                high += 0x100000000LL;
+            }
+            previous = now;
+            t->events[core][i].time_us = high + now;
+        }
+        if (t->counts[core] == 0) {
+            continue;
+        }
+        if (reference < 0) {
+            reference = t->events[core][0].time_us;
+            continue;
+        }
+        int64_t shift = 0;
+        while (t->events[core][0].time_us + shift - reference > 0x80000000LL) shift -= 0x100000000LL;
+        while (reference - (t->events[core][0].time_us + shift) > 0x80000000LL) shift += 0x100000000LL;
+        for (uint32_t i = 0; i < t->counts[core]; i++) {
+            t->events[core][i].time_us += shift;
+        }
+    }
+}
+
+static int task_index(const trace *t, uint32_t task)
+{
+    for (uint32_t i = 0; i < t->header.task_count; i++) {
+        if (t->tasks[i].task == task) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void task_name(const trace *t, uint32_t task, char *name, size_t len)
+{
+    int i = task_index(t, task);
+    if (task == 0) {
+        snprintf(name, len, "(scheduler)");
+    } else if (i >= 0) {
+        snprintf(name, len, "%.*s", TRACE_TASK_NAME_LEN, t->tasks[i].name);
+    } else {
+        snprintf(name, len, "task %08x", task);
+    }
+}
+
+static const char *state_name(uint32_t state)
+{
+    for (int i = 0; i < sizeof(state_names) / sizeof(state_names[0]); i++) {
+        if (state == (1u << i)) {
+            return state_names[i];
+        }
+    }
+    return "?";
+}
+
+static char method_letter(uint16_t id)
+{
+    //Calculation_Method bits, A is bit 0
+    for (int i = 0; i < 16; i++) {
+        if (id & (1u << i)) {
+            return 'A' + i;
+        }
+    }
+    return '?';
+}
+
+static void write_json(const trace *t, FILE *out)
+{
+    //pid 0 are the cores with the task switches, pid 1 the tasks with their events
+    int open_flush[TRACE_MAX_TASKS + 1] = {0}, open_fs[TRACE_MAX_TASKS + 1] = {0};
+    char name[TRACE_TASK_NAME_LEN + 16];
+    bool first = true;
+
+#define EMIT(...) do { fprintf(out, "%s\n", first ? "" : ","); first = false; fprintf(out, __VA_ARGS__); } while (0)
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    EMIT("{\"ph\":\"M\",\"pid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"Kerne\"}}");
+    EMIT("{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"Tasks\"}}");
+    for (int core = 0; core < t->header.cores; core++) {
+        EMIT("{\"ph\":\"M\",\"pid\":0,\"tid\":%i,\"name\":\"thread_name\",\"args\":{\"name\":\"Kern %i\"}}", core, core);
+    }
+    for (uint32_t i = 0; i < t->header.task_count; i++) {
+        task_name(t, t->tasks[i].task, name, sizeof(name));
+        EMIT("{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}", i + 1, name);
+    }
+    EMIT("{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"thread_name\",\"args\":{\"name\":\"(unbekannt)\"}}");
+
+    for (int core = 0; core < t->header.cores; core++) {
+        const event *last_switch = NULL;
+        for (uint32_t i = 0; i < t->counts[core]; i++) {
+            const event *e = &t->events[core][i];
+            int index = task_index(t, e->raw.task);
+            int tid = index + 1;
+            double ts = (double)e->time_us;
+
+            switch (e->raw.type) {
+            case TRACE_TASK_SWITCH:
+                if (last_switch != NULL) {
+                    int64_t dur = e->time_us - last_switch->time_us;
+                    task_name(t, last_switch->raw.task, name, sizeof(name));
+                    EMIT("{\"ph\":\"X\",\"pid\":0,\"tid\":%i,\"ts\":%.0lf,\"dur\":%lld,\"name\":\"%s\"}",
+                         core, (double)last_switch->time_us, (long long)(dur > 0 ? dur : 0), name);
+                }
+                last_switch = e;
+                break;
+            case TRACE_CALC_STATE:
+                EMIT("{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%i,\"ts\":%.0lf,\"name\":\"Methode %c: %s\"}",
+                     tid, ts, method_letter(e->raw.id), state_name(e->raw.arg));
+                break;
+            case TRACE_LCD_FLUSH_BEGIN:
+                open_flush[tid]++;
+                EMIT("{\"ph\":\"B\",\"pid\":1,\"tid\":%i,\"ts\":%.0lf,\"name\":\"LCD flush\"}", tid, ts);
+                break;
+            case TRACE_LCD_FLUSH_END:
+                //the begin may have been overwritten in the ring
+                if (open_flush[tid] > 0) {
+                    open_flush[tid]--;
+                    EMIT("{\"ph\":\"E\",\"pid\":1,\"tid\":%i,\"ts\":%.0lf}", tid, ts);
+                }
+                break;
+            case TRACE_FS_BEGIN:
+                open_fs[tid]++;
+                EMIT("{\"ph\":\"B\",\"pid\":1,\"tid\":%i,\"ts\":%.0lf,\"name\":\"littlefs\"}", tid, ts);
+                break;
+            case TRACE_FS_END:
+                if (open_fs[tid] > 0) {
+                    open_fs[tid]--;
+                    EMIT("{\"ph\":\"E\",\"pid\":1,\"tid\":%i,\"ts\":%.0lf}", tid, ts);
+                }
+                break;
+            case TRACE_BUTTON:
+                EMIT("{\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%i,\"ts\":%.0lf,\"name\":\"Taster 0x%02x\"}", tid, ts, e->raw.arg);
+                break;
+            case TRACE_MARK:
+                EMIT("{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%i,\"ts\":%.0lf,\"name\":\"Mark %u\",\"args\":{\"arg\":%u}}",
+                     tid, ts, e->raw.id, e->raw.arg);
+                break;
+            default:
+                break;
+            }
+        }
+        //the task running at the dump ends with the last event of the core
+        if (last_switch != NULL && t->counts[core] > 0) {
+            const event *end = &t->events[core][t->counts[core] - 1];
+            task_name(t, last_switch->raw.task, name, sizeof(name));
+            EMIT("{\"ph\":\"X\",\"pid\":0,\"tid\":%i,\"ts\":%.0lf,\"dur\":%lld,\"name\":\"%s\"}",
+                 core, (double)last_switch->time_us, (long long)(end->time_us - last_switch->time_us), name);
+        }
+    }
+    fprintf(out, "\n]}\n");
+#undef EMIT
+}
+
+int main(int argc, char **argv)
+{
+    size_t size;
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <log or trace.bin> [out.json]\n", argv[0]);
+        return 1;
+    }
+    uint8_t *file = read_file(argv[1], &size);
+    if (file == NULL) {
+        fprintf(stderr, "Could not read %s\n", argv[1]);
+        return 1;
+    }
+    uint8_t *data = file;
+    if (size < 4 || memcmp(file, TRACE_MAGIC, 4) != 0) {
+        data = decode_log((const char *)file, &size);
+        if (data == NULL) {
+            fprintf(stderr, "No trace dump in %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    trace *t = calloc(1, sizeof(trace));
+    if (!parse(data, size, t)) {
+        fprintf(stderr, "Trace in %s is truncated or corrupt\n", argv[1]);
+        return 1;
+    }
+    unwrap(t);
+
+    FILE *out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (out == NULL) {
+        fprintf(stderr, "Could not write %s\n", argv[2]);
+        return 1;
+    }
+    write_json(t, out);
+    uint32_t total = 0;
+    for (int core = 0; core < t->header.cores; core++) {
+        total += t->counts[core];
+    }
+    fprintf(stderr, "%u events of %u cores, %u tasks\n", total, t->header.cores, t->header.task_count);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
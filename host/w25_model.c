@@ -0,0 +1,57 @@
+#include <string.h>
+
+#include "w25_model.h"
+
+w25_model w25;
+
+void w25_model_init(void)
+{
+    memset(w25.mem, 0xFF, sizeof(w25.mem));
+    w25.write_enabled = false;
+    w25.now_us = 1;
+    w25.busy_until_us = 0;
+    w25.prog_us = W25_DEFAULT_PROG_US;
+    w25.erase_us = W25_DEFAULT_ERASE_US;
+    w25.overhead_us = W25_DEFAULT_OVERHEAD_US;
+}
+
+void w25_model_transfer(uint8_t *txdata, uint8_t *rxdata, uint32_t len)
+{
+    uint32_t addr = (len >= 4) ? ((txdata[1] << 16) | (txdata[2] << 8) | txdata[3]) % W25_SIZE : 0;
+    w25.now_us += w25.overhead_us + len * 8.0 * 1e6 / w25.frequency;
+
+    switch (txdata[0]) {
+    case 0x9F:
+        rxdata[1] = 0xEF; rxdata[2] = 0x40; rxdata[3] = 0x16;
+        break;
+    case 0x05:
+        rxdata[1] = (w25.now_us < w25.busy_until_us) ? 0x03 : (w25.write_enabled ? 0x02 : 0x00);
+        break;
+    case 0x06:
+        w25.write_enabled = true;
+        break;
+    case 0x03:
+        for (uint32_t i = 4; i < len; i++) {
+            rxdata[i] = w25.mem[(addr + i - 4) % W25_SIZE];
+        }
+        break;
+    case 0x02:
+        //a page program wraps around inside its page and can only clear bits
+        if (w25.write_enabled && w25.now_us >= w25.busy_until_us) {
+            for (uint32_t i = 4; i < len; i++) {
+                uint32_t a = (addr & ~(W25_PAGE - 1)) | ((addr + i - 4) & (W25_PAGE - 1));
+                w25.mem[a] &= txdata[i];
+            }
+            w25.busy_until_us = w25.now_us + w25.prog_us;
+        }
+        w25.write_enabled = false;
+        break;
+    case 0x20:
+        if (w25.write_enabled && w25.now_us >= w25.busy_until_us) {
+            memset(&w25.mem[addr & ~(W25_SECTOR - 1)], 0xFF, W25_SECTOR);
+            w25.busy_until_us = w25.now_us + w25.erase_us;
+        }
+        w25.write_enabled = false;
+        break;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+/********************************************************************************************* */
+//    W25Q32 in RAM for the host tools, answers the SPI transactions of the firmware flash driver
+//    (components/eduboard2/eduboardFlash/src/w25.c). Time is virtual: every transaction costs its
+//    bytes at the SPI clock plus a fixed overhead, programs and erases keep the busy bit set for the
+//    typical times of the datasheet.
+/********************************************************************************************* */
+#include <stdint.h>
+#include <stdbool.h>
+
+#define W25_SIZE (4 * 1024 * 1024)
+#define W25_PAGE 256
+#define W25_SECTOR 4096
+
+#define W25_DEFAULT_PROG_US 700         // tPP typical, W25Q32JV
+#define W25_DEFAULT_ERASE_US 45000      // tSE typical
+#define W25_DEFAULT_OVERHEAD_US 10      // ESP-IDF polling transaction, CS and setup
+
+typedef struct {
+    uint8_t mem[W25_SIZE];
+    bool write_enabled;
+    double now_us;                      // virtual time, advanced by every transaction
+    double busy_until_us;
+    uint32_t frequency;                 // SPI clock of the device, set by gpspi_init
+    double prog_us;
+    double erase_us;
+    double overhead_us;
+} w25_model;
+
+extern w25_model w25;
+
+// An erased chip with the typical timing, a new board
+void w25_model_init(void);
+// One full duplex transaction, the driver passes the same buffer for both directions
+void w25_model_transfer(uint8_t *txdata, uint8_t *rxdata, uint32_t len);
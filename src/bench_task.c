@@ -0,0 +1,193 @@
+#include "bench_task.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "esp_timer.h"
+#include "calcpi.h"
+#include "calc_runner.h"
+#include "planner.h"
+#include "bsplit.h"
+
+#define TAG "BENCH"
+
+#define DEBUG_LOGS (false)
+
+#define BENCH_YIELD_US 1000000          //the idle task of the core gets a tick this often, the pause is not timed
+#define BENCH_DUMP_LINE 96
+
+static const uint32_t bsplit_digits[] = {20, 100, 1000, 10000};   // the precisions "beyond" BENCH_MAX_DIGITS
+
+static TaskHandle_t bench_hndl = NULL;
+
+#ifdef CONFIG_ENABLE_FLASH
+static lfs_file_t bench_file;
+static bool bench_file_open = false;
+#endif
+
+static void bench_open(void) {
+    //an old result is replaced, without a file system the lines only go to the log
+#ifdef CONFIG_ENABLE_FLASH
+    lfs_t *fs = flash_fs();
+    if (fs != NULL) {
+        flash_fs_lock_op("bench open");
+        bench_file_open = lfs_file_open(fs, &bench_file, BENCH_FILE, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) >= 0;
+        flash_fs_unlock();
+    }
+    if (!bench_file_open) { ESP_LOGW(TAG, "Could not open %s, results are only logged", BENCH_FILE); }
+#endif
+}
+
+static void bench_write(const char *line) {
+    //called between the runs, the flash write is never part of a measurement
+    if (DEBUG_LOGS) {ESP_LOGI(TAG, "%s", line);}
+#ifdef CONFIG_ENABLE_FLASH
+    if (bench_file_open) {
+        flash_fs_lock_op("bench write");
+        lfs_file_write(flash_fs(), &bench_file, line, strlen(line));
+        flash_fs_unlock();
+    }
+#endif
+}
+
+static void bench_close(void) {
+#ifdef CONFIG_ENABLE_FLASH
+    if (bench_file_open) {
+        flash_fs_lock_op("bench close");
+        lfs_file_close(flash_fs(), &bench_file);
+        flash_fs_unlock();
+        bench_file_open = false;
+    }
+#endif
+}
+
+static bool run_method(const calc_method *method, void *state, struct pi_bounds bounds, int64_t *elapsed_us, uint64_t *iters) {
+    //same batches as the calculation task, but nothing else competes for the core
+    int64_t limit_us = 2 * (int64_t)BENCH_MAX_RUN_MS * 1000;
+    bool reached = false;
+
+    method->reset(state);
+    *elapsed_us = 0;
+    *iters = 0;
+    int64_t start = esp_timer_get_time();
+    while (!reached && *elapsed_us < limit_us) {
+        *iters += method->step_batch(state, CALC_BATCH_ITERS, &bounds);
+        reached = check_for_precision(method->snapshot(state), bounds);
+        if (!reached && (method->exhausted != NULL) && method->exhausted(state)) { break; }
+
+        int64_t now = esp_timer_get_time();
+        if (now - start >= BENCH_YIELD_US) {
+            *elapsed_us += now - start;
+            vTaskDelay(1);
+            start = esp_timer_get_time();
+        }
+    }
+    *elapsed_us += esp_timer_get_time() - start;
+    return reached;
+}
+
+static void bench_methods(char *line, size_t len) {
+    for (int m = 0; m < calc_method_count; m++) {
+        const calc_method *method = calc_methods[m];
+        char letter = calc_method_letter(method->id);
+        void *state = malloc(method->state_size);
+        if (state == NULL) { continue; }
+        method->init(state);
+
+        for (uint32_t digits = 1; digits <= BENCH_MAX_DIGITS; digits++) {
+            struct pi_bounds bounds = pi_bounds_for_digits(digits);
+            planner_estimate estimate = planner_estimate_method(method->id, bounds, 1);
+            if (!estimate.feasible || estimate.predicted_ms > BENCH_MAX_RUN_MS) {
+                ESP_LOGI(TAG, "%c, %" PRIu32 " digits skipped (predicted %.0lf ms)", letter, digits, estimate.predicted_ms);
+                continue;
+            }
+            for (int run = 1; run <= BENCH_RUNS; run++) {
+                int64_t elapsed_us;
+                uint64_t iters;
+                bool reached = run_method(method, state, bounds, &elapsed_us, &iters);
+                snprintf(line, len, "%c,%" PRIu32 ",%i,%" PRId64 ",%" PRIu64 ",%i\n", letter, digits, run, elapsed_us, iters, reached);
+                bench_write(line);
+            }
+            ESP_LOGI(TAG, "%c, %" PRIu32 " digits done", letter, digits);
+        }
+        free(state);
+    }
+}
+
+static void bench_bsplit(char *line, size_t len) {
+    const bsplit_series *series = &bsplit_pi_chudnovsky;
+    bigint_t fixed;
+
+    for (int d = 0; d < sizeof(bsplit_digits) / sizeof(bsplit_digits[0]); d++) {
+        for (int run = 1; run <= BENCH_RUNS; run++) {
+            bigint_init(&fixed);
+            int64_t start = esp_timer_get_time();
+            bool ok = bsplit_compute(series, bsplit_digits[d], &fixed);
+            int64_t elapsed_us = esp_timer_get_time() - start;
+            bigint_free(&fixed);
+            snprintf(line, len, "bsplit-%s,%" PRIu32 ",%i,%" PRId64 ",%" PRIu32 ",%i\n", series->symbol, bsplit_digits[d], run, elapsed_us, bsplit_terms(series, bsplit_digits[d]), ok);
+            bench_write(line);
+            //a few ms for the idle task, the larger runs take seconds
+            vTaskDelay(1);
+        }
+        ESP_LOGI(TAG, "bsplit-%s, %" PRIu32 " digits done", series->symbol, bsplit_digits[d]);
+    }
+}
+
+static void BenchTask(void* param) {
+    //Runs the whole matrix once and writes the CSV
+    char line[BENCH_DUMP_LINE];
+    int64_t start = esp_timer_get_time();
+
+    ESP_LOGI(TAG, "Benchmark started, %i runs per precision", BENCH_RUNS);
+    bench_open();
+    bench_write("Methode,Stellen,Run,Zeit in us,Iterationen,Erreicht\n");
+    bench_methods(line, sizeof(line));
+    bench_bsplit(line, sizeof(line));
+    bench_close();
+    ESP_LOGI(TAG, "Benchmark done after %.1lf s", (esp_timer_get_time() - start) / 1e6);
+
+    bench_dump();
+    bench_hndl = NULL;
+    vTaskDelete(NULL);
+}
+
+void bench_start(void) {
+    if (bench_running()) {
+        ESP_LOGW(TAG, "Benchmark is already running");
+        return;
+    }
+    xTaskCreatePinnedToCore(BenchTask, "Bench Task", 4*2048, NULL, BENCH_TASK_PRIO, &bench_hndl, BENCH_CORE % portNUM_PROCESSORS);
+}
+
+bool bench_running(void) {
+    return bench_hndl != NULL;
+}
+
+void bench_dump(void) {
+    //between markers, so a terminal log can be cut into the CSV file
+#ifdef CONFIG_ENABLE_FLASH
+    lfs_t *fs = flash_fs();
+    lfs_file_t file;
+    char buf[BENCH_DUMP_LINE];
+    lfs_ssize_t n;
+
+    if (fs == NULL) { return; }
+    flash_fs_lock_op("bench dump");
+    if (lfs_file_open(fs, &file, BENCH_FILE, LFS_O_RDONLY) < 0) {
+        flash_fs_unlock();
+        ESP_LOGW(TAG, "No benchmark results in %s", BENCH_FILE);
+        return;
+    }
+    printf("----- " BENCH_FILE " -----\n");
+    while ((n = lfs_file_read(fs, &file, buf, sizeof(buf))) > 0) {
+        fwrite(buf, 1, n, stdout);
+    }
+    printf("----- end -----\n");
+    fflush(stdout);
+    lfs_file_close(fs, &file);
+    flash_fs_unlock();
+#else
+    ESP_LOGW(TAG, "Results are only kept with CONFIG_ENABLE_FLASH");
+#endif
+}
@@ -0,0 +1,20 @@
+#pragma once
+/********************************************************************************************* */
+//    Automated benchmark of the calculation methods, replaces the runtimes_*.csv measurements by hand
+//    Every method runs BENCH_RUNS times for 1 .. 15 digits, the binary splitting engine continues
+//    with longer digit targets. Results go to a CSV in littlefs which is printed on the console UART.
+/********************************************************************************************* */
+#include "eduboard2.h"
+
+#define BENCH_RUNS 10                   //runs per method and precision, like runtimes_A.csv
+#define BENCH_MAX_DIGITS 15             //the last precision a double can hold
+#define BENCH_MAX_RUN_MS 20000          //precisions the planner predicts to take longer are skipped
+#define BENCH_FILE "bench.csv"
+#define BENCH_CORE 1                    //away from the UI tasks on core 0
+#define BENCH_TASK_PRIO 6               //above the calculation and job worker tasks, below the buttons
+
+// The caller stops the calculation tasks and the Monte Carlo engine first
+void bench_start(void);
+bool bench_running(void);
+// Prints the CSV of the last benchmark on the console
+void bench_dump(void);
@@ -0,0 +1,232 @@
+/********************************************************************************************* */
+//    Iteration kernels of the PI calculation methods
+//    One call of a step function calculates exactly one iteration of the method.
+/********************************************************************************************* */
+#include "calcpi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHUDNOVSKY_DIVIDEND (426880 * 100.02499687578100594479218787635777800159502436869631)    // 426880 * sqrt(10005)
+#define RAMANUJAN_DIVIDEND (9801 / (2 * 1.41421356237309504880168872420969807856967187537694))    // 9801 / (2 * sqrt(2))
+#define RAMANUJAN_Q 24591257856.0                                                                // 396^4
+
+double_t P (double_t j) {
+    /// Helper Function for Chudnovsky calculation method
+
+    double_t prod;
+
+    prod = -(6.0*j - 5.0) * (2.0*j - 1.0) * (6.0*j - 1.0);
+
+    return prod;
+}
+
+
+double_t Q (double_t j) {
+    /// Helper Function for Chudnovsky calculation method
+
+    double_t prod;
+
+    prod = 10939058860032000 * pow(j,3.0);
+    
+    return prod;
+}
+
+void leibniz_reset(struct leibniz_state *s) {
+    s->value = 4.0;
+    s->divisor = 3;
+    s->sign = -1;
+}
+
+void leibniz_step(struct leibniz_state *s) {
+    // pi = 4 - 4/3 + 4/5 - 4/7 ...
+    s->value += s->sign * (4 / s->divisor);
+    s->sign *= -1;
+    s->divisor += 2;
+}
+
+// The recursive double based bin_split led to quick stack overflow and could not go beyond double precision.
+// Binary splitting with arbitrary precision now lives in components/pimath (bsplit.h), see bsplit_pi_chudnovsky.
+
+void chudnovsky_reset(struct series_state *s) {
+    s->value = 0.0;
+    s->running_prod = 1.0;
+    s->running_sum = 0.0;
+    s->k = 1;
+}
+
+void chudnovsky_step(struct series_state *s) {
+    // 1/pi = 12/640320^(3/2) * sum (-1)^k (6k)! (13591409 + 545140134k) / ((3k)! (k!)^3 640320^(3k))
+    s->running_prod *= (double_t) P(s->k) / Q(s->k);
+    s->running_sum += (double_t) s->running_prod * (545140134.0 * s->k + 13591409);
+    s->value = (double_t) CHUDNOVSKY_DIVIDEND / (13591409 + s->running_sum);
+    s->k++;
+}
+
+void ramanujan_reset(struct series_state *s) {
+    s->value = 0.0;
+    s->running_prod = 1.0;
+    s->running_sum = 0.0;
+    s->k = 1;
+}
+
+void ramanujan_step(struct series_state *s) {
+    // 1/pi = 2 sqrt(2)/9801 * sum (4k)! (1103 + 26390k) / ((k!)^4 396^(4k))
+    // (4k)!/(4k-4)! / k^4 = 8 (4k-1)(2k-1)(4k-3) / k^3
+    double_t k = s->k;
+    s->running_prod *= (double_t) (8.0 * (4.0*k - 1.0) * (2.0*k - 1.0) * (4.0*k - 3.0)) / (k * k * k * RAMANUJAN_Q);
+    s->running_sum += (double_t) s->running_prod * (26390.0 * k + 1103);
+    s->value = (double_t) RAMANUJAN_DIVIDEND / (1103 + s->running_sum);
+    s->k++;
+}
+
+bool series_exhausted(const struct series_state *s) {
+    // the Chudnovsky terms alternate in sign, so the magnitude has to be compared
+    return fabs(s->running_prod) < SERIES_PROD_LIMIT;
+}
+
+bool check_for_precision(double_t value, struct pi_bounds bounds) {
+    //checks a value against the provided precision bounds
+    return (value < bounds.upper) && (value > bounds.lower);
+}
+
+struct pi_bounds pi_bounds_for_digits(uint32_t digits) {
+    //the truncated value and one step of the last digit above it
+    static const char pi_text[] = "3.14159265358979323846";
+    char text[sizeof(pi_text)];
+    struct pi_bounds bounds;
+
+    if (digits > sizeof(pi_text) - 3) { digits = sizeof(pi_text) - 3; }
+    snprintf(text, sizeof(text), "%.*s", (int)digits + 2, pi_text);
+    bounds.lower = strtod(text, NULL);
+    bounds.upper = bounds.lower + pow(10.0, -(double)digits);
+    return bounds;
+}
+
+uint32_t pi_bounds_digits(struct pi_bounds bounds) {
+    //decimals of the lower bound, the shortest decimal string that reads back as the same double
+    char text[32];
+    for (int digits = 0; digits < 17; digits++) {
+        snprintf(text, sizeof(text), "%.*f", digits, bounds.lower);
+        if (strtod(text, NULL) == bounds.lower) { return digits; }
+    }
+    return 17;
+}
+
+/********************************************************************************************* */
+//    Method registry
+/********************************************************************************************* */
+
+static void leibniz_init(void *state) {
+    leibniz_reset((struct leibniz_state *) state);
+}
+
+static void leibniz_reset_generic(void *state) {
+    leibniz_reset((struct leibniz_state *) state);
+}
+
+static uint32_t leibniz_step_batch(void *state, uint32_t max_iters, const struct pi_bounds *stop_at) {
+    struct leibniz_state *s = (struct leibniz_state *) state;
+    for (uint32_t i = 0; i < max_iters; i++) {
+        leibniz_step(s);
+        if ((stop_at != NULL) && check_for_precision(s->value, *stop_at)) { return i + 1; }
+    }
+    return max_iters;
+}
+
+static double_t leibniz_snapshot(const void *state) {
+    return ((const struct leibniz_state *) state)->value;
+}
+
+static void series_init(void *state) {
+    memset(state, 0, sizeof(struct series_state));
+}
+
+static uint32_t series_step_batch(struct series_state *s, void (*step)(struct series_state *), uint32_t max_iters, const struct pi_bounds *stop_at) {
+    for (uint32_t i = 0; i < max_iters; i++) {
+        if (series_exhausted(s)) { return i; }
+        step(s);
+        if ((stop_at != NULL) && check_for_precision(s->value, *stop_at)) { return i + 1; }
+    }
+    return max_iters;
+}
+
+static double_t series_snapshot(const void *state) {
+    return ((const struct series_state *) state)->value;
+}
+
+static bool series_exhausted_generic(const void *state) {
+    return series_exhausted((const struct series_state *) state);
+}
+
+static void chudnovsky_reset_generic(void *state) {
+    chudnovsky_reset((struct series_state *) state);
+}
+
+static uint32_t chudnovsky_step_batch(void *state, uint32_t max_iters, const struct pi_bounds *stop_at) {
+    return series_step_batch((struct series_state *) state, chudnovsky_step, max_iters, stop_at);
+}
+
+static void ramanujan_reset_generic(void *state) {
+    ramanujan_reset((struct series_state *) state);
+}
+
+static uint32_t ramanujan_step_batch(void *state, uint32_t max_iters, const struct pi_bounds *stop_at) {
+    return series_step_batch((struct series_state *) state, ramanujan_step, max_iters, stop_at);
+}
+
+static const calc_method calc_method_leibniz = {
+    .id = A,
+    .name = "Madhava/Leibniz",
+    .state_size = sizeof(struct leibniz_state),
+    .init = leibniz_init,
+    .reset = leibniz_reset_generic,
+    .step_batch = leibniz_step_batch,
+    .snapshot = leibniz_snapshot,
+    .exhausted = NULL,
+};
+
+static const calc_method calc_method_chudnovsky = {
+    .id = B,
+    .name = "Chudnovsky",
+    .state_size = sizeof(struct series_state),
+    .init = series_init,
+    .reset = chudnovsky_reset_generic,
+    .step_batch = chudnovsky_step_batch,
+    .snapshot = series_snapshot,
+    .exhausted = series_exhausted_generic,
+};
+
+static const calc_method calc_method_ramanujan = {
+    .id = C,
+    .name = "Ramanujan",
+    .state_size = sizeof(struct series_state),
+    .init = series_init,
+    .reset = ramanujan_reset_generic,
+    .step_batch = ramanujan_step_batch,
+    .snapshot = series_snapshot,
+    .exhausted = series_exhausted_generic,
+};
+
+const calc_method *const calc_methods[] = {
+    &calc_method_leibniz,
+    &calc_method_chudnovsky,
+    &calc_method_ramanujan,
+};
+
+const uint32_t calc_method_count = sizeof(calc_methods) / sizeof(calc_methods[0]);
+
+const calc_method *calc_method_find(Calculation_Method id) {
+    for (uint32_t i = 0; i < calc_method_count; i++) {
+        if (calc_methods[i]->id == id) { return calc_methods[i]; }
+    }
+    return NULL;
+}
+
+char calc_method_letter(Calculation_Method id) {
+    // A for bit 0, B for bit 1, ...
+    char letter = 'A';
+    while ((id >>= 1) != 0) { letter++; }
+    return letter;
+}
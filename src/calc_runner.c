@@ -0,0 +1,229 @@
+#include "calc_runner.h"
+
+#include "esp_timer.h"
+#include "digit_cache.h"
+#include "trace.h"
+#include "dlog.h"
+#include <inttypes.h>
+#include <stdlib.h>
+
+#define TAG "CALCRUNNER"
+
+#define UPDATETIME_MS 100       //delay after a reset
+#define CALCITER_TIME_MS 0      //delay between two batches
+
+#define DEBUG_LOGS (false)
+#define HIGHWATERMARK_LOGS (false)
+
+void calc_runner_set_state(calc_runner *runner, calc_state state) {
+    trace_record(TRACE_CALC_STATE, runner->method->id, state);
+    xEventGroupClearBits(runner->eventgroup_hndl, CLEAR_ALL);
+    xEventGroupSetBits(runner->eventgroup_hndl, state);
+}
+
+EventBits_t calc_runner_get_state(calc_runner *runner) {
+    return xEventGroupGetBits(runner->eventgroup_hndl);
+}
+
+static void publish_snapshot(calc_runner *runner) {
+    //makes the working copies visible to the readers
+    calc_snapshot *back = snapshot_begin_write(&runner->published_sync, runner->published, sizeof(calc_snapshot));
+    back->running = runner->running;
+    back->result = runner->result;
+    snapshot_end_write(&runner->published_sync);
+}
+
+void calc_runner_snapshot(calc_runner *runner, calc_snapshot *snapshot) {
+    snapshot_read(&runner->published_sync, runner->published, sizeof(calc_snapshot), snapshot);
+}
+
+struct timestamp GetCurrTimestamp(calc_runner *runner) {
+    // returns the progress the task published last, the task keeps running
+    calc_snapshot snapshot;
+    calc_runner_snapshot(runner, &snapshot);
+    return snapshot.running;
+}
+
+static void copy_data_into_result(calc_runner *runner) {
+    //copies running data into the result and publishes both together
+    runner->result = runner->running;
+    publish_snapshot(runner);
+
+    if (DEBUG_LOGS) { ESP_LOGI(TAG, "Copied data into result %c.", calc_method_letter(runner->method->id)); }
+}
+
+static void start_clock(calc_runner *runner) {
+    // The run time counter of the running task only includes its current slice after a context switch.
+    // A yield forces the switch (to the same task if nothing else is ready), so both clocks are read at the same instant.
+    taskYIELD();
+    runner->clock_us = esp_timer_get_time();
+    runner->clock_cpu = ulTaskGetRunTimeCounter(NULL);
+}
+
+static void account_time(calc_runner *runner) {
+    // adds the time since the last accounting, has to follow a yield like start_clock
+    int64_t now_us = esp_timer_get_time();
+    configRUN_TIME_COUNTER_TYPE now_cpu = ulTaskGetRunTimeCounter(NULL);
+
+    runner->running.elapsed_us += now_us - runner->clock_us;
+    runner->running.cpu_us += (configRUN_TIME_COUNTER_TYPE)(now_cpu - runner->clock_cpu);
+    runner->running.preempted_us = (runner->running.elapsed_us > runner->running.cpu_us) ? runner->running.elapsed_us - runner->running.cpu_us : 0;
+    runner->clock_us = now_us;
+    runner->clock_cpu = now_cpu;
+}
+
+static void reset_running_data(calc_runner *runner) {
+    runner->method->reset(runner->state);
+    runner->running.curr_val = runner->method->snapshot(runner->state);
+    runner->running.iters = 1;
+    runner->running.elapsed_us = 0;
+    runner->running.cpu_us = 0;
+    runner->running.preempted_us = 0;
+    runner->running.reached_prec = false;
+    runner->running.cached = false;
+}
+
+static bool load_from_cache(calc_runner *runner) {
+    //a fresh start is answered from flash if the method already produced at least the requested digits
+    uint32_t digits = pi_bounds_digits(*runner->bounds);
+    char text[24] = "3.";
+    char cached[digits + 1];
+
+    if ((digits == 0) || !digit_cache_lookup(CALC_CACHE_CONSTANT, runner->method->name, digits, cached)) { return false; }
+    memcpy(&text[2], cached, (digits < 17) ? digits : 17);
+    text[2 + ((digits < 17) ? digits : 17)] = '\0';
+    runner->running.curr_val = strtod(text, NULL);
+    runner->running.reached_prec = true;
+    runner->running.cached = true;
+    return true;
+}
+
+static void store_in_cache(calc_runner *runner) {
+    //the value lies between the bounds, so its digits are the ones of the lower bound
+    uint32_t digits = pi_bounds_digits(*runner->bounds);
+    char text[32];
+
+    if (digits == 0) { return; }
+    snprintf(text, sizeof(text), "%.*f", (int)digits, runner->bounds->lower);
+    digit_cache_store(CALC_CACHE_CONSTANT, runner->method->name, "3", &text[2], digits);
+}
+
+static bool spawn_task(calc_runner *runner);
+
+static void CalcTask(void* param) {
+    // iterative calculation with the method of the runner
+    // Writes data into result once it has reached requested precision
+    calc_runner *runner = (calc_runner *)param;
+    const calc_method *method = runner->method;
+    char letter = calc_method_letter(method->id);
+    EventBits_t state = STOPPING;
+
+    vTaskSetApplicationTaskTag(NULL, (void *) method->id);
+    if (!runner->initialized) {
+        method->init(runner->state);
+        reset_running_data(runner);
+        calc_runner_set_state(runner, STOPPING);
+        copy_data_into_result(runner);
+        runner->initialized = true;
+        if (DEBUG_LOGS) {ESP_LOGI(TAG, "Calculation Task %c initialized.", letter);}
+    }
+
+    for(;;){
+        if (HIGHWATERMARK_LOGS) {ESP_LOGI(TAG,"Calculation Task %c Highwatermark: %i", letter, uxTaskGetStackHighWaterMark(NULL));}
+
+        state = calc_runner_get_state(runner);
+
+        if (DEBUG_LOGS) {ESP_LOGI(TAG, "Calculation Task %c state: %" PRIu32, letter, state);}
+
+        switch (state)
+        {
+        case STOPPED:
+            xEventGroupWaitBits(runner->eventgroup_hndl, RUNNING | STARTING | RESETTING | STOPPING, pdFALSE, pdFALSE, portMAX_DELAY);
+            continue;
+
+        case STOPPING:
+            DLOG(TAG, "Calculation %c is stopping.", letter);
+            calc_runner_set_state(runner, STOPPED);
+            DLOG(TAG, "Calculation %c is stopped.", letter);
+            xEventGroupWaitBits(runner->eventgroup_hndl, RUNNING | STARTING | RESETTING | STOPPING, pdFALSE, pdFALSE, portMAX_DELAY);
+            continue;
+
+        case RESETTING:
+            DLOG(TAG, "Calculation %c is resetting.", letter);
+            reset_running_data(runner);
+            calc_runner_set_state(runner, STOPPING);
+            copy_data_into_result(runner);
+            vTaskDelay(UPDATETIME_MS/portTICK_PERIOD_MS);
+            continue;
+
+        case STARTING:
+            if (runner->core != xPortGetCoreID()) {
+                //the FreeRTOS of ESP-IDF can not change the core of a task, a new task there takes over the runner
+                DLOG(TAG, "Calculation %c moves to core %i.", letter, runner->core);
+                if (spawn_task(runner)) { vTaskDelete(NULL); }
+                runner->core = xPortGetCoreID();
+            }
+            DLOG(TAG, "Calculation %c is starting.", letter);
+            if ((runner->running.iters == 1) && load_from_cache(runner)) {
+                DLOG(TAG, "Calculation %c served from the digit cache.", letter);
+                calc_runner_set_state(runner, STOPPING);
+                copy_data_into_result(runner);
+                continue;
+            }
+            calc_runner_set_state(runner, RUNNING);
+            //state changes only, a line per batch would overwrite the ring within a second
+            DLOG(TAG, "Calculation %c is running. Current value: %.19lf", letter, runner->running.curr_val);
+            start_clock(runner);
+            break;
+
+        case RUNNING:
+            //until the precision is reached the batch ends exactly at the iteration that reached it
+            uint32_t done = method->step_batch(runner->state, CALC_BATCH_ITERS, runner->running.reached_prec ? NULL : runner->bounds);
+            runner->running.curr_val = method->snapshot(runner->state);
+            runner->running.iters += done;
+
+            //the yield after every batch also brings the run time counter up to date
+            vTaskDelay(CALCITER_TIME_MS/portTICK_PERIOD_MS);
+            account_time(runner);
+
+            if ((!runner->running.reached_prec) && (check_for_precision(runner->running.curr_val, *runner->bounds))){
+                runner->running.reached_prec = true;
+                DLOG(TAG, "Calculation %c reached the precision after %" PRIu32 " iterations: %.19lf", letter, runner->running.iters, runner->running.curr_val);
+                copy_data_into_result(runner);
+                //the flash write does not count as calculation time
+                store_in_cache(runner);
+                start_clock(runner);
+            } else {
+                publish_snapshot(runner);
+            }
+
+            if ((method->exhausted != NULL) && method->exhausted(runner->state)) {
+                DLOG(TAG, "Stopping Calc Task %c, the method can not improve the value anymore.", letter);
+                calc_runner_set_state(runner, STOPPING);
+            }
+            break;
+        }
+    }
+}
+
+static bool spawn_task(calc_runner *runner) {
+    //short enough for configMAX_TASK_NAME_LEN, the tools tell the runners apart by their name
+    char name[configMAX_TASK_NAME_LEN];
+    snprintf(name, sizeof(name), CALC_TASK_NAME " %c", calc_method_letter(runner->method->id));
+    return xTaskCreatePinnedToCore(CalcTask, name, CALC_TASK_STACK, runner, CALC_TASK_PRIO, &runner->task_hndl, runner->core) == pdPASS;
+}
+
+bool calc_runner_create(calc_runner *runner, const calc_method *method, struct pi_bounds *bounds, BaseType_t core) {
+    runner->method = method;
+    runner->bounds = bounds;
+    runner->core = core;
+    runner->initialized = false;
+    runner->state = malloc(method->state_size);
+    runner->eventgroup_hndl = xEventGroupCreate();
+    if ((runner->state == NULL) || (runner->eventgroup_hndl == NULL)) {
+        ESP_LOGE(TAG, "Could not allocate calculation method %s", method->name);
+        return false;
+    }
+
+    return spawn_task(runner);
+}
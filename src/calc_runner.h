@@ -0,0 +1,62 @@
+#pragma once
+/********************************************************************************************* */
+//    Generic calculation task, runs any calc_method of the registry
+/********************************************************************************************* */
+#include "eduboard2.h"
+#include "calcpi.h"
+#include "snapshot.h"
+
+#define CALC_BATCH_ITERS 64         //iterations between two state checks of a calculation task
+#define CALC_TASK_STACK (8*2048)
+#define CALC_TASK_PRIO 2
+#define CALC_TASK_NAME "Calc"      //followed by the method letter
+
+#define CALC_CACHE_CONSTANT "pi"   //key of the results in the digit cache, the algorithm is the method name
+
+#define CLEAR_ALL 0xFFFFFF
+
+typedef enum {
+    STOPPED         = 1 << 0,
+    STARTING        = 1 << 1,
+    RUNNING         = 1 << 2,
+    RESETTING       = 1 << 3,
+    STOPPING        = 1 << 4,
+    ANY_STATE   = STOPPED | STARTING | RUNNING | RESETTING | STOPPING
+} calc_state;       //describes different states of calculation task
+
+struct timestamp{
+    double_t curr_val;
+    uint64_t elapsed_us;        // esp_timer time while the method was RUNNING
+    uint64_t cpu_us;            // time the calculation task actually ran (FreeRTOS run time counter)
+    uint64_t preempted_us;      // elapsed - cpu, other tasks ran while the method was RUNNING
+    u_int32_t iters;
+    bool reached_prec;
+    bool cached;                // the digits came from the digit cache, nothing was calculated
+};
+
+typedef struct {
+    struct timestamp running;               // latest published progress
+    struct timestamp result;                // data at the moment the precision was reached
+} calc_snapshot;
+
+typedef struct {
+    const calc_method *method;
+    struct pi_bounds *bounds;
+    void *state;                            // method state, method->state_size bytes
+    BaseType_t core;                        // the task is pinned to this core, a start moves it to a changed core
+    bool initialized;                       // method state set up, a task taking over on another core keeps it
+    TaskHandle_t task_hndl;
+    EventGroupHandle_t eventgroup_hndl;     // Contains state of the task, there can only be ONE state at a time
+    struct timestamp running;               // working copies, written and read by the task only
+    struct timestamp result;
+    int64_t clock_us;                       // esp_timer and run time counter at the last accounting
+    configRUN_TIME_COUNTER_TYPE clock_cpu;
+    snapshot_sync published_sync;           // published after every batch, readers never stop the task
+    calc_snapshot published[2];
+} calc_runner;
+
+bool calc_runner_create(calc_runner *runner, const calc_method *method, struct pi_bounds *bounds, BaseType_t core);
+void calc_runner_set_state(calc_runner *runner, calc_state state);
+EventBits_t calc_runner_get_state(calc_runner *runner);
+void calc_runner_snapshot(calc_runner *runner, calc_snapshot *snapshot);
+struct timestamp GetCurrTimestamp(calc_runner *runner);
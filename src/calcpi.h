@@ -0,0 +1,76 @@
+#pragma once
+/********************************************************************************************* */
+//    Shared definitions of the PI calculation methods
+//    The iteration kernels are used by the calculation runner and by the planner microbenchmarks.
+//    A method is added by implementing calc_method and listing it in calc_methods[] (calc_kernels.c).
+/********************************************************************************************* */
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum {
+    A = 1 << 0,     // Madhava-Leibniz
+    B = 1 << 1,     // Chudnovsky
+    C = 1 << 2,     // Ramanujan
+} Calculation_Method;
+
+#define ALL_METHODS (A | B | C)
+#define MAX_METHODS 8           //Calculation_Method bits which fit into the MethodInfo event group
+
+struct pi_bounds {
+    double_t upper;
+    double_t lower;
+};
+
+struct leibniz_state {
+    double_t value;
+    double_t divisor;
+    double_t sign;
+};
+
+struct series_state {
+    double_t value;
+    double_t running_prod;
+    double_t running_sum;
+    uint32_t k;             // index of the next term
+};
+
+#define SERIES_PROD_LIMIT 0.00000000000000000000000000001     //series terms below this do not change a double anymore
+
+double_t P (double_t j);
+double_t Q (double_t j);
+
+void leibniz_reset(struct leibniz_state *s);
+void leibniz_step(struct leibniz_state *s);
+
+void chudnovsky_reset(struct series_state *s);
+void chudnovsky_step(struct series_state *s);
+
+void ramanujan_reset(struct series_state *s);
+void ramanujan_step(struct series_state *s);
+
+bool series_exhausted(const struct series_state *s);
+
+// Interface every calculation method implements, the state is owned by the caller (state_size bytes)
+typedef struct calc_method {
+    Calculation_Method id;
+    const char *name;
+    size_t state_size;
+    void (*init)(void *state);                  // once, before the first reset
+    void (*reset)(void *state);
+    // Runs up to max_iters iterations and returns how many were done. Stops early as soon as the
+    // value lies within stop_at (may be NULL) or the method can not improve the value anymore.
+    uint32_t (*step_batch)(void *state, uint32_t max_iters, const struct pi_bounds *stop_at);
+    double_t (*snapshot)(const void *state);    // current approximation
+    bool (*exhausted)(const void *state);       // NULL if the method converges forever
+} calc_method;
+
+extern const calc_method *const calc_methods[];
+extern const uint32_t calc_method_count;
+
+const calc_method *calc_method_find(Calculation_Method id);
+char calc_method_letter(Calculation_Method id);
+bool check_for_precision(double_t value, struct pi_bounds bounds);
+uint32_t pi_bounds_digits(struct pi_bounds bounds);   // decimals the bounds ask for
+struct pi_bounds pi_bounds_for_digits(uint32_t digits);
@@ -0,0 +1,193 @@
+#include "digit_cache.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "digitstore.h"
+
+#define TAG "DIGITCACHE"
+
+#define DEBUG_LOGS (false)
+
+#define DIGIT_CACHE_PATH_LEN 48          //"cache/<constant>-<algorithm>.cpdg", longer algorithm names are cut
+
+static digit_cache_stats stats;
+
+static void count(uint32_t *counter) {
+    __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+void digit_cache_get_stats(digit_cache_stats *out) {
+    out->hits = __atomic_load_n(&stats.hits, __ATOMIC_RELAXED);
+    out->misses = __atomic_load_n(&stats.misses, __ATOMIC_RELAXED);
+    out->stores = __atomic_load_n(&stats.stores, __ATOMIC_RELAXED);
+    out->errors = __atomic_load_n(&stats.errors, __ATOMIC_RELAXED);
+}
+
+#ifdef CONFIG_ENABLE_FLASH
+
+static void cache_path(const char *constant, const char *algorithm, char *path, size_t len) {
+    //method names contain blanks and dashes, littlefs takes them but they are awkward to list
+    int n = snprintf(path, len, DIGIT_CACHE_DIR "/%s-", constant);
+    for (const char *c = algorithm; *c != '\0' && n + 6 < len; c++) {
+        bool plain = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9');
+        path[n++] = plain ? *c : '_';
+    }
+    snprintf(&path[n], len - n, ".cpdg");
+}
+
+static uint8_t *load_container(const char *constant, const char *algorithm, size_t *size) {
+    //reads the whole container into RAM, the caller holds the fs lock
+    lfs_t *fs = flash_fs();
+    char path[DIGIT_CACHE_PATH_LEN];
+    lfs_file_t file;
+    uint8_t *data = NULL;
+
+    cache_path(constant, algorithm, path, sizeof(path));
+    if (lfs_file_open(fs, &file, path, LFS_O_RDONLY) < 0) {
+        return NULL;
+    }
+    lfs_soff_t len = lfs_file_size(fs, &file);
+    if (len > 0) {
+        data = malloc(len);
+    }
+    if (data != NULL && lfs_file_read(fs, &file, data, len) != len) {
+        free(data);
+        data = NULL;
+    }
+    lfs_file_close(fs, &file);
+    *size = (data != NULL) ? len : 0;
+    return data;
+}
+
+static bool open_cached(const char *constant, const char *algorithm, digitstore_reader *r, uint8_t **data) {
+    //container of the key with all blocks checked, false if there is none or it is corrupt
+    size_t size;
+    *data = load_container(constant, algorithm, &size);
+    if (*data == NULL) {
+        return false;
+    }
+    if (!digitstore_open_memory(r, *data, size) || digitstore_verify(r) >= 0) {
+        ESP_LOGW(TAG, "Cached digits of %s (%s) are corrupt", constant, algorithm);
+        count(&stats.errors);
+        digitstore_close(r);
+        free(*data);
+        *data = NULL;
+        return false;
+    }
+    return true;
+}
+
+void digit_cache_init(void) {
+    lfs_t *fs = flash_fs();
+    if (fs == NULL) {
+        ESP_LOGW(TAG, "No file system, the digit cache is disabled");
+        return;
+    }
+    flash_fs_lock_op("cache init");
+    int err = lfs_mkdir(fs, DIGIT_CACHE_DIR);
+    flash_fs_unlock();
+    if (err < 0 && err != LFS_ERR_EXIST) {
+        ESP_LOGE(TAG, "Could not create the cache directory: %i", err);
+    }
+}
+
+uint32_t digit_cache_digits(const char *constant, const char *algorithm) {
+    digitstore_reader r;
+    uint8_t *data;
+    uint32_t digits = 0;
+
+    if (flash_fs() == NULL) {
+        return 0;
+    }
+    flash_fs_lock_op("cache digits");
+    if (open_cached(constant, algorithm, &r, &data)) {
+        digits = r.header.digits;
+        digitstore_close(&r);
+        free(data);
+    }
+    flash_fs_unlock();
+    return digits;
+}
+
+bool digit_cache_lookup(const char *constant, const char *algorithm, uint32_t count_digits, char *out) {
+    digitstore_reader r;
+    uint8_t *data;
+    bool hit = false;
+
+    if (flash_fs() != NULL) {
+        flash_fs_lock_op("cache lookup");
+        if (open_cached(constant, algorithm, &r, &data)) {
+            hit = (r.header.digits >= count_digits) && (digitstore_read(&r, 0, out, count_digits) == count_digits);
+            digitstore_close(&r);
+            free(data);
+        }
+        flash_fs_unlock();
+    }
+    count(hit ? &stats.hits : &stats.misses);
+    if (DEBUG_LOGS) {ESP_LOGI(TAG, "%s (%s), %" PRIu32 " digits: %s", constant, algorithm, count_digits, hit ? "hit" : "miss");}
+    return hit;
+}
+
+bool digit_cache_store(const char *constant, const char *algorithm, const char *integer, const char *digits, uint32_t count_digits) {
+    lfs_t *fs = flash_fs();
+    if (fs == NULL || count_digits == 0 || count_digits > DIGIT_CACHE_MAX_DIGITS) {
+        return false;
+    }
+    if (digit_cache_digits(constant, algorithm) >= count_digits) {
+        return true;
+    }
+
+    //built in RAM because digitstore writes through stdio and littlefs has its own file API
+    size_t size = digitstore_size(count_digits);
+    uint8_t *buf = malloc(size);
+    digitstore_writer w;
+    bool ok = (buf != NULL) && digitstore_create_memory(&w, buf, size, constant, integer);
+    if (ok) {
+        ok = digitstore_append(&w, digits, count_digits);
+        ok = digitstore_finish(&w) && ok;
+    }
+
+    if (ok) {
+        //written to a temporary file first, a power loss during the write keeps the old digits
+        char path[DIGIT_CACHE_PATH_LEN], tmp[DIGIT_CACHE_PATH_LEN];
+        lfs_file_t file;
+        cache_path(constant, algorithm, path, sizeof(path));
+        snprintf(tmp, sizeof(tmp), DIGIT_CACHE_DIR "/new.tmp");
+
+        flash_fs_lock_op("cache store");
+        ok = lfs_file_open(fs, &file, tmp, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) >= 0;
+        if (ok) {
+            ok = lfs_file_write(fs, &file, buf, size) == size;
+            ok = (lfs_file_close(fs, &file) >= 0) && ok;
+        }
+        ok = ok && lfs_rename(fs, tmp, path) >= 0;
+        flash_fs_unlock();
+    }
+    free(buf);
+
+    count(ok ? &stats.stores : &stats.errors);
+    if (DEBUG_LOGS) {ESP_LOGI(TAG, "Stored %" PRIu32 " digits of %s (%s): %i", count_digits, constant, algorithm, ok);}
+    return ok;
+}
+
+#else
+
+void digit_cache_init(void) {
+}
+
+uint32_t digit_cache_digits(const char *constant, const char *algorithm) {
+    return 0;
+}
+
+bool digit_cache_lookup(const char *constant, const char *algorithm, uint32_t count_digits, char *out) {
+    count(&stats.misses);
+    return false;
+}
+
+bool digit_cache_store(const char *constant, const char *algorithm, const char *integer, const char *digits, uint32_t count_digits) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+/********************************************************************************************* */
+//    Persistent cache of computed digits in littlefs on the W25 flash
+//    One digit container (components/pimath/digitstore.h) per constant and algorithm, holding the longest
+//    digit string produced so far. Requests for as many or fewer digits are answered from flash.
+/********************************************************************************************* */
+#include "eduboard2.h"
+
+#define DIGIT_CACHE_DIR "cache"
+#define DIGIT_CACHE_MAX_DIGITS 20000     //containers are built in RAM before they are written
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t stores;
+    uint32_t errors;                    // unreadable or corrupt containers and failed writes
+} digit_cache_stats;
+
+void digit_cache_init(void);
+
+// Number of cached fractional digits, 0 if nothing is cached
+uint32_t digit_cache_digits(const char *constant, const char *algorithm);
+// Copies the first count fractional digits as ASCII into out, false (a miss) if fewer are cached
+bool digit_cache_lookup(const char *constant, const char *algorithm, uint32_t count, char *out);
+// Replaces the cached digits if the new ones are longer, integer is the part before the decimal point
+bool digit_cache_store(const char *constant, const char *algorithm, const char *integer, const char *digits, uint32_t count);
+
+void digit_cache_get_stats(digit_cache_stats *stats);
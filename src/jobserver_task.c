@@ -0,0 +1,198 @@
+#include "jobserver_task.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/uart.h"
+#include "driver/uart_vfs.h"
+#include "esp_timer.h"
+#include "bsplit.h"
+#include "digit_cache.h"
+#include "digitstore.h"
+
+#define TAG "JOBSERVER"
+
+#define DEBUG_LOGS (false)
+
+#define JOBSERVER_CACHE_ALGORITHM "bsplit"   //key of the results in the digit cache, the constant is the series symbol
+
+typedef struct {
+    const bsplit_series *series;
+    uint32_t terms;
+    uint32_t part;
+    uint32_t parts;
+    bsplit_pqt sum;
+    bool ok;
+    TaskHandle_t coordinator;
+} job_part;
+
+static jobserver server;
+static SemaphoreHandle_t server_mutex = NULL;
+static SemaphoreHandle_t write_mutex = NULL;
+static TaskHandle_t JobServerTask_hndl = NULL;
+static TaskHandle_t JobWorkerTask_hndl = NULL;
+
+static int uart_read(void *ctx, uint8_t *buf, size_t len)
+{
+    return uart_read_bytes(JOBSERVER_UART, buf, len, 10 / portTICK_PERIOD_MS);
+}
+
+static int uart_write(void *ctx, const uint8_t *buf, size_t len)
+{
+    //blocks while the TX ring buffer is full, so the stream runs at the baud rate of the console
+    xSemaphoreTake(write_mutex, portMAX_DELAY);
+    int written = uart_write_bytes(JOBSERVER_UART, buf, len);
+    xSemaphoreGive(write_mutex);
+    return written;
+}
+
+static uint32_t server_millis(void *ctx)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static void server_lock(void *ctx)
+{
+    xSemaphoreTake(server_mutex, portMAX_DELAY);
+}
+
+static void server_unlock(void *ctx)
+{
+    xSemaphoreGive(server_mutex);
+}
+
+static bool method_valid(void *ctx, uint8_t method, uint8_t cores, uint32_t digits)
+{
+    //method is the index into bsplit_series_list
+    return method < bsplit_series_count && digits <= JOBSERVER_DEVICE_MAX_DIGITS;
+}
+
+static void wake_worker(void *ctx)
+{
+    xTaskNotifyGive(JobWorkerTask_hndl);
+}
+
+static const jobserver_ops server_ops = {
+    .read = uart_read,
+    .write = uart_write,
+    .millis = server_millis,
+    .lock = server_lock,
+    .unlock = server_unlock,
+    .method_valid = method_valid,
+    .wake = wake_worker,
+};
+
+static void JobPartTask(void* param)
+{
+    //Sums one part of the terms on the core it is pinned to
+    job_part *p = (job_part*)param;
+    p->ok = bsplit_part(p->series, p->terms, p->part, p->parts, &p->sum);
+    xTaskNotifyGive(p->coordinator);
+    vTaskDelete(NULL);
+}
+
+static char *run_job(const jobserver_job *job)
+{
+    //Splits the terms over the requested cores, the parts are merged in order so the result does not depend on the core count
+    const bsplit_series *series = bsplit_series_list[job->method];
+    uint32_t parts = (job->cores < portNUM_PROCESSORS) ? job->cores : portNUM_PROCESSORS;
+    uint32_t terms = bsplit_terms(series, job->digits);
+    job_part p[portNUM_PROCESSORS];
+    bool ok = true;
+
+    for (int i = 0; i < parts; i++) {
+        p[i].series = series;
+        p[i].terms = terms;
+        p[i].part = i;
+        p[i].parts = parts;
+        p[i].ok = false;
+        p[i].coordinator = xTaskGetCurrentTaskHandle();
+        bsplit_pqt_init(&p[i].sum);
+        xTaskCreatePinnedToCore(JobPartTask, "Job Part", 4*2048, &p[i], JOBSERVER_WORKER_PRIO, NULL, i);
+    }
+    for (int i = 0; i < parts; i++) {
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+    }
+    for (int i = 0; i < parts; i++) {
+        ok = ok && p[i].ok;
+    }
+    for (int i = 1; ok && i < parts; i++) {
+        ok = bsplit_merge(series, &p[0].sum, &p[i].sum, i + 1 < parts);
+    }
+
+    bigint_t fixed;
+    bigint_init(&fixed);
+    char *text = NULL;
+    ok = ok && !jobserver_job_cancelled(&server, job->id) && bsplit_result(series, &p[0].sum, job->digits, &fixed);
+    for (int i = 0; i < parts; i++) {
+        bsplit_pqt_free(&p[i].sum);
+    }
+    if (ok) {
+        //keep only the fractional digits
+        size_t buflen = job->digits + 32;
+        text = malloc(buflen);
+        size_t len = (text != NULL) ? bsplit_format(&fixed, job->digits, text, buflen) : 0;
+        if (len > job->digits) {
+            //the cache keeps the integer part in the container header
+            char integer[DIGITSTORE_INTEGER_LEN];
+            size_t intlen = len - job->digits - 1;
+            snprintf(integer, sizeof(integer), "%.*s", (int)intlen, text);
+            digit_cache_store(series->symbol, JOBSERVER_CACHE_ALGORITHM, integer, &text[len - job->digits], job->digits);
+            memmove(text, &text[len - job->digits], job->digits);
+        } else {
+            free(text);
+            text = NULL;
+        }
+    }
+    bigint_free(&fixed);
+    return text;
+}
+
+static void JobWorkerTask(void* param)
+{
+    //Computes the queued jobs one after the other
+    jobserver_job job;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (jobserver_next_job(&server, &job)) {
+            if (DEBUG_LOGS) {ESP_LOGI(TAG, "Job %u: %" PRIu32 " digits of %s on %u cores", job.id, job.digits, bsplit_series_list[job.method]->name, job.cores);}
+            //repeated requests are answered from flash
+            char *digits = malloc(job.digits);
+            if ((digits != NULL) && !digit_cache_lookup(bsplit_series_list[job.method]->symbol, JOBSERVER_CACHE_ALGORITHM, job.digits, digits)) {
+                free(digits);
+                digits = run_job(&job);
+            }
+            jobserver_job_done(&server, job.id, digits, job.digits);
+        }
+    }
+}
+
+static void JobServerTask(void* param)
+{
+    //Answers the frames arriving on the console UART and streams results
+    for (;;) {
+        jobserver_poll(&server);
+    }
+}
+
+void jobserver_task_init(void)
+{
+    //logs keep going to the console, but through the driver so that they do not interleave with frames
+    if (uart_driver_install(JOBSERVER_UART, JOBSERVER_RX_BUFFER, JOBSERVER_TX_BUFFER, 0, NULL, 0) != ESP_OK) {
+        ESP_LOGE(TAG, "UART driver could not be installed");
+        return;
+    }
+    uart_vfs_dev_use_driver(JOBSERVER_UART);
+
+    server_mutex = xSemaphoreCreateMutex();
+    write_mutex = xSemaphoreCreateMutex();
+    jobserver_init(&server, &server_ops, NULL);
+    xTaskCreate(JobWorkerTask, "Job Worker", 2*2048, NULL, JOBSERVER_WORKER_PRIO, &JobWorkerTask_hndl);
+    xTaskCreatePinnedToCore(JobServerTask, "Job Server", 2*2048, NULL, JOBSERVER_TASK_PRIO, &JobServerTask_hndl, JOBSERVER_CORE);
+}
+
+SemaphoreHandle_t jobserver_task_write_lock(void)
+{
+    return write_mutex;
+}
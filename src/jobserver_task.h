@@ -0,0 +1,19 @@
+#pragma once
+/********************************************************************************************* */
+//    Job server on the console UART, jobs are digits of the constants of the binary splitting engine
+//    Protocol: components/jobserver/jobproto.h, host client: host/jobclient.c
+/********************************************************************************************* */
+#include "eduboard2.h"
+#include "jobserver.h"
+
+#define JOBSERVER_UART UART_NUM_0           //console UART, frames and log output share it
+#define JOBSERVER_RX_BUFFER 1024
+#define JOBSERVER_TX_BUFFER 4096
+#define JOBSERVER_DEVICE_MAX_DIGITS 20000   //limited by the heap for the binary splitting products
+#define JOBSERVER_TASK_PRIO 3
+#define JOBSERVER_WORKER_PRIO 1
+#define JOBSERVER_CORE 0
+
+void jobserver_task_init(void);
+// Held while one frame is written to JOBSERVER_UART, other tasks sending frames there take it too
+SemaphoreHandle_t jobserver_task_write_lock(void);
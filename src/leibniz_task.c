@@ -0,0 +1,93 @@
+#include "leibniz_task.h"
+
+#include <inttypes.h>
+
+#include "esp_timer.h"
+
+#define TAG "LEIBNIZ"
+
+typedef struct {
+    uint64_t terms;
+    uint32_t worker;
+    uint32_t workers;
+    leibniz_split split;
+    leibniz_acc partial;
+    TaskHandle_t coordinator;
+} leibniz_worker;
+
+static TaskHandle_t leibniz_hndl = NULL;
+
+static void leibniz_worker_task(void* param)
+{
+    //Sums the share of one worker on the core it is pinned to
+    leibniz_worker *w = (leibniz_worker*)param;
+    w->partial = leibniz_partial(w->terms, w->worker, w->workers, w->split);
+    xTaskNotifyGive(w->coordinator);
+    vTaskDelete(NULL);
+}
+
+static double leibniz_run(uint64_t terms, uint32_t workers, leibniz_split split, int64_t *elapsed_us)
+{
+    //One pinned worker per core, the coordinator waits for all of them
+    leibniz_worker w[portNUM_PROCESSORS];
+    leibniz_acc partials[portNUM_PROCESSORS];
+    int64_t start = esp_timer_get_time();
+
+    for (int core = 0; core < workers; core++) {
+        w[core].terms = terms;
+        w[core].worker = core;
+        w[core].workers = workers;
+        w[core].split = split;
+        w[core].coordinator = xTaskGetCurrentTaskHandle();
+        xTaskCreatePinnedToCore(leibniz_worker_task, "Leibniz Worker", 2*2048, &w[core], LEIBNIZ_TASK_PRIO, NULL, core);
+    }
+    for (int core = 0; core < workers; core++) {
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+    }
+
+    //fixed reduction order, the result does not depend on which core finished first
+    for (int core = 0; core < workers; core++) {
+        partials[core] = w[core].partial;
+    }
+    double value = leibniz_reduce(partials, workers);
+    *elapsed_us = esp_timer_get_time() - start;
+    return value;
+}
+
+static void leibniz_task(void* param)
+{
+    //Scaling test, every split with 1..portNUM_PROCESSORS workers
+    uint64_t terms = *(uint64_t*)param;
+    const leibniz_split splits[] = {LEIBNIZ_BLOCKED, LEIBNIZ_INTERLEAVED};
+
+    for (int s = 0; s < sizeof(splits) / sizeof(splits[0]); s++) {
+        int64_t base_us = 0;
+        for (uint32_t workers = 1; workers <= portNUM_PROCESSORS; workers++) {
+            int64_t elapsed_us;
+            double value = leibniz_run(terms, workers, splits[s], &elapsed_us);
+            if (workers == 1) {
+                base_us = elapsed_us;
+            }
+            ESP_LOGI(TAG, "%" PRIu64 " terms, %s, %" PRIu32 " cores: %.17lf in %" PRId64 " us, speedup %.2lf", terms, leibniz_split_name(splits[s]), workers, value, elapsed_us, (double)base_us / elapsed_us);
+        }
+    }
+
+    leibniz_hndl = NULL;
+    vTaskDelete(NULL);
+}
+
+void leibniz_parallel_start(uint64_t terms)
+{
+    static uint64_t requested_terms;
+    if (leibniz_parallel_running()) {
+        ESP_LOGW(TAG, "Parallel Leibniz is already running");
+        return;
+    }
+    requested_terms = terms;
+    xTaskCreate(leibniz_task, "Leibniz Task", 2*2048, &requested_terms, LEIBNIZ_TASK_PRIO, &leibniz_hndl);
+}
+
+bool leibniz_parallel_running(void)
+{
+    return leibniz_hndl != NULL;
+}
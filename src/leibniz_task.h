@@ -0,0 +1,13 @@
+#pragma once
+/********************************************************************************************* */
+//    Parallel Madhava-Leibniz summation, the terms are split over one task per core
+/********************************************************************************************* */
+#include "eduboard2.h"
+#include "leibniz.h"
+
+#define LEIBNIZ_PARALLEL_TERMS 2000000   //terms summed by every run of the scaling test
+#define LEIBNIZ_TASK_PRIO 1
+
+// Sums the terms with 1..portNUM_PROCESSORS workers for both splits and logs time and speedup
+void leibniz_parallel_start(uint64_t terms);
+bool leibniz_parallel_running(void);
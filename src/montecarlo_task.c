@@ -0,0 +1,128 @@
+#include "montecarlo_task.h"
+
+#include <inttypes.h>
+
+#include "esp_timer.h"
+#include "snapshot.h"
+
+#define TAG "MONTECARLO"
+
+#define MC_RUN (1 << 0)
+
+typedef struct {
+    uint64_t hits;
+    uint64_t samples;
+    int64_t busy_us;
+} mc_counters;
+
+// Every core writes only into its own slot, readers copy the published counters without stopping the sampling tasks
+typedef struct {
+    snapshot_sync sync;
+    mc_counters published[2];
+    volatile uint32_t reset_request;
+} __attribute__((aligned(64))) mc_slot;
+
+static mc_slot mc_slots[portNUM_PROCESSORS];
+static TaskHandle_t mc_task_hndl[portNUM_PROCESSORS];
+static EventGroupHandle_t mc_eventgroup_hndl = NULL;
+
+static void mc_publish(mc_slot *slot, const mc_sampler *sampler, int64_t busy_us)
+{
+    mc_counters *back = snapshot_begin_write(&slot->sync, slot->published, sizeof(mc_counters));
+    back->hits = sampler->hits;
+    back->samples = sampler->samples;
+    back->busy_us = busy_us;
+    snapshot_end_write(&slot->sync);
+}
+
+static void mc_sampling_task(void* param)
+{
+    //Samples points on the core it is pinned to until it is stopped
+    uint32_t core = (uint32_t)(intptr_t)param;
+    mc_slot *slot = &mc_slots[core];
+    mc_sampler sampler;
+    uint32_t reset_seen = 0;
+    int64_t busy_us = 0;
+
+    mc_sampler_init(&sampler, MC_SEED, core);
+
+    for(;;) {
+        xEventGroupWaitBits(mc_eventgroup_hndl, MC_RUN, false, true, portMAX_DELAY);
+
+        if (slot->reset_request != reset_seen) {
+            reset_seen = slot->reset_request;
+            mc_sampler_reset(&sampler);
+            busy_us = 0;
+            mc_publish(slot, &sampler, busy_us);
+        }
+
+        int64_t start = esp_timer_get_time();
+        int64_t now = start;
+        while ((now - start) < MC_YIELD_MS * 1000) {
+            mc_sample(&sampler, MC_BATCH_BLOCKS);
+            now = esp_timer_get_time();
+            mc_publish(slot, &sampler, busy_us + (now - start));
+            if (!(xEventGroupGetBits(mc_eventgroup_hndl) & MC_RUN)) {break;}
+        }
+        busy_us += now - start;
+
+        vTaskDelay(1);
+    }
+}
+
+void mc_engine_init(void)
+{
+    mc_eventgroup_hndl = xEventGroupCreate();
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        xTaskCreatePinnedToCore(mc_sampling_task, "Monte Carlo Task", 2*2048, (void*)(intptr_t)core, MC_TASK_PRIO, &mc_task_hndl[core], core);
+    }
+}
+
+void mc_engine_start(void)
+{
+    xEventGroupSetBits(mc_eventgroup_hndl, MC_RUN);
+}
+
+void mc_engine_stop(void)
+{
+    xEventGroupClearBits(mc_eventgroup_hndl, MC_RUN);
+}
+
+void mc_engine_reset(void)
+{
+    //the owners reset their samplers before the next batch
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        mc_slots[core].reset_request++;
+    }
+}
+
+bool mc_engine_running(void)
+{
+    return (mc_eventgroup_hndl != NULL) && (xEventGroupGetBits(mc_eventgroup_hndl) & MC_RUN);
+}
+
+void mc_engine_snapshot(mc_snapshot *snap)
+{
+    //reduce the per core counters, this is the only place where they are combined
+    snap->hits = 0;
+    snap->samples = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        mc_counters counters;
+        snapshot_read(&mc_slots[core].sync, mc_slots[core].published, sizeof(mc_counters), &counters);
+        snap->hits += counters.hits;
+        snap->samples += counters.samples;
+        snap->core_samples[core] = counters.samples;
+        snap->core_samples_per_s[core] = (counters.busy_us > 0) ? (double_t)counters.samples * 1e6 / counters.busy_us : 0;
+    }
+    snap->pi = mc_estimate(snap->hits, snap->samples);
+}
+
+void mc_engine_print_report(void)
+{
+    mc_snapshot snap;
+    mc_engine_snapshot(&snap);
+    ESP_LOGI(TAG, "Pi ~ %.10lf after %" PRIu64 " samples", snap.pi, snap.samples);
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        ESP_LOGI(TAG, "Core %i: %12" PRIu64 " samples, %10.0lf samples/s", core, snap.core_samples[core], snap.core_samples_per_s[core]);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+/********************************************************************************************* */
+//    Monte Carlo Pi sampling, one pinned sampling task per core
+/********************************************************************************************* */
+#include "eduboard2.h"
+#include "montecarlo.h"
+
+#define MC_BATCH_BLOCKS 512     //philox blocks per batch, counters are published after every batch
+#define MC_YIELD_MS 100         //sampling tasks block for one tick after this time so the idle tasks can feed the watchdog
+#define MC_TASK_PRIO 1
+#define MC_SEED 0x5EED314159265ULL
+
+typedef struct {
+    uint64_t hits;
+    uint64_t samples;
+    double_t pi;
+    uint64_t core_samples[portNUM_PROCESSORS];
+    double_t core_samples_per_s[portNUM_PROCESSORS];
+} mc_snapshot;
+
+void mc_engine_init(void);
+void mc_engine_start(void);
+void mc_engine_stop(void);
+void mc_engine_reset(void);
+bool mc_engine_running(void);
+void mc_engine_snapshot(mc_snapshot *snap);
+void mc_engine_print_report(void);
@@ -0,0 +1,82 @@
+#include "pidigit_task.h"
+
+#include <inttypes.h>
+
+#include "esp_timer.h"
+
+#define TAG "PIDIGIT"
+
+typedef struct {
+    const pidigit_job *job;
+    uint32_t worker;
+    double partial;
+    TaskHandle_t coordinator;
+} pidigit_worker;
+
+static TaskHandle_t pidigit_hndl = NULL;
+
+static void pidigit_worker_task(void* param)
+{
+    //Sums the contributions of every portNUM_PROCESSORS-th prime
+    pidigit_worker *w = (pidigit_worker*)param;
+    w->partial = pidigit_partial(w->job, w->worker, portNUM_PROCESSORS);
+    xTaskNotifyGive(w->coordinator);
+    vTaskDelete(NULL);
+}
+
+static void pidigit_task(void* param)
+{
+    //Splits the job over all cores and logs the digits when every worker is done
+    uint32_t position = (uint32_t)(uintptr_t)param;
+    pidigit_job job;
+    pidigit_worker workers[portNUM_PROCESSORS];
+    char digits[PIDIGIT_DIGITS + 1];
+    int64_t start = esp_timer_get_time();
+
+    if (!pidigit_job_init(&job, position)) {
+        ESP_LOGE(TAG, "Not enough memory for position %" PRIu32, position);
+        pidigit_job_free(&job);
+        pidigit_hndl = NULL;
+        vTaskDelete(NULL);
+    }
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        workers[core].job = &job;
+        workers[core].worker = core;
+        workers[core].partial = 0;
+        workers[core].coordinator = xTaskGetCurrentTaskHandle();
+        xTaskCreatePinnedToCore(pidigit_worker_task, "Pidigit Worker", 2*2048, &workers[core], PIDIGIT_TASK_PRIO, NULL, core);
+    }
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+    }
+
+    //fixed reduction order, the result does not depend on which core finished first
+    double sum = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        sum += workers[core].partial;
+    }
+    if (pidigit_digits(&job, sum, digits)) {
+        ESP_LOGI(TAG, "Digits at position %" PRIu32 ": %s (%" PRIu32 " terms, %" PRIu32 " primes, %" PRId64 " ms)", position, digits, job.terms, job.prime_count, (esp_timer_get_time() - start) / 1000);
+    } else {
+        ESP_LOGE(TAG, "Computation of position %" PRIu32 " failed", position);
+    }
+
+    pidigit_job_free(&job);
+    pidigit_hndl = NULL;
+    vTaskDelete(NULL);
+}
+
+void pidigit_start(uint32_t position)
+{
+    if (pidigit_running()) {
+        ESP_LOGW(TAG, "Digit extraction is already running");
+        return;
+    }
+    xTaskCreate(pidigit_task, "Pidigit Task", 4*2048, (void*)(uintptr_t)position, PIDIGIT_TASK_PRIO, &pidigit_hndl);
+}
+
+bool pidigit_running(void)
+{
+    return pidigit_hndl != NULL;
+}
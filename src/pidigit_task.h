@@ -0,0 +1,12 @@
+#pragma once
+/********************************************************************************************* */
+//    Decimal digits of pi at a position, the primes are split over one task per core
+/********************************************************************************************* */
+#include "eduboard2.h"
+#include "pidigit.h"
+
+#define PIDIGIT_POSITION 10000      //position computed on SW1 long press
+#define PIDIGIT_TASK_PRIO 1
+
+void pidigit_start(uint32_t position);
+bool pidigit_running(void);
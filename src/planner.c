@@ -0,0 +1,175 @@
+/********************************************************************************************* */
+//    Planner: predicts wall time and memory of every calculation method for a precision target
+//    and picks the fastest one.
+//
+//    time = iterations(digits) * kernel cost + batches * task loop cost, split by Amdahl into a serial and a parallel part.
+//    Only the kernel of a series with independent terms is parallel, the way leibniz_task splits the Leibniz terms.
+//    Kernel and loop costs are measured with short microbenchmarks on the device (planner_calibrate).
+/********************************************************************************************* */
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "planner.h"
+#include "calc_runner.h"
+
+#define TAG "PLANNER"
+
+#define DBL_DIGITS 15                   //a double holds 15 decimals of pi at most
+
+typedef struct {
+    Calculation_Method method;
+    uint32_t max_digits;
+    bool independent_terms;         // terms can be summed on several cores, a recurrence over the previous term can not
+    double_t kernel_us;             // cost of one kernel iteration
+} planner_candidate;
+
+// defaults are taken from documentation/tests/runtimes_A.csv until the device is calibrated
+static planner_candidate candidates[] = {
+    { A, 10,         true,  1.5 },
+    { B, DBL_DIGITS, false, 25.0 },     // running product of the previous terms
+    { C, DBL_DIGITS, false, 20.0 },
+};
+#define NUM_CANDIDATES (sizeof(candidates) / sizeof(candidates[0]))
+
+static double_t loop_overhead_us = 11.3;    //event group poll, tick count and yield of one calc task batch
+
+static planner_candidate *find_candidate(Calculation_Method method) {
+    for (int i = 0; i < NUM_CANDIDATES; i++) {
+        if (candidates[i].method == method) { return &candidates[i]; }
+    }
+    return NULL;
+}
+
+static uint64_t planner_iterations(Calculation_Method method, struct pi_bounds bounds) {
+    uint32_t digits = pi_bounds_digits(bounds);
+    double_t upper_margin = bounds.upper - M_PI, lower_margin = M_PI - bounds.lower;
+
+    switch (method) {
+    case A:
+        // |pi - S_n| is about 1/n and the partial sums alternate around pi,
+        // so the precision is reached as soon as 1/n fits into the wider margin
+        return (uint64_t) ceil(1.0 / fmax(upper_margin, lower_margin));
+    case B:
+        return (uint64_t) ceil(digits / 14.18);
+    case C:
+        return (uint64_t) ceil(digits / 7.98);
+    default:
+        return 0;
+    }
+}
+
+static double_t time_kernel_us(Calculation_Method method) {
+    // runs the iteration kernel of a method and returns the cost of one iteration
+    const calc_method *m = calc_method_find(method);
+    _Alignas(max_align_t) uint8_t state[64];   // the states hold doubles
+    uint32_t done = 0;
+
+    if ((m == NULL) || (m->state_size > sizeof(state))) {
+        return 0;
+    }
+    m->init(state);
+    m->reset(state);
+
+    int64_t start = esp_timer_get_time();
+    while (done < PLANNER_CALIB_ITERS) {
+        //restart once the method can not improve anymore, an underflowed series would make the timing meaningless
+        uint32_t iters = m->step_batch(state, PLANNER_CALIB_ITERS - done, NULL);
+        done += iters;
+        if ((iters == 0) || ((m->exhausted != NULL) && m->exhausted(state))) {
+            m->reset(state);
+        }
+    }
+    int64_t end = esp_timer_get_time();
+
+    return (double_t)(end - start) / PLANNER_CALIB_ITERS;
+}
+
+static double_t time_loop_overhead_us(void) {
+    // same calls the calculation tasks do per batch besides the kernel
+    EventGroupHandle_t evgroup = xEventGroupCreate();
+    volatile EventBits_t bits = 0;
+    volatile int64_t now_us = 0;
+    volatile configRUN_TIME_COUNTER_TYPE now_cpu = 0;
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < PLANNER_CALIB_ITERS; i++) {
+        bits = xEventGroupGetBits(evgroup);
+        vTaskDelay(0);
+        now_us = esp_timer_get_time();
+        now_cpu = ulTaskGetRunTimeCounter(NULL);
+    }
+    int64_t end = esp_timer_get_time();
+
+    vEventGroupDelete(evgroup);
+    (void) bits;
+    (void) now_us;
+    (void) now_cpu;
+    return (double_t)(end - start) / PLANNER_CALIB_ITERS;
+}
+
+void planner_calibrate(void) {
+    loop_overhead_us = time_loop_overhead_us();
+    for (int i = 0; i < NUM_CANDIDATES; i++) {
+        candidates[i].kernel_us = time_kernel_us(candidates[i].method);
+    }
+    ESP_LOGI(TAG, "Calibrated: loop %.2f us per batch", loop_overhead_us);
+    for (int i = 0; i < NUM_CANDIDATES; i++) {
+        ESP_LOGI(TAG, "  %c %.2f us per iteration", calc_method_letter(candidates[i].method), candidates[i].kernel_us);
+    }
+}
+
+planner_estimate planner_estimate_method(Calculation_Method method, struct pi_bounds bounds, uint8_t cores) {
+    planner_estimate estimate = {method, "unknown", false, 0, 0, INFINITY, 0};
+    planner_candidate *candidate = find_candidate(method);
+
+    if (candidate == NULL) {
+        return estimate;
+    }
+    if (cores == 0) { cores = 1; }
+
+    estimate.name = calc_method_find(method)->name;
+    estimate.digits = pi_bounds_digits(bounds);
+    estimate.iterations = planner_iterations(method, bounds);
+    estimate.feasible = estimate.digits <= candidate->max_digits;
+
+    uint64_t batches = (estimate.iterations + CALC_BATCH_ITERS - 1) / CALC_BATCH_ITERS;
+    double_t kernel_us = estimate.iterations * candidate->kernel_us;
+    double_t total_us = kernel_us + batches * loop_overhead_us;
+    //the parallel fraction follows from the calibrated costs, the task loop and the reduction stay serial
+    double_t parallel_fraction = (candidate->independent_terms && (total_us > 0)) ? kernel_us / total_us : 0.0;
+    double_t serial_us = total_us * (1.0 - parallel_fraction);
+    estimate.predicted_ms = (serial_us + (total_us - serial_us) / cores) / 1000.0;
+    estimate.predicted_bytes = calc_method_find(method)->state_size + CALC_TASK_STACK;
+
+    return estimate;
+}
+
+Calculation_Method planner_pick(struct pi_bounds bounds, uint8_t cores) {
+    Calculation_Method best = A;
+    double_t best_ms = INFINITY;
+
+    for (int i = 0; i < NUM_CANDIDATES; i++) {
+        planner_estimate estimate = planner_estimate_method(candidates[i].method, bounds, cores);
+        if (estimate.feasible && (estimate.predicted_ms < best_ms)) {
+            best_ms = estimate.predicted_ms;
+            best = estimate.method;
+        }
+    }
+    return best;
+}
+
+void planner_print_report(struct pi_bounds bounds, uint8_t cores) {
+    ESP_LOGI(TAG, "Prediction for %i digits on %i cores:", (int)pi_bounds_digits(bounds), cores);
+    for (int i = 0; i < NUM_CANDIDATES; i++) {
+        planner_estimate estimate = planner_estimate_method(candidates[i].method, bounds, cores);
+        if (estimate.feasible) {
+            ESP_LOGI(TAG, "  %-16s %12llu iterations %12.1f ms %6i bytes", estimate.name,
+                (unsigned long long)estimate.iterations, estimate.predicted_ms, (int)estimate.predicted_bytes);
+        } else {
+            ESP_LOGI(TAG, "  %-16s cannot reach this precision", estimate.name);
+        }
+    }
+}
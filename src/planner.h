@@ -0,0 +1,22 @@
+#pragma once
+/********************************************************************************************* */
+//    Cost model based selection of the calculation method
+/********************************************************************************************* */
+#include "calcpi.h"
+
+#define PLANNER_CALIB_ITERS 2000    //iterations per microbenchmark
+
+typedef struct {
+    Calculation_Method method;
+    const char *name;
+    bool feasible;              // method can reach the precision at all
+    uint32_t digits;
+    uint64_t iterations;
+    double_t predicted_ms;
+    uint32_t predicted_bytes;
+} planner_estimate;
+
+void planner_calibrate(void);
+planner_estimate planner_estimate_method(Calculation_Method method, struct pi_bounds bounds, uint8_t cores);
+Calculation_Method planner_pick(struct pi_bounds bounds, uint8_t cores);
+void planner_print_report(struct pi_bounds bounds, uint8_t cores);
@@ -0,0 +1,36 @@
+#pragma once
+/********************************************************************************************* */
+//    Double buffered snapshots for one writer task and any number of readers
+//
+//    The writer fills the back buffer and then flips the version, readers copy the front buffer
+//    and retry if the version changed meanwhile. The buffer being written is never the one readers
+//    copy, so a reader never waits for a preempted writer and the writer never waits at all.
+/********************************************************************************************* */
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef struct {
+    volatile uint32_t version;      // number of published snapshots, buffer (version & 1) is the front
+} snapshot_sync;
+
+static inline void *snapshot_begin_write(snapshot_sync *sync, void *buffers, size_t size) {
+    // the flip of the previous write has to be visible before the back buffer is touched again
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return (uint8_t *)buffers + ((sync->version + 1) & 1) * size;
+}
+
+static inline void snapshot_end_write(snapshot_sync *sync) {
+    __atomic_store_n(&sync->version, sync->version + 1, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t snapshot_read(const snapshot_sync *sync, const void *buffers, size_t size, void *out) {
+    uint32_t before, after;
+    do {
+        before = __atomic_load_n(&sync->version, __ATOMIC_ACQUIRE);
+        memcpy(out, (const uint8_t *)buffers + (before & 1) * size, size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&sync->version, __ATOMIC_RELAXED);
+    } while (before != after);
+    return before;
+}